@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/* ------------------------------------------------------------------ */
+// Счётчик выделений кучи для отладочной сборки: глобальные operator new и
+// delete заменяются обёртками над malloc/free, которые считают вызовы.
+// Замена глобальная, поэтому заголовок подключается ровно в одну единицу
+// трансляции (в файл с main). В сборке с NDEBUG ничего не заменяется и
+// allocationCount() всегда 0.
+//
+//   const std::size_t before = allocationCount();
+//   ... код кадра ...
+//   if (allocationCount() != before) ...
+//
+// Выделения через malloc (ImGui, драйвер GL) не считаются.
+
+#ifndef NDEBUG
+
+std::atomic<std::size_t> g_allocationCount{ 0 };
+
+std::size_t allocationCount() {
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+void* countedAllocate(std::size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    while (true) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocate(size); }
+    catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocate(size); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#else
+
+std::size_t allocationCount() { return 0; }
+
+#endif
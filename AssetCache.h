@@ -0,0 +1,135 @@
+#pragma once
+#include "Utils.h"
+#include "MeshCache.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Общие ресурсы GPU: меш грузится и загружается на GPU один раз на путь,
+// программа линкуется один раз на пару исходников. Объекты сцены держат
+// handle'ы (shared_ptr); когда уходит последний, буферы или программа
+// удаляются, а кэш помнит только weak_ptr и при следующем запросе грузит
+// заново. Handle'ы должны умереть раньше контекста GL.
+
+// Программа вместе с её таблицей uniform'ов
+struct ShaderProgram {
+    GLuint id = 0;
+    UniformTable uniforms;
+};
+
+using MeshHandle = std::shared_ptr<const Mesh>;
+using ProgramHandle = std::shared_ptr<const ShaderProgram>;
+
+// Параметры загрузки меша — часть ключа кэша: один OBJ с оптимизацией и
+// без — разные меши
+struct MeshLoadOptions {
+    bool optimize = false;   // optimizeMesh (см. loadOBJCached)
+    bool quantize = false;   // Mesh::quantize
+    bool keepOnCPU = false;  // вершины и индексы остаются в памяти после загрузки
+                             // на GPU (загораживатели OcclusionBuffer)
+};
+
+class AssetCache {
+public:
+    // createProgram — сборка программы из исходников (в каждой лабе своя)
+    explicit AssetCache(GLuint (*createProgram)(const char*, const char*))
+        : createProgram(createProgram) {}
+
+    // Меш по пути; nullptr, если не загрузился (неудачи не кэшируются)
+    MeshHandle mesh(const std::string& path, MeshLoadOptions options = MeshLoadOptions()) {
+        std::error_code ec;
+        std::string key = std::filesystem::weakly_canonical(path, ec).string();
+        if (ec) key = path;
+        key += options.optimize ? "|o" : "|-";
+        key += options.quantize ? "q" : "-";
+        key += options.keepOnCPU ? "k" : "-";
+
+        auto it = meshes.find(key);
+        if (it != meshes.end()) {
+            if (MeshHandle handle = it->second.lock()) {
+                ++meshHits;
+                return handle;
+            }
+        }
+
+        std::unique_ptr<Mesh> mesh(new Mesh());
+        if (!loadOBJCached(path, *mesh, 1, options.optimize)) return nullptr;
+        mesh->quantize = options.quantize;
+        // uploadToGPU отпускает отображение кэша, векторы же остаются
+        if (options.keepOnCPU) mesh->copyMappedToVectors();
+        mesh->uploadToGPU();
+        ++meshLoads;
+
+        MeshHandle handle(std::shared_ptr<Mesh>(mesh.release(), [](Mesh* m) {
+            m->cleanup();
+            delete m;
+        }));
+        meshes[key] = handle;
+        return handle;
+    }
+
+    // Программа по исходникам. Если не собралась — handle с id 0 и пустой
+    // таблицей uniform'ов (как и 0 от createProgram), в кэш не попадает. Ключ — хеш
+    // обоих исходников, сами исходники сверяются, так что совпадение
+    // хешей даёт лишь отдельную программу, а не чужую.
+    ProgramHandle program(const char* vertexSrc, const char* fragmentSrc) {
+        const std::string vertex(vertexSrc), fragment(fragmentSrc);
+        std::uint64_t key = hashBytes(vertex.data(), vertex.size());
+        key ^= hashBytes(fragment.data(), fragment.size()) * 1099511628211ull;
+
+        ProgramEntry& entry = programs[key];
+        if (ProgramHandle handle = entry.program.lock()) {
+            if (entry.vertexSrc == vertex && entry.fragmentSrc == fragment) {
+                ++programHits;
+                return handle;
+            }
+            std::cerr << "Shader source hash collision, program is not shared\n";
+            return link(vertexSrc, fragmentSrc);
+        }
+
+        ProgramHandle handle = link(vertexSrc, fragmentSrc);
+        if (handle->id == 0) return handle;
+        entry.vertexSrc = vertex;
+        entry.fragmentSrc = fragment;
+        entry.program = handle;
+        return handle;
+    }
+
+    // Сколько запросов отдано из кэша и сколько ресурсов создано
+    void printReport() const {
+        std::cout << "Assets: meshes " << meshLoads << " loaded, " << meshHits << " shared; programs "
+                  << programLinks << " linked, " << programHits << " shared" << std::endl;
+    }
+
+private:
+    struct ProgramEntry {
+        std::string vertexSrc;
+        std::string fragmentSrc;
+        std::weak_ptr<const ShaderProgram> program;
+    };
+
+    ProgramHandle link(const char* vertexSrc, const char* fragmentSrc) {
+        const GLuint id = createProgram(vertexSrc, fragmentSrc);
+        if (id == 0) return std::make_shared<const ShaderProgram>();
+        ++programLinks;
+        ShaderProgram* program = new ShaderProgram();
+        program->id = id;
+        program->uniforms.reflect(id);
+        return ProgramHandle(program, [](const ShaderProgram* p) {
+            glDeleteProgram(p->id);
+            delete p;
+        });
+    }
+
+    GLuint (*createProgram)(const char*, const char*);
+    std::unordered_map<std::string, std::weak_ptr<const Mesh>> meshes;
+    std::unordered_map<std::uint64_t, ProgramEntry> programs;
+
+    std::size_t meshLoads = 0, meshHits = 0;
+    std::size_t programLinks = 0, programHits = 0;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <gl/glew.h>
+#include <vector>
+#include <cstddef>
+#include <iostream>
+
+/* ------------------------------------------------------------------ */
+// Кольцевой буфер данных кадра (матрицы, материалы, источники света).
+// Данные пишутся прямо в память буфера и привязываются по смещению
+// (атрибуты экземпляров, glBindBufferRange).
+//
+// GL 4.4 / ARB_buffer_storage: буфер из FRAME_RING_SECTIONS секций
+// отображается один раз (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT).
+// Кадр пишет в свою секцию, в конце кадра на неё ставится fence; перед
+// повторной записью в ту же секцию (через три кадра) fence ожидается —
+// обычно он давно сработал, и CPU не ждёт GPU.
+//
+// GL 3.3 (lab14 создаёт такой контекст): данные кадра копятся в памяти
+// процесса, flush пересоздаёт хранилище glBufferData(nullptr) — драйвер
+// отдаёт новую память, не дожидаясь GPU — и загружает их glBufferSubData.
+//
+// Кадр: beginFrame, allocate..., flush, вызовы отрисовки, endFrame.
+// GL-ресурсы освобождает destroy, пока жив контекст.
+
+const int FRAME_RING_SECTIONS = 3;
+
+struct RingAllocation {
+    std::size_t offset = 0;   // смещение от начала буфера
+    void* data = nullptr;     // куда писать; nullptr — секция кончилась
+};
+
+class FrameRingBuffer {
+public:
+    // target — GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER...; frameBytes — сколько
+    // данных помещается в один кадр
+    void create(GLenum target, std::size_t frameBytes) {
+        destroy();
+        this->target = target;
+        // начало секции годится для любого смещения glBindBufferRange
+        GLint uniformAlignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        offsetAlignment = static_cast<std::size_t>(uniformAlignment > 0 ? uniformAlignment : 256);
+        sectionBytes = alignUp(frameBytes, offsetAlignment);
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(target, buffer);
+        persistentMapping = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+        if (persistentMapping) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            const GLsizeiptr total = static_cast<GLsizeiptr>(sectionBytes * FRAME_RING_SECTIONS);
+            glBufferStorage(target, total, nullptr, flags);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, total, flags));
+            if (!mapped) {
+                std::cerr << "Frame ring buffer: persistent mapping failed, using orphaning\n";
+                glBindBuffer(target, 0);
+                glDeleteBuffers(1, &buffer);
+                glGenBuffers(1, &buffer);
+                glBindBuffer(target, buffer);
+                persistentMapping = false;
+            }
+        }
+        if (!persistentMapping) {
+            glBufferData(target, static_cast<GLsizeiptr>(sectionBytes), nullptr, GL_STREAM_DRAW);
+            staging.resize(sectionBytes);
+        }
+        glBindBuffer(target, 0);
+        section = FRAME_RING_SECTIONS - 1;
+        cursor = end = 0;
+    }
+
+    // Следующая секция; ждём, если GPU ещё читает её с прошлого круга
+    void beginFrame() {
+        if (persistentMapping) {
+            section = (section + 1) % FRAME_RING_SECTIONS;
+            GLsync& fence = fences[section];
+            if (fence) {
+                GLenum state = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                while (state == GL_TIMEOUT_EXPIRED)
+                    state = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);   // 1 мс
+                if (state != GL_ALREADY_SIGNALED) ++stalls;
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+            cursor = section * sectionBytes;
+        }
+        else {
+            cursor = 0;
+        }
+        end = cursor + sectionBytes;
+    }
+
+    // size байт кадра с началом, кратным alignment (степень двойки)
+    RingAllocation allocate(std::size_t size, std::size_t alignment = 16) {
+        RingAllocation a;
+        const std::size_t offset = alignUp(cursor, alignment);
+        if (offset + size > end) return a;
+        a.offset = offset;
+        a.data = persistentMapping ? mapped + offset : staging.data() + offset;
+        cursor = offset + size;
+        return a;
+    }
+
+    // Записанное за кадр видно GPU (в постоянном отображении — уже и так)
+    void flush() {
+        if (persistentMapping) return;
+        glBindBuffer(target, buffer);
+        glBufferData(target, static_cast<GLsizeiptr>(sectionBytes), nullptr, GL_STREAM_DRAW);
+        if (cursor) glBufferSubData(target, 0, static_cast<GLsizeiptr>(cursor), staging.data());
+        glBindBuffer(target, 0);
+    }
+
+    // После всех вызовов отрисовки, читающих кадр
+    void endFrame() {
+        if (!persistentMapping) return;
+        if (fences[section]) glDeleteSync(fences[section]);
+        fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void destroy() {
+        for (GLsync& fence : fences) {
+            if (fence) {
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+                glDeleteSync(fence);
+            }
+            fence = nullptr;
+        }
+        if (buffer) {
+            if (mapped) {
+                glBindBuffer(target, buffer);
+                glUnmapBuffer(target);
+                glBindBuffer(target, 0);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = 0;
+        mapped = nullptr;
+        staging.clear();
+        sectionBytes = cursor = end = 0;
+    }
+
+    GLuint id() const { return buffer; }
+    bool persistent() const { return persistentMapping; }
+    std::size_t frameCapacity() const { return sectionBytes; }
+    // Выравнивание смещений для glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+    std::size_t uniformOffsetAlignment() const { return offsetAlignment; }
+    unsigned long stallCount() const { return stalls; }   // сколько раз CPU ждал fence
+
+private:
+    static std::size_t alignUp(std::size_t value, std::size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    GLenum target = GL_ARRAY_BUFFER;
+    GLuint buffer = 0;
+    bool persistentMapping = false;
+    unsigned char* mapped = nullptr;
+    std::vector<unsigned char> staging;
+    GLsync fences[FRAME_RING_SECTIONS] = {};
+    std::size_t sectionBytes = 0;
+    std::size_t offsetAlignment = 256;
+    int section = 0;
+    std::size_t cursor = 0, end = 0;
+    unsigned long stalls = 0;
+};
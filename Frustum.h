@@ -0,0 +1,153 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULL_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_LANES 4
+#else
+#define FRUSTUM_CULL_LANES 1
+#endif
+
+/* ------------------------------------------------------------------ */
+// Пирамида видимости из матрицы clip = m * p (Gribb, Hartmann).
+// Для m = projection * view плоскости в мировых координатах, для
+// projection * view * model — в координатах модели, тогда объекты
+// модели проверяются без перевода в мир.
+// Плоскости нормированы и смотрят внутрь: dot(n, p) + d >= 0 внутри.
+struct Frustum {
+    glm::vec4 planes[6];   // left, right, bottom, top, near, far
+};
+
+Frustum extractFrustum(const glm::mat4& m) {
+    // строка i матрицы (glm хранит столбцы)
+    auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+    Frustum f;
+    f.planes[0] = r3 + r0;
+    f.planes[1] = r3 - r0;
+    f.planes[2] = r3 + r1;
+    f.planes[3] = r3 - r1;
+    f.planes[4] = r3 + r2;
+    f.planes[5] = r3 - r2;
+    for (glm::vec4& p : f.planes) {
+        float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (length > 0.0f) p = p * (1.0f / length);
+    }
+    return f;
+}
+
+// Сфера хотя бы частично внутри пирамиды (консервативно:
+// сферы у рёбер пирамиды могут пройти, будучи снаружи)
+bool sphereInFrustum(const Frustum& f, const glm::vec3& center, float radius) {
+    for (const glm::vec4& p : f.planes)
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) return false;
+    return true;
+}
+
+const std::uint32_t FRUSTUM_ALL_PLANES = 0x3F;
+
+// Коробка [min, max] против плоскостей из маски planes (бит i — planes[i]):
+// false — целиком снаружи одной из них. Плоскости, внутри которых коробка
+// целиком, снимаются с маски — вложенным коробкам (узлам дерева) их уже
+// не проверять.
+bool boxInFrustum(const Frustum& f, const glm::vec3& min, const glm::vec3& max, std::uint32_t& planes) {
+    for (int i = 0; i < 6; ++i) {
+        if (!(planes & (1u << i))) continue;
+        const glm::vec4& p = f.planes[i];
+        // дальняя по нормали вершина снаружи — вся коробка снаружи;
+        // ближняя внутри — коробка целиком по эту сторону
+        const glm::vec3 positive(p.x >= 0.0f ? max.x : min.x, p.y >= 0.0f ? max.y : min.y, p.z >= 0.0f ? max.z : min.z);
+        const glm::vec3 negative(p.x >= 0.0f ? min.x : max.x, p.y >= 0.0f ? min.y : max.y, p.z >= 0.0f ? min.z : max.z);
+        if (p.x * positive.x + p.y * positive.y + p.z * positive.z + p.w < 0.0f) return false;
+        if (p.x * negative.x + p.y * negative.y + p.z * negative.z + p.w >= 0.0f) planes &= ~(1u << i);
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+// Отсечение объектов кадра: ограничивающие сферы в мировых координатах
+// лежат структурой массивов, cullSpheres проверяет 8 (AVX) или 4 (SSE)
+// сферы за раз против каждой плоскости. Ответ тот же, что у
+// sphereInFrustum по одной сфере.
+struct BoundingSpheres {
+    std::vector<float> x, y, z, radius;
+
+    void clear() { x.clear(); y.clear(); z.clear(); radius.clear(); }
+    void reserve(std::size_t n) { x.reserve(n); y.reserve(n); z.reserve(n); radius.reserve(n); }
+    void push(const glm::vec3& center, float r) {
+        x.push_back(center.x); y.push_back(center.y); z.push_back(center.z); radius.push_back(r);
+    }
+    std::size_t size() const { return x.size(); }
+};
+
+struct FrustumCullStats {
+    std::size_t tested = 0;
+    std::size_t visible = 0;
+    std::size_t culled = 0;
+};
+
+// Номера сфер, хотя бы частично попавших в пирамиду, дописываются в
+// visible по возрастанию; статистика накапливается в stats
+void cullSpheres(const Frustum& f, const BoundingSpheres& spheres, std::vector<std::uint32_t>& visible,
+                 FrustumCullStats* stats = nullptr) {
+    const std::size_t count = spheres.size();
+    const std::size_t visibleBefore = visible.size();
+    std::size_t i = 0;
+#if FRUSTUM_CULL_LANES == 8
+    for (; i + 8 <= count; i += 8) {
+        const __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+        const __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+        const __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+        const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const glm::vec4& p : f.planes) {
+            __m256 d = _mm256_mul_ps(x, _mm256_set1_ps(p.x));
+            d = _mm256_add_ps(d, _mm256_mul_ps(y, _mm256_set1_ps(p.y)));
+            d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(p.z)));
+            d = _mm256_add_ps(d, _mm256_set1_ps(p.w));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+        }
+        const int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; ++lane)
+            if (mask & (1 << lane)) visible.push_back(static_cast<std::uint32_t>(i + lane));
+    }
+#elif FRUSTUM_CULL_LANES == 4
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(&spheres.x[i]);
+        const __m128 y = _mm_loadu_ps(&spheres.y[i]);
+        const __m128 z = _mm_loadu_ps(&spheres.z[i]);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4& p : f.planes) {
+            __m128 d = _mm_mul_ps(x, _mm_set1_ps(p.x));
+            d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(p.y)));
+            d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(p.z)));
+            d = _mm_add_ps(d, _mm_set1_ps(p.w));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+        }
+        const int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane)
+            if (mask & (1 << lane)) visible.push_back(static_cast<std::uint32_t>(i + lane));
+    }
+#endif
+    // остаток (и всё без SSE) — по одной сфере
+    for (; i < count; ++i) {
+        const glm::vec3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+        if (sphereInFrustum(f, center, spheres.radius[i])) visible.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    if (stats) {
+        const std::size_t passed = visible.size() - visibleBefore;
+        stats->tested += count;
+        stats->visible += passed;
+        stats->culled += count - passed;
+    }
+}
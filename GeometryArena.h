@@ -0,0 +1,161 @@
+#pragma once
+#include "Utils.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+/* ------------------------------------------------------------------ */
+// Общий буфер геометрии: вершины и индексы всех мешей сцены лежат в одном
+// VBO и одном EBO под одним VAO. Меш в арене — диапазон индексов и смещение
+// вершин, так что сцену можно отправить одним glMultiDrawElementsIndirect
+// без смены VAO между объектами. Это отдельный путь отрисовки (GL 4.3),
+// обычные Mesh::draw и свои VAO у мешей остаются как были.
+//
+// Данные объекта (матрица модели, цвет) шейдер берёт из атрибутов
+// экземпляра (Instancing.h): baseInstance команды сдвигает их выборку на
+// диапазон пачки, так что те же шейдеры работают и здесь — без gl_DrawID,
+// которому нужен GL 4.6 или ARB_shader_draw_parameters.
+
+// Место меша в арене
+struct ArenaRange {
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLint baseVertex = 0;
+};
+
+// Команда glMultiDrawElementsIndirect, раскладка задана стандартом
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be 20 bytes");
+
+// glMultiDrawElementsIndirect и base instance — ядро GL 4.3
+bool multiDrawIndirectSupported() {
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+}
+
+class GeometryArena {
+public:
+    Mesh merged;   // все меши подряд; после upload — общий VAO
+
+    // Добавить меш (один раз на меш, повторный вызов вернёт тот же
+    // диапазон). Геометрия берётся из векторов меша, а если они пусты
+    // (меш из кэша отдал данные прямо на GPU) — читается из его буферов.
+    // Упакованные меши (Mesh::quantize) в арену не попадают.
+    bool add(const Mesh& mesh, ArenaRange& range) {
+        auto it = ranges.find(&mesh);
+        if (it != ranges.end()) {
+            range = it->second;
+            return true;
+        }
+        if (mesh.quantization.packed) {
+            std::cerr << "Geometry arena: quantized meshes are not supported\n";
+            return false;
+        }
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!mesh.vertices.empty() && !mesh.indices.empty()) {
+            vertices = mesh.vertices;
+            indices = mesh.indices;
+        }
+        else if (mesh.vbo != 0 && mesh.ebo != 0) {
+            GLint vertexBytes = 0;
+            glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+            glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+            vertices.resize(static_cast<std::size_t>(vertexBytes) / sizeof(Vertex));
+            glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            // EBO — состояние VAO, читаем через него
+            indices.resize(static_cast<std::size_t>(mesh.uploadedIndexCount));
+            glBindVertexArray(mesh.vao);
+            glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+            glBindVertexArray(0);
+        }
+        if (vertices.empty() || indices.empty()) return false;
+
+        range.firstIndex = static_cast<GLuint>(merged.indices.size());
+        range.indexCount = static_cast<GLuint>(indices.size());
+        range.baseVertex = static_cast<GLint>(merged.vertices.size());
+        merged.vertices.insert(merged.vertices.end(), vertices.begin(), vertices.end());
+        merged.indices.insert(merged.indices.end(), indices.begin(), indices.end());
+        ranges[&mesh] = range;
+        dirty = true;
+        return true;
+    }
+
+    // Диапазон меша или nullptr, если его нет в арене
+    const ArenaRange* find(const Mesh& mesh) const {
+        auto it = ranges.find(&mesh);
+        return it == ranges.end() ? nullptr : &it->second;
+    }
+
+    // Загрузить (или перезагрузить после новых add) общий буфер
+    void upload() {
+        if (!dirty) return;
+        merged.cleanup();
+        merged.uploadToGPU();
+        dirty = false;
+        std::cout << "Geometry arena: " << ranges.size() << " meshes, " << merged.vertices.size()
+                  << " vertices, " << merged.indices.size() << " indices" << std::endl;
+    }
+
+    void cleanup() {
+        merged.cleanup();
+        ranges.clear();
+        dirty = true;
+    }
+
+private:
+    std::unordered_map<const Mesh*, ArenaRange> ranges;
+    bool dirty = true;
+};
+
+/* ------------------------------------------------------------------ */
+// Буфер команд, собираемый на CPU каждый кадр
+class IndirectCommandBuffer {
+public:
+    std::vector<DrawElementsIndirectCommand> commands;
+
+    void clear() { commands.clear(); }
+
+    void add(const ArenaRange& range, std::size_t firstInstance, std::size_t instanceCount) {
+        commands.push_back({ range.indexCount, static_cast<GLuint>(instanceCount),
+                             range.firstIndex, range.baseVertex, static_cast<GLuint>(firstInstance) });
+    }
+
+    // Загрузить команды и оставить буфер привязанным к GL_DRAW_INDIRECT_BUFFER
+    void upload() {
+        if (buffer == 0) glGenBuffers(1, &buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        const std::size_t size = commands.size() * sizeof(DrawElementsIndirectCommand);
+        if (size > capacity) capacity = size;
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        if (size) glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands.data());
+    }
+
+    // Команды [first, first + count) одним вызовом; нужны привязанные
+    // буфер команд (upload) и VAO арены
+    void draw(std::size_t first, std::size_t count) const {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            (const void*)(first * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(count), 0);
+    }
+
+    void cleanup() {
+        if (buffer) glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        capacity = 0;
+    }
+
+private:
+    GLuint buffer = 0;
+    std::size_t capacity = 0;
+};
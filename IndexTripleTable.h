@@ -0,0 +1,150 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Таблица дедупликации вершин: ключ — тройка индексов OBJ (pos, tex, norm),
+// значение — индекс вершины.
+//
+// Число позиций известно до слияния, поэтому корзина ключа — сам индекс
+// позиции (heads[p]), а тройки с этой позицией — короткая цепочка. Соседние
+// позиции лежат рядом в heads, записи идут подряд в порядке вставки, и на
+// регулярных сетках обращения к памяти почти последовательные.
+//
+// Цепочка ограничена CHAIN_LIMIT записями: тройки сверх него (вершина с
+// сотнями граней вокруг — вершина конуса с плоским затенением, или много
+// троек без позиции) уходят во вторичную таблицу с открытой адресацией по
+// хешу всей тройки. Поиск поэтому не хуже O(CHAIN_LIMIT) при любой
+// валентности. Массив корзин выделяется один раз; записи лежат блоками по
+// BLOCK и никогда не копируются; вторичная таблица появляется только при
+// первом переполнении и удваивается по мере надобности.
+class IndexTripleTable {
+public:
+    static constexpr std::size_t CHAIN_LIMIT = 8;
+
+    IndexTripleTable() = default;
+    explicit IndexTripleTable(std::size_t positionCount) { reset(positionCount); }
+
+    // Пустая таблица под позиции [0, positionCount). Индексы вне диапазона
+    // (loadOBJ заменяет их на -1) делят одну общую корзину
+    void reset(std::size_t positionCount) {
+        heads.assign(positionCount + 1, END);
+        overflow.clear();
+        overflowCount = 0;
+        blocks.clear();
+        count = 0;
+    }
+
+    // Найти значение по ключу или вставить newValue.
+    // Возвращает значение из таблицы; inserted = true, если ключ новый.
+    unsigned int findOrInsert(int p, int t, int n, unsigned int newValue, bool& inserted) {
+        if (heads.empty()) reset(0);
+        const std::size_t outside = heads.size() - 1;
+        const std::size_t bucket = p >= 0 && static_cast<std::size_t>(p) < outside ? static_cast<std::size_t>(p) : outside;
+        const std::uint32_t head = heads[bucket];
+
+        std::size_t length = 0;
+        for (std::uint32_t e = head & ~SPILLED; e != END; ++length) {
+            const Entry& entry = at(e);
+            if (entry.t == t && entry.n == n && entry.p == p) {
+                inserted = false;
+                return entry.value;
+            }
+            e = entry.next;
+        }
+
+        if (head & SPILLED) {
+            for (std::size_t slot = hash(p, t, n) & (overflow.size() - 1);; slot = (slot + 1) & (overflow.size() - 1)) {
+                const std::uint32_t e = overflow[slot];
+                if (e == NONE) break;
+                const Entry& entry = at(e);
+                if (entry.t == t && entry.n == n && entry.p == p) {
+                    inserted = false;
+                    return entry.value;
+                }
+            }
+        }
+
+        if (count % BLOCK == 0) blocks.emplace_back(new Entry[BLOCK]);
+        const std::uint32_t e = static_cast<std::uint32_t>(count++);
+        inserted = true;
+        if (length < CHAIN_LIMIT) {
+            at(e) = Entry{ p, t, n, newValue, head & ~SPILLED };
+            heads[bucket] = e | (head & SPILLED);
+            return newValue;
+        }
+
+        // цепочка полна — во вторичную таблицу
+        at(e) = Entry{ p, t, n, newValue, NONE };
+        if ((overflowCount + 1) * 4 > overflow.size() * 3) growOverflow();
+        std::size_t slot = hash(p, t, n) & (overflow.size() - 1);
+        while (overflow[slot] != NONE) slot = (slot + 1) & (overflow.size() - 1);
+        overflow[slot] = e;
+        ++overflowCount;
+        heads[bucket] = head | SPILLED;
+        return newValue;
+    }
+
+    std::size_t size() const { return count; }
+    std::size_t spilled() const { return overflowCount; }   // записей во вторичной таблице
+    std::size_t memoryBytes() const {
+        return (heads.capacity() + overflow.capacity()) * sizeof(std::uint32_t) + blocks.size() * BLOCK * sizeof(Entry);
+    }
+    std::size_t allocationCount() const { return (heads.empty() ? 0 : 1) + (overflow.empty() ? 0 : 1) + blocks.size(); }
+
+    void clear() {
+        std::vector<std::uint32_t>().swap(heads);
+        std::vector<std::uint32_t>().swap(overflow);
+        overflowCount = 0;
+        blocks.clear();
+        count = 0;
+    }
+
+    // 64-битное перемешивание (fmix64 из MurmurHash3) упакованной тройки
+    static std::uint64_t hash(int p, int t, int n) {
+        std::uint64_t h = static_cast<std::uint32_t>(p) * 0x9E3779B97F4A7C15ull;
+        h ^= (static_cast<std::uint64_t>(static_cast<std::uint32_t>(t)) << 32) | static_cast<std::uint32_t>(n);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    struct Entry {
+        int p, t, n;
+        unsigned int value;
+        std::uint32_t next;   // следующая тройка той же корзины; NONE — запись вторичной таблицы
+    };
+
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr std::uint32_t END = 0x7FFFFFFFu;       // конец цепочки
+    static constexpr std::uint32_t SPILLED = 0x80000000u;   // в heads: у корзины есть записи во вторичной таблице
+    static constexpr std::size_t BLOCK = 16384;             // записей в блоке (320 КБ)
+
+    void growOverflow() {
+        std::vector<std::uint32_t> old(overflow.empty() ? 1024 : overflow.size() * 2, NONE);
+        old.swap(overflow);
+        const std::size_t mask = overflow.size() - 1;
+        for (std::uint32_t e : old) {
+            if (e == NONE) continue;
+            const Entry& entry = at(e);
+            std::size_t slot = hash(entry.p, entry.t, entry.n) & mask;
+            while (overflow[slot] != NONE) slot = (slot + 1) & mask;
+            overflow[slot] = e;
+        }
+    }
+
+    Entry& at(std::size_t i) { return blocks[i / BLOCK][i % BLOCK]; }
+    const Entry& at(std::size_t i) const { return blocks[i / BLOCK][i % BLOCK]; }
+
+    std::vector<std::uint32_t> heads;      // первая запись корзины позиции (| SPILLED)
+    std::vector<std::uint32_t> overflow;   // номера записей вторичной таблицы или NONE
+    std::size_t overflowCount = 0;
+    std::vector<std::unique_ptr<Entry[]>> blocks;
+    std::size_t count = 0;
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include "Utils.h"
+#include "RenderQueue.h"
+#include "FrameRingBuffer.h"
+#include <vector>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Инстансинг: объекты с общими мешем, программой и текстурой рисуются
+// одним glDrawElementsInstanced. Параметры экземпляров лежат подряд в
+// одном буфере; у каждой пачки свой диапазон, его начало задаётся
+// смещением атрибутов (glDrawElementsInstancedBaseInstance — только GL 4.2).
+//
+// Атрибуты экземпляра в вершинном шейдере:
+//   layout (location = 3) in mat4 aModel;   // занимает 3..6
+//   layout (location = 7) in vec4 aColor;
+//   layout (location = 8) in mat3 aNormalMatrix;   // занимает 8..10
+
+const GLuint INSTANCE_ATTRIB_MODEL = 3;
+const GLuint INSTANCE_ATTRIB_COLOR = 7;
+const GLuint INSTANCE_ATTRIB_NORMAL = 8;
+
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 color;       // параметр материала (цвет объекта), у шейдеров без цвета не используется
+    glm::vec4 normal[3];   // столбцы матрицы нормалей (Transform::normalMatrix), w не используется
+};
+
+// Пачка экземпляров одного состояния: диапазон в буфере экземпляров
+struct InstanceBatch {
+    std::size_t first;
+    std::size_t count;
+    std::size_t object;   // объект, чьи меш, программа и текстура у всей пачки
+};
+
+// Экземпляры кадра в кольцевом буфере (FrameRingBuffer.h): пишутся прямо
+// в память буфера, атрибуты смотрят на секцию текущего кадра
+class InstanceBuffer {
+public:
+    // Начало кадра: место под count экземпляров. Если кадр больше буфера,
+    // буфер пересоздаётся с запасом (это ждёт GPU, но бывает редко).
+    InstanceData* begin(std::size_t count) {
+        const std::size_t size = count * sizeof(InstanceData);
+        if (ring.id() == 0 || size > ring.frameCapacity())
+            ring.create(GL_ARRAY_BUFFER, size + size / 2 + sizeof(InstanceData));
+        ring.beginFrame();
+        RingAllocation a = ring.allocate(size, sizeof(glm::vec4));
+        frameOffset = a.offset;
+        return static_cast<InstanceData*>(a.data);
+    }
+
+    // Записанное видно GPU; до первого вызова отрисовки кадра
+    void flush() { ring.flush(); }
+
+    // После всех вызовов отрисовки кадра
+    void end() { ring.endFrame(); }
+
+    // Атрибуты экземпляра привязанного VAO — на экземпляры кадра с first.
+    // Смещение секции меняется каждый кадр, так что привязка — тоже.
+    void bindAttributes(std::size_t first) const {
+        glBindBuffer(GL_ARRAY_BUFFER, ring.id());
+        const std::size_t base = frameOffset + first * sizeof(InstanceData);
+        for (GLuint column = 0; column < 4; ++column) {
+            const GLuint location = INSTANCE_ATTRIB_MODEL + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                (void*)(base + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
+        }
+        glEnableVertexAttribArray(INSTANCE_ATTRIB_COLOR);
+        glVertexAttribPointer(INSTANCE_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(base + offsetof(InstanceData, color)));
+        glVertexAttribDivisor(INSTANCE_ATTRIB_COLOR, 1);
+        for (GLuint column = 0; column < 3; ++column) {
+            const GLuint location = INSTANCE_ATTRIB_NORMAL + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                (void*)(base + offsetof(InstanceData, normal) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Без инстансинга: массивы атрибутов экземпляра привязанного VAO
+    // выключаются (раз на привязку VAO), и шейдер читает текущие значения
+    // атрибутов — их задаёт setCurrent перед каждым объектом, как прежде
+    // uniform model. Буфер экземпляров при этом не нужен.
+    static void disableAttributes() {
+        for (GLuint column = 0; column < 4; ++column) glDisableVertexAttribArray(INSTANCE_ATTRIB_MODEL + column);
+        glDisableVertexAttribArray(INSTANCE_ATTRIB_COLOR);
+        for (GLuint column = 0; column < 3; ++column) glDisableVertexAttribArray(INSTANCE_ATTRIB_NORMAL + column);
+    }
+
+    static void setCurrent(const glm::mat4& model, const glm::vec4& color, const glm::mat3& normalMatrix) {
+        for (GLuint column = 0; column < 4; ++column) glVertexAttrib4fv(INSTANCE_ATTRIB_MODEL + column, &model[column][0]);
+        glVertexAttrib4fv(INSTANCE_ATTRIB_COLOR, &color[0]);
+        for (GLuint column = 0; column < 3; ++column) glVertexAttrib3fv(INSTANCE_ATTRIB_NORMAL + column, &normalMatrix[column][0]);
+    }
+
+    bool persistent() const { return ring.persistent(); }
+    void cleanup() { ring.destroy(); }
+
+private:
+    FrameRingBuffer ring;
+    std::size_t frameOffset = 0;
+};
+
+// Разбить отсортированную очередь на пачки: подряд идущие элементы, для
+// которых sameState(a, b) истинно, попадают в одну пачку. С batching =
+// false каждый объект — отдельная пачка из одного экземпляра (для
+// сравнения с обычной отрисовкой по объекту).
+template <class SameState>
+void buildInstanceBatches(const RenderQueue& queue, SameState sameState, bool batching,
+                          std::vector<InstanceBatch>& batches) {
+    batches.clear();
+    std::size_t position = 0;
+    for (const RenderItem& item : queue) {
+        if (batching && !batches.empty() && sameState(batches.back().object, item.index))
+            ++batches.back().count;
+        else
+            batches.push_back({ position, 1, item.index });
+        ++position;
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include "SceneBVH.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+/* ------------------------------------------------------------------ */
+// Свободное (loose) октодерево над мировыми коробками объектов — замена
+// SceneBVH для в основном неподвижных сцен. Узел — куб со стороной 2h,
+// но объекты в нём могут выступать ещё на h с каждой стороны (свободные
+// границы: центр ± 2h). Поэтому уровень объекта выбирается сразу по его
+// размеру (наибольшая полуось r <= h / CELL_TO_OBJECT), а ячейка — по
+// центру: вставка и перемещение — спуск от корня без перестройки дерева.
+//
+// Объекты узла — двусвязный список по номерам объектов, так что update
+// переносит объект между узлами за O(глубина). Опустевшие узлы остаются
+// (subtreeObjects == 0, обход их пропускает) и используются снова.
+//
+// queryFrustum обходит свободные границы узлов с маской плоскостей, как
+// SceneBVH: узел целиком в пирамиде отдаёт всё поддерево без проверок.
+// Объекты, не влезающие в корень (ушли за границы сцены), проверяются
+// отдельным списком.
+
+class LooseOctree {
+public:
+    static constexpr int MAX_DEPTH = 10;
+    // Объект опускается в ячейку, только если она больше его в столько раз
+    // (по полуоси). С 1 свободные границы ещё вмещают объект, но почти
+    // каждый объект получает свой узел; с 4 узлов в разы меньше, а лишних
+    // проверок объектов немного
+    static constexpr float CELL_TO_OBJECT = 4.0f;
+
+    // Корень по общей коробке объектов, затем вставка каждого
+    void build(const std::vector<BoundingBox>& objectBoxes) {
+        BoundingBox scene;
+        for (const BoundingBox& b : objectBoxes) scene.expand(b);
+        const glm::vec3 extent = scene.empty() ? glm::vec3(1.0f) : scene.max - scene.min;
+        const float half = std::max(0.5f * std::max(extent.x, std::max(extent.y, extent.z)), 1e-3f);
+
+        nodes.clear();
+        nodes.push_back(Node());
+        nodes[0].center = scene.empty() ? glm::vec3(0.0f) : scene.center();
+        nodes[0].halfSize = half;
+
+        const std::size_t count = objectBoxes.size();
+        boxes = objectBoxes;
+        nodeOf.assign(count, NONE);
+        next.assign(count, NONE);
+        prev.assign(count, NONE);
+        outside.clear();
+        for (std::uint32_t i = 0; i < count; ++i) link(i, target(boxes[i]));
+    }
+
+    // Новая коробка объекта; если он ушёл из своей ячейки — переносится
+    void update(std::uint32_t object, const BoundingBox& box) {
+        boxes[object] = box;
+        const std::uint32_t node = target(box);
+        if (node == nodeOf[object]) return;
+        unlink(object);
+        link(object, node);
+        ++relocations;
+    }
+
+    // Объекты, чьи коробки хотя бы частично в пирамиде (дописываются в out)
+    void queryFrustum(const Frustum& f, std::vector<std::uint32_t>& out, SpatialQueryStats* stats = nullptr) const {
+        for (std::uint32_t object : outside) {
+            std::uint32_t planes = FRUSTUM_ALL_PLANES;
+            if (stats) ++stats->objectsTested;
+            if (boxInFrustum(f, boxes[object].min, boxes[object].max, planes)) out.push_back(object);
+        }
+        if (nodes.empty() || nodes[0].subtreeObjects == 0) return;
+
+        std::uint32_t stack[8 * (MAX_DEPTH + 1)][2];   // узел, маска непроверенных плоскостей
+        int top = 0;
+        stack[top][0] = 0;
+        stack[top++][1] = FRUSTUM_ALL_PLANES;
+        while (top > 0) {
+            --top;
+            const Node& node = nodes[stack[top][0]];
+            std::uint32_t planes = stack[top][1];
+            if (stats) ++stats->nodesVisited;
+            const glm::vec3 loose(2.0f * node.halfSize);
+            if (!boxInFrustum(f, node.center - loose, node.center + loose, planes)) continue;
+
+            if (planes == 0) {
+                collect(stack[top][0], out, stats);
+                continue;
+            }
+            for (std::uint32_t object = node.firstObject; object != NONE; object = next[object]) {
+                std::uint32_t objectPlanes = planes;
+                if (stats) ++stats->objectsTested;
+                if (boxInFrustum(f, boxes[object].min, boxes[object].max, objectPlanes)) out.push_back(object);
+            }
+            for (std::uint32_t child : node.children) {
+                if (child == NONE || nodes[child].subtreeObjects == 0) continue;
+                stack[top][0] = child;
+                stack[top++][1] = planes;
+            }
+        }
+    }
+
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t objectCount() const { return boxes.size(); }
+    std::size_t relocationCount() const { return relocations; }   // переносов между узлами за всё время
+    // Память под узлы и данные объектов
+    std::size_t memoryBytes() const {
+        return nodes.capacity() * sizeof(Node) + boxes.capacity() * sizeof(BoundingBox) +
+               (nodeOf.capacity() + next.capacity() + prev.capacity() + outside.capacity()) * sizeof(std::uint32_t);
+    }
+
+private:
+    static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+    // узел для объектов вне свободных границ корня
+    static constexpr std::uint32_t OUTSIDE = NONE - 1;
+
+    struct Node {
+        glm::vec3 center = glm::vec3(0.0f);
+        float halfSize = 0.0f;                   // ячейка: center ± halfSize
+        std::uint32_t children[8] = { NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE };
+        std::uint32_t parent = NONE;
+        std::uint32_t firstObject = NONE;
+        std::uint32_t subtreeObjects = 0;        // объектов в узле и ниже
+    };
+
+    // Узел для коробки: уровень по размеру, ячейка по центру
+    std::uint32_t target(const BoundingBox& box) {
+        const glm::vec3 center = box.center();
+        const glm::vec3 half = (box.max - box.min) * 0.5f;
+        const float radius = std::max(half.x, std::max(half.y, half.z));
+        const Node& root = nodes[0];
+        const glm::vec3 offset = glm::abs(center - root.center);
+        if (std::max(offset.x, std::max(offset.y, offset.z)) + radius > 2.0f * root.halfSize) return OUTSIDE;
+        // центр вне ячейки корня — в ячейки детей не попасть, остаётся корень
+        if (std::max(offset.x, std::max(offset.y, offset.z)) > root.halfSize) return 0;
+
+        std::uint32_t node = 0;
+        for (int depth = 0; depth < MAX_DEPTH; ++depth) {
+            const float childHalf = nodes[node].halfSize * 0.5f;
+            if (radius * CELL_TO_OBJECT > childHalf) break;
+            const glm::vec3 c = nodes[node].center;
+            const int octant = (center.x >= c.x ? 1 : 0) | (center.y >= c.y ? 2 : 0) | (center.z >= c.z ? 4 : 0);
+            std::uint32_t child = nodes[node].children[octant];
+            if (child == NONE) {
+                child = static_cast<std::uint32_t>(nodes.size());
+                Node n;
+                n.halfSize = childHalf;
+                n.center = c + glm::vec3(octant & 1 ? childHalf : -childHalf,
+                                         octant & 2 ? childHalf : -childHalf,
+                                         octant & 4 ? childHalf : -childHalf);
+                n.parent = node;
+                nodes.push_back(n);   // ссылки на nodes ниже не держим
+                nodes[node].children[octant] = child;
+            }
+            node = child;
+        }
+        return node;
+    }
+
+    void link(std::uint32_t object, std::uint32_t node) {
+        nodeOf[object] = node;
+        if (node == OUTSIDE) {
+            outside.push_back(object);
+            return;
+        }
+        prev[object] = NONE;
+        next[object] = nodes[node].firstObject;
+        if (next[object] != NONE) prev[next[object]] = object;
+        nodes[node].firstObject = object;
+        for (std::uint32_t n = node; n != NONE; n = nodes[n].parent) ++nodes[n].subtreeObjects;
+    }
+
+    void unlink(std::uint32_t object) {
+        const std::uint32_t node = nodeOf[object];
+        if (node == OUTSIDE) {
+            outside.erase(std::find(outside.begin(), outside.end(), object));
+            return;
+        }
+        if (prev[object] != NONE) next[prev[object]] = next[object];
+        else nodes[node].firstObject = next[object];
+        if (next[object] != NONE) prev[next[object]] = prev[object];
+        for (std::uint32_t n = node; n != NONE; n = nodes[n].parent) --nodes[n].subtreeObjects;
+    }
+
+    // Все объекты поддерева без проверок
+    void collect(std::uint32_t root, std::vector<std::uint32_t>& out, SpatialQueryStats* stats) const {
+        std::uint32_t stack[8 * (MAX_DEPTH + 1)];
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (stats) ++stats->nodesVisited;
+            for (std::uint32_t object = node.firstObject; object != NONE; object = next[object]) out.push_back(object);
+            for (std::uint32_t child : node.children)
+                if (child != NONE && nodes[child].subtreeObjects != 0) stack[top++] = child;
+        }
+    }
+
+    std::vector<Node> nodes;
+    std::vector<BoundingBox> boxes;        // по номеру объекта
+    std::vector<std::uint32_t> nodeOf;     // узел объекта или OUTSIDE
+    std::vector<std::uint32_t> next, prev; // списки объектов узлов
+    std::vector<std::uint32_t> outside;
+    std::size_t relocations = 0;
+};
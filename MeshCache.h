@@ -0,0 +1,215 @@
+#pragma once
+#include "Utils.h"
+#include "MeshOptimizer.h"
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Бинарный кэш меша рядом с исходником: "model.obj" -> "model.obj.meshcache".
+//
+// Формат (little-endian, как в памяти):
+//   MeshCacheHeader (64 байта)
+//   Vertex   vertices[vertexCount]
+//   uint32   indices[indexCount]
+//
+// Кэш действителен, пока совпадают размер и время изменения OBJ.
+// Если время изменилось, а размер тот же (checkout, копирование),
+// сверяется хеш содержимого — тогда кэш тоже считается верным, и в его
+// заголовок записывается новое время, чтобы не хешировать OBJ каждый запуск.
+// Размер, время и хеш берутся до разбора: если OBJ меняют, пока он
+// разбирается, кэш окажется устаревшим и следующий запуск его пересоберёт.
+// Флаги в заголовке говорят, какой обработкой получен меш: кэш без
+// оптимизации не подходит для запроса с optimize = true, и наоборот.
+// Поэтому у каждого набора флагов свой файл ("model.obj.opt.meshcache"
+// для оптимизированного) — программы с разными флагами не затирают кэш
+// друг друга.
+
+const std::uint32_t MESH_CACHE_MAGIC = 0x4853454D;   // "MESH"
+const std::uint32_t MESH_CACHE_VERSION = 1;
+
+const std::uint64_t MESH_CACHE_FLAG_OPTIMIZED = 1;   // прошёл optimizeMesh
+
+struct MeshCacheHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t vertexSize;        // sizeof(Vertex) при записи
+    std::uint32_t indexSize;         // sizeof(unsigned int) при записи
+    std::uint64_t sourceSize;
+    std::int64_t  sourceMtime;
+    std::uint64_t sourceHash;        // FNV-1a 64 по байтам OBJ
+    std::uint64_t vertexCount;
+    std::uint64_t indexCount;
+    std::uint64_t flags;             // MESH_CACHE_FLAG_*, в старых кэшах 0
+};
+static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader must stay 64 bytes");
+
+std::string meshCachePath(const std::string& objPath, std::uint64_t flags = 0) {
+    return objPath + (flags & MESH_CACHE_FLAG_OPTIMIZED ? ".opt.meshcache" : ".meshcache");
+}
+
+// FNV-1a 64 бита
+std::uint64_t hashBytes(const char* data, std::size_t size) {
+    std::uint64_t h = 1469598103934665603ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool sourceStamp(const std::string& path, std::uint64_t& size, std::int64_t& mtime) {
+    std::error_code ec;
+    size = static_cast<std::uint64_t>(std::filesystem::file_size(path, ec));
+    if (ec) return false;
+    mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+/* ------------------------------------------------------------------ */
+// Записать кэш: во временный файл, затем переименовать,
+// чтобы параллельный запуск никогда не увидел недописанный кэш.
+// sourceSize/sourceMtime/sourceHash — снятые с OBJ до его разбора
+bool writeMeshCache(const std::string& objPath, const Mesh& mesh, std::uint64_t sourceSize,
+                    std::int64_t sourceMtime, std::uint64_t sourceHash, std::uint64_t flags = 0) {
+    MeshCacheHeader header{};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.indexSize = sizeof(unsigned int);
+    header.sourceSize = sourceSize;
+    header.sourceMtime = sourceMtime;
+    header.sourceHash = sourceHash;
+    header.vertexCount = mesh.vertexCount();
+    header.indexCount = mesh.indexCount();
+    header.flags = flags;
+
+    const std::string cachePath = meshCachePath(objPath, flags);
+    const std::string tmpPath = cachePath + ".tmp";
+
+    FILE* f = std::fopen(tmpPath.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && header.vertexCount)
+        ok = std::fwrite(mesh.vertexData(), sizeof(Vertex), header.vertexCount, f) == header.vertexCount;
+    if (ok && header.indexCount)
+        ok = std::fwrite(mesh.indexData(), sizeof(unsigned int), header.indexCount, f) == header.indexCount;
+    ok = (std::fclose(f) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmpPath, cachePath, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+// Переписать время OBJ в заголовке готового кэша (на месте, 8 байт)
+bool restampMeshCache(const std::string& cachePath, std::int64_t sourceMtime) {
+    FILE* f = std::fopen(cachePath.c_str(), "r+b");
+    if (!f) return false;
+    bool ok = std::fseek(f, offsetof(MeshCacheHeader, sourceMtime), SEEK_SET) == 0 &&
+              std::fwrite(&sourceMtime, sizeof(sourceMtime), 1, f) == 1;
+    return (std::fclose(f) == 0) && ok;
+}
+
+/* ------------------------------------------------------------------ */
+// Попробовать взять меш из кэша. При успехе outMesh ссылается на
+// отображение кэша, ничего не копируется и не разбирается.
+bool readMeshCache(const std::string& objPath, Mesh& outMesh, std::uint64_t flags = 0) {
+    std::uint64_t size;
+    std::int64_t mtime;
+    if (!sourceStamp(objPath, size, mtime)) return false;
+
+    const std::string cachePath = meshCachePath(objPath, flags);
+    auto cache = std::make_shared<MappedFile>();
+    if (!cache->open(cachePath) || cache->size() < sizeof(MeshCacheHeader))
+        return false;
+
+    MeshCacheHeader header;
+    std::memcpy(&header, cache->data(), sizeof(header));
+    if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION ||
+        header.vertexSize != sizeof(Vertex) || header.indexSize != sizeof(unsigned int) ||
+        header.flags != flags)
+        return false;
+
+    const std::uint64_t expected = sizeof(MeshCacheHeader) +
+        header.vertexCount * sizeof(Vertex) + header.indexCount * sizeof(unsigned int);
+    if (cache->size() != expected) return false;
+
+    if (header.sourceSize != size) return false;
+    if (header.sourceMtime != mtime) {
+        // время поменялось — сверяем содержимое
+        {
+            MappedFile source;
+            if (!source.open(objPath)) return false;
+            if (hashBytes(source.data(), source.size()) != header.sourceHash) return false;
+        }
+        // Содержимое то же — запоминаем новое время. Отображённый файл на
+        // Windows писать нельзя, поэтому кэш закрываем и после записи
+        // открываем заново, проверяя, что его никто не подменил
+        cache->close();
+        if (restampMeshCache(cachePath, mtime)) header.sourceMtime = mtime;
+        MeshCacheHeader reopened;
+        if (!cache->open(cachePath) || cache->size() != expected) return false;
+        std::memcpy(&reopened, cache->data(), sizeof(reopened));
+        if (std::memcmp(&reopened, &header, sizeof(header)) != 0) return false;
+    }
+
+    // Индексы идут прямо в uploadToGPU и оптимизаторы; битый или чужой
+    // кэш не должен дать индекс за пределами вершин
+    const char* base = cache->data() + sizeof(MeshCacheHeader);
+    const unsigned int* indices = reinterpret_cast<const unsigned int*>(base + header.vertexCount * sizeof(Vertex));
+    for (std::uint64_t i = 0; i < header.indexCount; ++i)
+        if (indices[i] >= header.vertexCount) return false;
+
+    outMesh.mappedVertices = reinterpret_cast<const Vertex*>(base);
+    outMesh.mappedIndices = indices;
+    outMesh.mappedVertexCount = static_cast<std::size_t>(header.vertexCount);
+    outMesh.mappedIndexCount = static_cast<std::size_t>(header.indexCount);
+    outMesh.mapping = std::move(cache);
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+// loadOBJ с кэшем: при первом запуске разбирает OBJ и пишет
+// "<path>.meshcache" ("<path>.opt.meshcache" с optimize), при следующих —
+// отображает кэш в память.
+// Меш из кэша хранит данные в отображении (vertices/indices пусты);
+// если они нужны на CPU, вызовите mesh.copyMappedToVectors().
+//
+// optimize = true прогоняет меш через optimizeMesh (MeshOptimizer.h)
+// перед записью кэша, так что оптимизация выполняется один раз.
+bool loadOBJCached(const std::string& path, Mesh& outMesh, unsigned threads = 1, bool optimize = false) {
+    const std::uint64_t flags = optimize ? MESH_CACHE_FLAG_OPTIMIZED : 0;
+    if (readMeshCache(path, outMesh, flags)) {
+        outMesh.computeBounds();   // в кэше только геометрия
+        return true;
+    }
+
+    // Отметка и хеш OBJ — до разбора, см. комментарий в начале файла
+    std::uint64_t sourceSize = 0, sourceHash = 0;
+    std::int64_t sourceMtime = 0;
+    bool stamped = sourceStamp(path, sourceSize, sourceMtime);
+    if (stamped) {
+        MappedFile source;
+        stamped = source.open(path) && source.size() == sourceSize;
+        if (stamped) sourceHash = hashBytes(source.data(), source.size());
+    }
+
+    if (!loadOBJ(path, outMesh, threads)) return false;
+
+    if (optimize) {
+        MeshOptimizeReport report = optimizeMesh(outMesh);
+        std::cout << path << ": ACMR " << report.before.acmr << " -> " << report.after.acmr
+                  << ", ATVR " << report.before.atvr << " -> " << report.after.atvr
+                  << ", overdraw " << report.overdrawBefore.overdraw << " -> " << report.overdrawAfter.overdraw << '\n';
+    }
+
+    if (stamped && !writeMeshCache(path, outMesh, sourceSize, sourceMtime, sourceHash, flags))
+        std::cerr << "Cannot write mesh cache for " << path << '\n';
+    return true;
+}
@@ -0,0 +1,436 @@
+#pragma once
+#include "Utils.h"
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+/* ------------------------------------------------------------------ */
+// Оптимизация индексированного меша под кэши GPU. Запускается после
+// loadOBJ (см. loadOBJCached(..., optimize = true)):
+//   1. optimizeVertexCache — переупорядочивает треугольники так, чтобы
+//      вершины повторно брались из post-transform кэша (алгоритм Форсайта);
+//   2. optimizeOverdraw — переставляет кластеры треугольников так, чтобы
+//      ближние к зрителю грани рисовались раньше (меньше перерисовки);
+//   3. optimizeVertexFetch — переставляет вершины в порядке первого
+//      использования, чтобы выборка из VBO шла почти подряд.
+// Геометрия не меняется: те же треугольники с той же ориентацией.
+
+// Метрики post-transform кэша, считаются без GPU моделью FIFO-кэша.
+//   ACMR — промахов на треугольник (0.5 — предел, 3 — кэша нет);
+//   ATVR — промахов на вершину (1 — каждая вершина обрабатывается раз).
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// Размер FIFO для отчёта: так ведут себя кэши большинства GPU,
+// на которых важна эта оптимизация
+const unsigned VERTEX_CACHE_ANALYZE_SIZE = 16;
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, std::size_t indexCount,
+                                    std::size_t vertexCount,
+                                    unsigned cacheSize = VERTEX_CACHE_ANALYZE_SIZE) {
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) return stats;
+
+    // время попадания вершины в FIFO; вершина в кэше, пока её не
+    // вытеснили cacheSize более поздних промахов
+    std::vector<std::size_t> timestamps(vertexCount, 0);
+    std::size_t time = cacheSize + 1;
+    std::size_t misses = 0, used = 0;
+    for (std::size_t i = 0; i < indexCount; ++i) {
+        unsigned int v = indices[i];
+        if (v >= vertexCount) continue;
+        if (timestamps[v] == 0) ++used;
+        if (time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            ++misses;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = used ? static_cast<float>(misses) / static_cast<float>(used) : 0.0f;
+    return stats;
+}
+
+/* ------------------------------------------------------------------ */
+// Оценки вершин по Форсайту ("Linear-Speed Vertex Cache Optimisation").
+// Модель кэша — LRU на VERTEX_CACHE_OPTIMIZE_SIZE вершин.
+const unsigned VERTEX_CACHE_OPTIMIZE_SIZE = 32;
+
+float forsythVertexScore(int cachePosition, unsigned remainingTriangles) {
+    if (remainingTriangles == 0) return -1.0f;   // вершина больше не нужна
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // вершины только что выданного треугольника: фиксированная оценка,
+            // иначе выгоднее всего было бы рисовать тот же треугольник снова
+            score = 0.75f;
+        }
+        else {
+            const float scale = 1.0f / (VERTEX_CACHE_OPTIMIZE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, 1.5f);
+        }
+    }
+    // вершины с малым числом оставшихся треугольников стоит добить первыми
+    score += 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+    return score;
+}
+
+// Переупорядочить треугольники в indices для post-transform кэша
+void optimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount) {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0) return;
+
+    // списки треугольников каждой вершины: offsets + плоский массив
+    std::vector<unsigned> liveCount(vertexCount, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; ++i) ++liveCount[indices[i]];
+
+    std::vector<std::size_t> adjacencyOffset(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+
+    std::vector<unsigned> adjacency(triangleCount * 3);
+    {
+        std::vector<std::size_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (std::size_t t = 0; t < triangleCount; ++t)
+            for (int k = 0; k < 3; ++k)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned>(t);
+    }
+
+    std::vector<float> vertexScore(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = forsythVertexScore(-1, liveCount[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+                           vertexScore[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+
+    // LRU-кэш; +3 места под вершины, вытесненные последним треугольником,
+    // — их оценки тоже нужно пересчитать
+    std::vector<unsigned> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_OPTIMIZE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_OPTIMIZE_SIZE + 3);
+
+    std::size_t inputCursor = 0;   // для тупиков: следующий невыданный по исходному порядку
+    long long bestTriangle = 0;
+
+    for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestTriangle < 0) {
+            // в кэше не осталось вершин с живыми треугольниками —
+            // продолжаем с исходного порядка, он тоже обычно локален
+            while (emitted[inputCursor]) ++inputCursor;
+            bestTriangle = static_cast<long long>(inputCursor);
+        }
+
+        const std::size_t t = static_cast<std::size_t>(bestTriangle);
+        emitted[t] = true;
+        const unsigned tri[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+        result.insert(result.end(), tri, tri + 3);
+
+        // убрать треугольник из списков его вершин
+        for (unsigned v : tri) {
+            unsigned* list = adjacency.data() + adjacencyOffset[v];
+            for (unsigned k = 0; k < liveCount[v]; ++k) {
+                if (list[k] == t) {
+                    list[k] = list[liveCount[v] - 1];
+                    --liveCount[v];
+                    break;
+                }
+            }
+        }
+
+        // вершины треугольника — в голову LRU
+        nextCache.assign(tri, tri + 3);
+        for (unsigned v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+        cache.swap(nextCache);
+
+        // пересчитать оценки вершин кэша и их живых треугольников
+        for (std::size_t i = 0; i < cache.size(); ++i) {
+            unsigned v = cache[i];
+            int position = i < VERTEX_CACHE_OPTIMIZE_SIZE ? static_cast<int>(i) : -1;
+            float delta = forsythVertexScore(position, liveCount[v]) - vertexScore[v];
+            vertexScore[v] += delta;
+            const unsigned* list = adjacency.data() + adjacencyOffset[v];
+            for (unsigned k = 0; k < liveCount[v]; ++k) triangleScore[list[k]] += delta;
+        }
+
+        // лучший из треугольников, касающихся кэша
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (std::size_t i = 0; i < cache.size() && i < VERTEX_CACHE_OPTIMIZE_SIZE; ++i) {
+            unsigned v = cache[i];
+            const unsigned* list = adjacency.data() + adjacencyOffset[v];
+            for (unsigned k = 0; k < liveCount[v]; ++k) {
+                if (triangleScore[list[k]] > bestScore) {
+                    bestScore = triangleScore[list[k]];
+                    bestTriangle = list[k];
+                }
+            }
+        }
+
+        // выпавшие из кэша больше не отслеживаем
+        if (cache.size() > VERTEX_CACHE_OPTIMIZE_SIZE) cache.resize(VERTEX_CACHE_OPTIMIZE_SIZE);
+    }
+
+    indices.swap(result);
+}
+
+/* ------------------------------------------------------------------ */
+// Оценка перерисовки на CPU: меш растеризуется программно в порядке
+// индексов с тестом глубины LESS и отсечением задних граней (как в
+// lab14_2 и lab14/main.cpp) с нескольких направлений на сфере.
+//   overdraw — запусков фрагментного шейдера на закрытый пиксель
+//   (1 — каждый пиксель затенён ровно раз).
+struct OverdrawStats {
+    float overdraw = 0.0f;
+    std::size_t covered = 0;   // пикселей, закрытых мешем, по всем видам
+    std::size_t shaded = 0;    // фрагментов, прошедших тест глубины
+};
+
+const unsigned OVERDRAW_VIEW_COUNT = 16;
+const int OVERDRAW_RESOLUTION = 128;
+
+// Направление number из count, равномерно по сфере (спираль Фибоначчи)
+glm::vec3 sphereDirection(unsigned number, unsigned count) {
+    const float goldenAngle = 2.39996323f;
+    float z = 1.0f - (2.0f * number + 1.0f) / count;
+    float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+    float phi = goldenAngle * number;
+    return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+OverdrawStats analyzeOverdraw(const Vertex* vertices, std::size_t vertexCount,
+                              const unsigned int* indices, std::size_t indexCount,
+                              unsigned viewCount = OVERDRAW_VIEW_COUNT,
+                              int resolution = OVERDRAW_RESOLUTION) {
+    OverdrawStats stats;
+    if (indexCount < 3 || vertexCount == 0) return stats;
+
+    glm::vec3 lo = vertices[0].position, hi = lo;
+    for (std::size_t v = 1; v < vertexCount; ++v) {
+        lo = glm::min(lo, vertices[v].position);
+        hi = glm::max(hi, vertices[v].position);
+    }
+    const glm::vec3 center = (lo + hi) * 0.5f;
+    const float radius = std::max(glm::length(hi - lo) * 0.5f, 1e-6f);
+    const float scale = resolution * 0.5f / radius;
+
+    std::vector<float> depth(static_cast<std::size_t>(resolution) * resolution);
+    std::vector<glm::vec3> projected(vertexCount);
+
+    for (unsigned view = 0; view < viewCount; ++view) {
+        // камера в направлении dir смотрит на центр; right x up = dir,
+        // поэтому обход против часовой на экране — лицевая грань
+        const glm::vec3 dir = sphereDirection(view, viewCount);
+        const glm::vec3 helper = std::fabs(dir.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        const glm::vec3 right = glm::normalize(glm::cross(helper, dir));
+        const glm::vec3 up = glm::cross(dir, right);
+
+        for (std::size_t v = 0; v < vertexCount; ++v) {
+            glm::vec3 p = vertices[v].position - center;
+            projected[v] = glm::vec3(glm::dot(p, right) * scale + resolution * 0.5f,
+                                     glm::dot(p, up) * scale + resolution * 0.5f,
+                                     -glm::dot(p, dir));
+        }
+        std::fill(depth.begin(), depth.end(), 3.4e38f);
+
+        for (std::size_t i = 0; i + 2 < indexCount; i += 3) {
+            const glm::vec3& a = projected[indices[i]];
+            const glm::vec3& b = projected[indices[i + 1]];
+            const glm::vec3& c = projected[indices[i + 2]];
+            const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area <= 0.0f) continue;   // задняя или вырожденная грань
+
+            const int x0 = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+            const int x1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+            const int y0 = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+            const int y1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    const float px = x + 0.5f, py = y + 0.5f;
+                    // барицентрические веса; на общем ребре пиксель достаётся
+                    // одному из двух треугольников (правило верхнего левого
+                    // ребра упрощено до строгого неравенства с одной стороны)
+                    const float w0 = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+                    const float w1 = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+                    const float w2 = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 <= 0.0f) continue;
+
+                    const float z = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+                    float& stored = depth[static_cast<std::size_t>(y) * resolution + x];
+                    if (z < stored) {
+                        if (stored == 3.4e38f) ++stats.covered;
+                        stored = z;
+                        ++stats.shaded;
+                    }
+                }
+            }
+        }
+    }
+
+    stats.overdraw = stats.covered ? static_cast<float>(stats.shaded) / stats.covered : 0.0f;
+    return stats;
+}
+
+/* ------------------------------------------------------------------ */
+// Порядок против перерисовки (Sander, Nehab, Barczak, "Fast Triangle
+// Reordering for Vertex Locality and Reduced Overdraw"). Запускается после
+// optimizeVertexCache:
+//   1. буфер индексов режется на кластеры там, где разрыв почти не
+//      стоит кэшу: ACMR кластера, начатого с пустого кэша, не хуже
+//      threshold * ACMR исходного порядка;
+//   2. кластеры сортируются по dot(центр кластера - центр меша, нормаль
+//      кластера) по убыванию. Это усреднённая по направлениям взгляда
+//      оценка «кластер загораживает другие»: внешние грани, смотрящие
+//      наружу, рисуются первыми и отсекают тестом глубины остальные.
+// threshold = 1.05 допускает потерю 5% ACMR ради меньшей перерисовки.
+//
+// Сортировка — эвристика и на части мешей ничего не даёт или даже
+// ухудшает результат. Поэтому новый порядок сверяется с исходным
+// (analyzeOverdraw и analyzeVertexCache) и остаётся, только если
+// перерисовка стала меньше, а ACMR не вышел за threshold * исходный.
+// Возвращает true, если порядок изменён.
+const float OVERDRAW_CACHE_THRESHOLD = 1.05f;
+
+bool optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+                      float threshold = OVERDRAW_CACHE_THRESHOLD) {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertices.empty()) return false;
+
+    const VertexCacheStats current = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    const float acmrLimit = current.acmr * threshold;
+
+    // границы кластеров: кэш моделируем заново с начала каждого кластера
+    std::vector<std::size_t> clusterStart;
+    {
+        std::vector<std::size_t> timestamps(vertices.size(), 0);
+        std::size_t time = VERTEX_CACHE_ANALYZE_SIZE + 1;
+        std::size_t start = 0, misses = 0;
+        clusterStart.push_back(0);
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                if (time - timestamps[v] > VERTEX_CACHE_ANALYZE_SIZE) {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+            const std::size_t length = t + 1 - start;
+            if (t + 1 < triangleCount && static_cast<float>(misses) <= acmrLimit * length) {
+                start = t + 1;
+                misses = 0;
+                time += VERTEX_CACHE_ANALYZE_SIZE + 1;   // сбросить кэш
+                clusterStart.push_back(start);
+            }
+        }
+    }
+    const std::size_t clusterCount = clusterStart.size();
+    clusterStart.push_back(triangleCount);
+
+    // центр меша и для каждого кластера центр и нормаль, взвешенные по площади
+    std::vector<glm::vec3> clusterCenter(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusterCount, 0.0f);
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    for (std::size_t c = 0; c < clusterCount; ++c) {
+        for (std::size_t t = clusterStart[c]; t < clusterStart[c + 1]; ++t) {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            const glm::vec3 n = glm::cross(b - a, d - a);   // длина = 2 * площадь
+            const float area = glm::length(n);
+            const glm::vec3 centroid = (a + b + d) * (area / 3.0f);
+            clusterCenter[c] += centroid;
+            clusterNormal[c] += n;
+            clusterArea[c] += area;
+            meshCenter += centroid;
+            meshArea += area;
+        }
+    }
+    if (meshArea > 0.0f) meshCenter /= meshArea;
+
+    std::vector<float> sortKey(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; ++c) {
+        if (clusterArea[c] <= 0.0f) { sortKey[c] = 0.0f; continue; }
+        const glm::vec3 center = clusterCenter[c] / clusterArea[c];
+        const float normalLength = glm::length(clusterNormal[c]);
+        sortKey[c] = normalLength > 0.0f ? glm::dot(center - meshCenter, clusterNormal[c] / normalLength) : 0.0f;
+    }
+
+    std::vector<std::size_t> order(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; ++c) order[c] = c;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t l, std::size_t r) { return sortKey[l] > sortKey[r]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (std::size_t c : order)
+        result.insert(result.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+
+    const VertexCacheStats reordered = analyzeVertexCache(result.data(), result.size(), vertices.size());
+    if (reordered.acmr > acmrLimit) return false;
+    const OverdrawStats overdrawBefore = analyzeOverdraw(vertices.data(), vertices.size(), indices.data(), indices.size());
+    const OverdrawStats overdrawAfter = analyzeOverdraw(vertices.data(), vertices.size(), result.data(), result.size());
+    if (overdrawAfter.overdraw >= overdrawBefore.overdraw) return false;
+
+    indices.swap(result);
+    return true;
+}
+
+// Переставить вершины в порядке первого использования в indices.
+// Неиспользуемые вершины уходят в конец буфера.
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    const unsigned int unassigned = 0xFFFFFFFFu;
+    std::vector<unsigned int> remap(vertices.size(), unassigned);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (unsigned int& index : indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+        if (remap[v] == unassigned) reordered.push_back(vertices[v]);
+
+    vertices.swap(reordered);
+}
+
+/* ------------------------------------------------------------------ */
+struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    OverdrawStats overdrawBefore;
+    OverdrawStats overdrawAfter;
+    bool overdrawApplied = false;   // optimizeOverdraw оставил свой порядок
+};
+
+// Полный проход для меша на CPU: кэш вершин, перерисовка, затем порядок
+// выборки. Меш из кэша (отображение файла) сначала копируется в векторы.
+MeshOptimizeReport optimizeMesh(Mesh& mesh, float overdrawThreshold = OVERDRAW_CACHE_THRESHOLD) {
+    mesh.copyMappedToVectors();
+
+    MeshOptimizeReport report;
+    report.before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    report.overdrawBefore = analyzeOverdraw(mesh.vertices.data(), mesh.vertices.size(),
+                                            mesh.indices.data(), mesh.indices.size());
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    report.overdrawApplied = optimizeOverdraw(mesh.indices, mesh.vertices, overdrawThreshold);
+    optimizeVertexFetch(mesh.vertices, mesh.indices);
+    report.after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    report.overdrawAfter = analyzeOverdraw(mesh.vertices.data(), mesh.vertices.size(),
+                                           mesh.indices.data(), mesh.indices.size());
+    return report;
+}
@@ -0,0 +1,264 @@
+#pragma once
+#include "Utils.h"
+#include "Frustum.h"
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+/* ------------------------------------------------------------------ */
+// Мешлеты: меш режется на кластеры до MESHLET_MAX_VERTICES вершин и
+// MESHLET_MAX_TRIANGLES треугольников. У каждого — ограничивающая сфера
+// и конус нормалей, поэтому целые кластеры отбрасываются на CPU до
+// отрисовки: вне пирамиды видимости или целиком задними гранями к камере.
+//
+// Кластер — непрерывный диапазон Mesh::indices: buildMeshlets переставляет
+// треугольники и вызывается до uploadToGPU. Внутри кластера порядок — порядок
+// роста, он и так локален для кэша вершин.
+
+const std::size_t MESHLET_MAX_VERTICES = 64;
+const std::size_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    unsigned int indexOffset;     // первый индекс в Mesh::indices
+    unsigned int triangleCount;
+    unsigned int vertexCount;     // уникальных вершин
+
+    glm::vec3 center;             // ограничивающая сфера
+    float radius;
+    // Конус нормалей: все грани смотрят от coneAxis не дальше, чем на
+    // угол с синусом coneCutoff. coneCutoff = 1 — конус не отсекает.
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+/* ------------------------------------------------------------------ */
+// Границы кластера по его треугольникам
+void computeMeshletBounds(Meshlet& m, const Vertex* vertices, const unsigned int* indices) {
+    const unsigned int* tri = indices + m.indexOffset;
+    const std::size_t count = static_cast<std::size_t>(m.triangleCount) * 3;
+
+    glm::vec3 lo = vertices[tri[0]].position, hi = lo;
+    for (std::size_t i = 1; i < count; ++i) {
+        lo = glm::min(lo, vertices[tri[i]].position);
+        hi = glm::max(hi, vertices[tri[i]].position);
+    }
+    m.center = (lo + hi) * 0.5f;
+    m.radius = 0.0f;
+    for (std::size_t i = 0; i < count; ++i)
+        m.radius = std::max(m.radius, glm::length(vertices[tri[i]].position - m.center));
+
+    // ось — средняя нормаль граней, раствор — по самой отклонённой
+    std::vector<glm::vec3> normals;
+    normals.reserve(m.triangleCount);
+    glm::vec3 axis(0.0f);
+    for (std::size_t i = 0; i < count; i += 3) {
+        const glm::vec3& a = vertices[tri[i]].position;
+        glm::vec3 n = glm::cross(vertices[tri[i + 1]].position - a, vertices[tri[i + 2]].position - a);
+        float length = glm::length(n);
+        if (length <= 0.0f) continue;   // вырожденные на видимость не влияют
+        normals.push_back(n / length);
+        axis += normals.back();
+    }
+
+    m.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    m.coneCutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength <= 0.0f) return;
+    m.coneAxis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3& n : normals) minDot = std::min(minDot, glm::dot(n, m.coneAxis));
+    // раствор больше ~84° — такой кластер почти никогда не отбросить
+    if (minDot <= 0.1f) return;
+    m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// Вес отклонения нормали при выборе следующего треугольника: чем больше,
+// тем уже конусы (больше отсекается), но тем менее круглые кластеры
+const float MESHLET_CONE_WEIGHT = 0.5f;
+
+// Нарезать меш на мешлеты. Кластер растёт от затравки по соседним
+// треугольникам: сначала те, что не добавляют вершин, затем ближние к
+// центру кластера и с нормалью ближе к его оси. Индексы меша
+// переставляются так, чтобы каждый мешлет был непрерывным диапазоном.
+std::vector<Meshlet> buildMeshlets(Mesh& mesh, float coneWeight = MESHLET_CONE_WEIGHT) {
+    mesh.copyMappedToVectors();
+    std::vector<Meshlet> meshlets;
+    const std::vector<Vertex>& vertices = mesh.vertices;
+    const std::vector<unsigned int>& indices = mesh.indices;
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return meshlets;
+
+    // центры и нормали треугольников
+    std::vector<glm::vec3> triCenter(triangleCount), triNormal(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        const glm::vec3& a = vertices[indices[t * 3]].position;
+        const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+        const glm::vec3& c = vertices[indices[t * 3 + 2]].position;
+        triCenter[t] = (a + b + c) / 3.0f;
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float length = glm::length(n);
+        triNormal[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+    }
+
+    // треугольники каждой вершины
+    std::vector<unsigned int> adjacencyOffset(vertices.size() + 1, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; ++i) ++adjacencyOffset[indices[i] + 1];
+    for (std::size_t v = 0; v < vertices.size(); ++v) adjacencyOffset[v + 1] += adjacencyOffset[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    {
+        std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i)
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    std::vector<unsigned int> lastMeshlet(vertices.size(), 0xFFFFFFFFu);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(triangleCount * 3);
+    std::vector<unsigned int> candidates;
+    std::size_t cursor = 0;   // затравка — первый свободный по исходному порядку
+
+    while (reordered.size() < triangleCount * 3) {
+        const unsigned int id = static_cast<unsigned int>(meshlets.size());
+        Meshlet current{};
+        current.indexOffset = static_cast<unsigned int>(reordered.size());
+        glm::vec3 centerSum(0.0f), normalSum(0.0f);
+        candidates.clear();
+
+        auto newVertices = [&](std::size_t t) {
+            unsigned int added = 0;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                bool seen = lastMeshlet[v] == id;
+                for (int j = 0; j < k && !seen; ++j) seen = indices[t * 3 + j] == v;
+                if (!seen) ++added;
+            }
+            return added;
+        };
+        auto add = [&](std::size_t t) {
+            current.vertexCount += newVertices(t);
+            ++current.triangleCount;
+            used[t] = true;
+            centerSum += triCenter[t];
+            normalSum += triNormal[t];
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                reordered.push_back(v);
+                if (lastMeshlet[v] == id) continue;
+                lastMeshlet[v] = id;
+                for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v + 1]; ++a)
+                    if (!used[adjacency[a]]) candidates.push_back(adjacency[a]);
+            }
+        };
+
+        while (used[cursor]) ++cursor;
+        add(cursor);
+
+        while (current.triangleCount < MESHLET_MAX_TRIANGLES) {
+            const glm::vec3 center = centerSum / static_cast<float>(current.triangleCount);
+            float axisLength = glm::length(normalSum);
+            const glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+
+            long long best = -1;
+            unsigned int bestAdded = 4;
+            float bestScore = 0.0f;
+            std::size_t write = 0;
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                unsigned int t = candidates[i];
+                if (used[t]) continue;
+                candidates[write++] = t;   // заодно выбрасываем использованные
+                unsigned int added = newVertices(t);
+                if (current.vertexCount + added > MESHLET_MAX_VERTICES || added > bestAdded) continue;
+                float score = glm::length(triCenter[t] - center) * (1.0f + coneWeight * (1.0f - glm::dot(triNormal[t], axis)));
+                if (added < bestAdded || score < bestScore) {
+                    best = t;
+                    bestAdded = added;
+                    bestScore = score;
+                }
+            }
+            candidates.resize(write);
+            if (best < 0) {
+                // соседей нет (отдельный кусок кончился) — берём следующий
+                // свободный по порядку, если влезает: иначе у «супа» из
+                // несвязных граней каждый мешлет был бы из одного треугольника
+                while (cursor < triangleCount && used[cursor]) ++cursor;
+                if (!candidates.empty() || cursor == triangleCount || current.vertexCount + newVertices(cursor) > MESHLET_MAX_VERTICES) break;
+                best = static_cast<long long>(cursor);
+            }
+            add(static_cast<std::size_t>(best));
+        }
+
+        computeMeshletBounds(current, vertices.data(), reordered.data());
+        meshlets.push_back(current);
+    }
+
+    mesh.indices.swap(reordered);
+    return meshlets;
+}
+
+/* ------------------------------------------------------------------ */
+// Диапазоны индексов для glMultiDrawElements; соседние видимые мешлеты
+// сливаются в один диапазон
+struct MeshletDrawRanges {
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+
+    void clear() { counts.clear(); offsets.clear(); }
+};
+
+struct MeshletCullStats {
+    std::size_t meshlets = 0;
+    std::size_t visibleMeshlets = 0;
+    std::size_t frustumCulled = 0;
+    std::size_t coneCulled = 0;
+    std::size_t triangles = 0;
+    std::size_t submittedTriangles = 0;
+};
+
+// Отсечь мешлеты объекта с матрицей model. Проверки идут в координатах
+// модели (для конуса масштаб модели должен быть равномерным).
+// Видимые диапазоны дописываются в out, статистика накапливается в stats.
+void cullMeshlets(const std::vector<Meshlet>& meshlets, const glm::mat4& model,
+                  const glm::mat4& viewProjection, const glm::vec3& cameraPos,
+                  MeshletDrawRanges& out, MeshletCullStats* stats = nullptr) {
+    const Frustum frustum = extractFrustum(viewProjection * model);
+    const glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+    std::size_t rangeEnd = 0;   // конец последнего диапазона в индексах
+    bool haveRange = false;
+    for (const Meshlet& m : meshlets) {
+        if (stats) {
+            ++stats->meshlets;
+            stats->triangles += m.triangleCount;
+        }
+
+        if (!sphereInFrustum(frustum, m.center, m.radius)) {
+            if (stats) ++stats->frustumCulled;
+            continue;
+        }
+        // все грани задние: камера за всеми плоскостями кластера
+        glm::vec3 toCenter = m.center - camera;
+        if (glm::dot(toCenter, m.coneAxis) >= m.coneCutoff * glm::length(toCenter) + m.radius) {
+            if (stats) ++stats->coneCulled;
+            continue;
+        }
+
+        if (stats) {
+            ++stats->visibleMeshlets;
+            stats->submittedTriangles += m.triangleCount;
+        }
+        const GLsizei count = static_cast<GLsizei>(m.triangleCount * 3);
+        if (haveRange && rangeEnd == m.indexOffset) {
+            out.counts.back() += count;
+        }
+        else {
+            out.counts.push_back(count);
+            out.offsets.push_back(reinterpret_cast<const void*>(
+                static_cast<std::size_t>(m.indexOffset) * sizeof(unsigned int)));
+            haveRange = true;
+        }
+        rangeEnd = m.indexOffset + static_cast<std::size_t>(count);
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Типы записей OBJ, которые нас интересуют
+enum ObjRecord {
+    OBJ_OTHER,      // пустая строка, комментарий, mtllib, usemtl, o, s ...
+    OBJ_POSITION,   // v
+    OBJ_TEXCOORD,   // vt
+    OBJ_NORMAL,     // vn
+    OBJ_FACE        // f
+};
+
+/* ------------------------------------------------------------------ */
+// Курсор по тексту OBJ, лежащему целиком в памяти (обычно MappedFile).
+// Никаких аллокаций и локалей: числа разбираются вручную,
+// строка никогда не копируется.
+struct ObjCursor {
+    const char* p = nullptr;
+    const char* end = nullptr;
+
+    ObjCursor() = default;
+    ObjCursor(const char* begin, const char* finish) : p(begin), end(finish) {}
+
+    bool eof() const { return p >= end; }
+
+    // пробелы и табы внутри строки ('\r' тоже — для файлов из Windows)
+    void skipSpaces() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    }
+
+    bool atLineEnd() const { return p >= end || *p == '\n'; }
+
+    // перейти на начало следующей строки
+    void nextLine() {
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+    }
+
+    // пропустить текущее слово (префикс записи или неизвестный токен)
+    void skipWord() {
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
+    }
+
+    // Прочитать префикс записи в начале строки; курсор встаёт сразу за ним
+    ObjRecord readRecord() {
+        skipSpaces();
+        if (atLineEnd() || *p == '#') return OBJ_OTHER;
+
+        const char* prefix = p;
+        skipWord();
+        const std::size_t len = static_cast<std::size_t>(p - prefix);
+
+        if (prefix[0] == 'v') {
+            if (len == 1) return OBJ_POSITION;
+            if (len == 2 && prefix[1] == 't') return OBJ_TEXCOORD;
+            if (len == 2 && prefix[1] == 'n') return OBJ_NORMAL;
+        }
+        else if (prefix[0] == 'f' && len == 1) return OBJ_FACE;
+        return OBJ_OTHER;
+    }
+
+    // Целое со знаком. Возвращает false, если цифр нет — курсор не двигается.
+    bool readInt(int& out) {
+        const char* s = p;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+')) negative = (*s++ == '-');
+        if (s >= end || *s < '0' || *s > '9') return false;
+
+        int value = 0;
+        while (s < end && *s >= '0' && *s <= '9')
+            value = value * 10 + (*s++ - '0');
+
+        out = negative ? -value : value;
+        p = s;
+        return true;
+    }
+
+    // Вещественное: [+-]digits[.digits][(e|E)[+-]digits].
+    // Мантисса набирается в uint64 (до 19 значащих цифр), затем
+    // одно умножение/деление на точную степень десяти в double.
+    bool readFloat(float& out) {
+        skipSpaces();
+        const char* s = p;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+')) negative = (*s++ == '-');
+
+        std::uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        bool any = false;
+
+        while (s < end && *s >= '0' && *s <= '9') {
+            if (digits < 19) { mantissa = mantissa * 10 + (*s - '0'); if (mantissa) ++digits; }
+            else ++exponent;                        // лишние цифры только сдвигают порядок
+            ++s; any = true;
+        }
+        if (s < end && *s == '.') {
+            ++s;
+            while (s < end && *s >= '0' && *s <= '9') {
+                if (digits < 19) { mantissa = mantissa * 10 + (*s - '0'); if (mantissa) ++digits; --exponent; }
+                ++s; any = true;
+            }
+        }
+        if (!any) return false;
+
+        if (s < end && (*s == 'e' || *s == 'E')) {
+            const char* e = s + 1;
+            bool expNegative = false;
+            if (e < end && (*e == '-' || *e == '+')) expNegative = (*e++ == '-');
+            if (e < end && *e >= '0' && *e <= '9') {
+                int expValue = 0;
+                while (e < end && *e >= '0' && *e <= '9') {
+                    if (expValue < 10000) expValue = expValue * 10 + (*e - '0');
+                    ++e;
+                }
+                exponent += expNegative ? -expValue : expValue;
+                s = e;
+            }
+        }
+
+        out = static_cast<float>(negative ? -scaleByPow10(mantissa, exponent)
+                                          : scaleByPow10(mantissa, exponent));
+        p = s;
+        return true;
+    }
+
+    // Вершина грани: v, v/vt, v//vn или v/vt/vn.
+    // Отсутствующие индексы возвращаются как 0 (в OBJ индексация с 1).
+    bool readFaceVertex(int& vi, int& ti, int& ni) {
+        skipSpaces();
+        vi = ti = ni = 0;
+        if (!readInt(vi)) return false;
+        if (p < end && *p == '/') {
+            ++p;
+            readInt(ti);                            // может отсутствовать: "v//vn"
+            if (p < end && *p == '/') {
+                ++p;
+                readInt(ni);
+            }
+        }
+        // хвост нераспознанного токена пропускаем целиком
+        skipWord();
+        return true;
+    }
+
+    static double scaleByPow10(std::uint64_t mantissa, int exponent) {
+        // 10^0..10^22 представимы в double точно
+        static const double pow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        double value = static_cast<double>(mantissa);
+        if (mantissa == 0) return 0.0;
+        while (exponent > 22) { value *= 1e22; exponent -= 22; }
+        while (exponent < -22) { value /= 1e22; exponent += 22; }
+        return exponent >= 0 ? value * pow10[exponent] : value / pow10[-exponent];
+    }
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OCCLUSION_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_LANES 4
+#else
+#define OCCLUSION_LANES 1
+#endif
+
+/* ------------------------------------------------------------------ */
+// Программное отсечение перекрытых объектов (Hi-Z) целиком на CPU.
+// Кадр: begin(projection * view), drawOccluder для крупных объектов-
+// загораживателей, buildPyramid, затем boxVisible для остальных.
+//
+// Глубина — z/w из [-1, 1] в [0, 1] (меньше — ближе), буфер малого
+// разрешения (по умолчанию 256x128). Треугольники режутся ближней
+// плоскостью и растеризуются функциями рёбер: 8 (AVX) или 4 (SSE)
+// пикселя строки за раз. Пирамида хранит на каждом уровне наибольшую
+// (дальнюю) глубину 2x2 текселей уровня ниже, так что коробку объекта
+// проверяет не больше 2x2 текселей: объект перекрыт, если его ближайшая
+// точка дальше самой дальней глубины загораживателей в его прямоугольнике.
+//
+// Ошибки только в сторону «видим»: коробка объекта на экране расширена на
+// пиксель, коробки у ближней плоскости и за краем экрана видимы всегда.
+class OcclusionBuffer {
+public:
+    explicit OcclusionBuffer(int width = 256, int height = 128) {
+        int w = width, h = height;
+        for (;;) {
+            Level level;
+            level.width = w;
+            level.height = h;
+            // строка уровня 0 кратна числу дорожек: запись блоком не выходит за строку
+            level.stride = levels.empty() ? (w + OCCLUSION_LANES - 1) / OCCLUSION_LANES * OCCLUSION_LANES : w;
+            level.depth.assign(static_cast<std::size_t>(level.stride) * h, 1.0f);
+            levels.push_back(std::move(level));
+            if (w == 1 && h == 1) break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+    }
+
+    // Новый кадр: глубина — дальняя плоскость
+    void begin(const glm::mat4& viewProjectionMatrix) {
+        viewProjection = viewProjectionMatrix;
+        std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+        trianglesDrawn = 0;
+    }
+
+    // Треугольники загораживателя с матрицей модели. positions — первая
+    // вершина, stride — шаг между вершинами в байтах (позиция в начале
+    // вершины, как у Vertex из Utils.h)
+    void drawOccluder(const glm::mat4& model, const void* positions, std::size_t stride, std::size_t vertexCount,
+                      const std::uint32_t* indices, std::size_t indexCount) {
+        const glm::mat4 m = viewProjection * model;
+        clipVertices.resize(vertexCount);
+        const unsigned char* p = static_cast<const unsigned char*>(positions);
+        for (std::size_t i = 0; i < vertexCount; ++i, p += stride) {
+            const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(p);
+            clipVertices[i] = m * glm::vec4(position, 1.0f);
+        }
+        for (std::size_t i = 0; i + 2 < indexCount; i += 3)
+            clipTriangle(clipVertices[indices[i]], clipVertices[indices[i + 1]], clipVertices[indices[i + 2]]);
+    }
+
+    // Уровни 1.. — наибольшая глубина 2x2 текселей уровня ниже
+    void buildPyramid() {
+        for (std::size_t l = 1; l < levels.size(); ++l) {
+            const Level& src = levels[l - 1];
+            Level& dst = levels[l];
+            for (int y = 0; y < dst.height; ++y) {
+                const int y0 = 2 * y, y1 = std::min(2 * y + 1, src.height - 1);
+                for (int x = 0; x < dst.width; ++x) {
+                    const int x0 = 2 * x, x1 = std::min(2 * x + 1, src.width - 1);
+                    dst.depth[y * dst.stride + x] = std::max(
+                        std::max(src.depth[y0 * src.stride + x0], src.depth[y0 * src.stride + x1]),
+                        std::max(src.depth[y1 * src.stride + x0], src.depth[y1 * src.stride + x1]));
+                }
+            }
+        }
+    }
+
+    // Мировая коробка [min, max] может быть видна (не закрыта загораживателями)
+    bool boxVisible(const glm::vec3& min, const glm::vec3& max) const {
+        const Level& base = levels[0];
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 1.0f;
+        for (int corner = 0; corner < 8; ++corner) {
+            const glm::vec4 c = viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+                                                           corner & 4 ? max.z : min.z, 1.0f);
+            // угол перед ближней плоскостью — проекция коробки не ограничена
+            if (c.w <= 0.0f || c.z < -c.w) return true;
+            const float inverseW = 1.0f / c.w;
+            const float x = (c.x * inverseW * 0.5f + 0.5f) * base.width;
+            const float y = (c.y * inverseW * 0.5f + 0.5f) * base.height;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::min(nearest, c.z * inverseW * 0.5f + 0.5f);
+        }
+        if (maxX < 0.0f || maxY < 0.0f || minX >= base.width || minY >= base.height) return true;
+
+        const int x0 = std::max(0, static_cast<int>(std::floor(minX)) - 1);
+        const int y0 = std::max(0, static_cast<int>(std::floor(minY)) - 1);
+        const int x1 = std::min(base.width - 1, static_cast<int>(std::floor(maxX)) + 1);
+        const int y1 = std::min(base.height - 1, static_cast<int>(std::floor(maxY)) + 1);
+        // уровень, где прямоугольник занимает не больше 2x2 текселей
+        std::size_t l = 0;
+        while (l + 1 < levels.size() && ((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1)) ++l;
+        const Level& level = levels[l];
+        float farthest = 0.0f;
+        for (int y = y0 >> l; y <= (y1 >> l); ++y)
+            for (int x = x0 >> l; x <= (x1 >> l); ++x) farthest = std::max(farthest, level.depth[y * level.stride + x]);
+        return nearest <= farthest;
+    }
+
+    int width() const { return levels[0].width; }
+    int height() const { return levels[0].height; }
+    std::size_t levelCount() const { return levels.size(); }
+    // Глубина уровня l построчно (шаг строки levelStride)
+    const float* levelDepth(std::size_t l) const { return levels[l].depth.data(); }
+    int levelStride(std::size_t l) const { return levels[l].stride; }
+
+    std::size_t trianglesDrawn = 0;   // после отсечения ближней плоскостью, за кадр
+
+private:
+    struct Level {
+        int width = 0, height = 0, stride = 0;
+        std::vector<float> depth;
+    };
+
+    // Отрезать часть треугольника перед ближней плоскостью (z >= -w):
+    // остаётся треугольник или четырёхугольник (два треугольника)
+    void clipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+        const glm::vec4 in[3] = { a, b, c };
+        float d[3];
+        int inside = 0;
+        for (int i = 0; i < 3; ++i) {
+            d[i] = in[i].z + in[i].w;
+            inside += d[i] >= 0.0f;
+        }
+        if (inside == 0) return;
+        if (inside == 3) {
+            rasterize(a, b, c);
+            return;
+        }
+        glm::vec4 out[4];
+        int count = 0;
+        for (int i = 0; i < 3; ++i) {
+            const int j = (i + 1) % 3;
+            if (d[i] >= 0.0f) out[count++] = in[i];
+            if ((d[i] >= 0.0f) != (d[j] >= 0.0f)) out[count++] = in[i] + (in[j] - in[i]) * (d[i] / (d[i] - d[j]));
+        }
+        rasterize(out[0], out[1], out[2]);
+        if (count == 4) rasterize(out[0], out[2], out[3]);
+    }
+
+    void rasterize(const glm::vec4& a, const glm::vec4& b, const glm::vec4& d) {
+        Level& target = levels[0];
+        // экранные координаты (пиксель x — от x до x + 1) и глубина
+        glm::vec3 v[3];
+        const glm::vec4* clip[3] = { &a, &b, &d };
+        for (int i = 0; i < 3; ++i) {
+            const float w = std::max(clip[i]->w, 1e-6f);
+            v[i] = glm::vec3((clip[i]->x / w * 0.5f + 0.5f) * target.width, (clip[i]->y / w * 0.5f + 0.5f) * target.height,
+                             clip[i]->z / w * 0.5f + 0.5f);
+        }
+        double area = (double(v[1].x) - v[0].x) * (double(v[2].y) - v[0].y) - (double(v[2].x) - v[0].x) * (double(v[1].y) - v[0].y);
+        if (area < 0.0) {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+        if (area <= 1e-12) return;
+
+        const int minX = std::max(0, static_cast<int>(std::floor(std::min({ v[0].x, v[1].x, v[2].x }))));
+        const int minY = std::max(0, static_cast<int>(std::floor(std::min({ v[0].y, v[1].y, v[2].y }))));
+        const int maxX = std::min(target.width - 1, static_cast<int>(std::floor(std::max({ v[0].x, v[1].x, v[2].x }))));
+        const int maxY = std::min(target.height - 1, static_cast<int>(std::floor(std::max({ v[0].y, v[1].y, v[2].y }))));
+        if (minX > maxX || minY > maxY) return;
+        ++trianglesDrawn;
+
+        // E_i(x, y) = dx_i * x + dy_i * y + c_i >= 0 внутри, E_i / area —
+        // барицентрическая координата вершины i; глубина — плоскость по x, y
+        double dx[3], dy[3], c[3];
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec3& p = v[(i + 1) % 3];
+            const glm::vec3& q = v[(i + 2) % 3];
+            dx[i] = double(p.y) - q.y;
+            dy[i] = double(q.x) - p.x;
+            c[i] = double(p.x) * q.y - double(q.x) * p.y;
+        }
+        const double zdx = (dx[0] * v[0].z + dx[1] * v[1].z + dx[2] * v[2].z) / area;
+        const double zdy = (dy[0] * v[0].z + dy[1] * v[1].z + dy[2] * v[2].z) / area;
+        const double zc = (c[0] * v[0].z + c[1] * v[1].z + c[2] * v[2].z) / area;
+
+        const int startX = minX / OCCLUSION_LANES * OCCLUSION_LANES;
+        for (int y = minY; y <= maxY; ++y) {
+            const double py = y + 0.5;
+            // значения в центре пикселя x = 0 этой строки; дальше шаг по x
+            const float e0 = static_cast<float>(dy[0] * py + c[0] + dx[0] * 0.5);
+            const float e1 = static_cast<float>(dy[1] * py + c[1] + dx[1] * 0.5);
+            const float e2 = static_cast<float>(dy[2] * py + c[2] + dx[2] * 0.5);
+            const float z = static_cast<float>(zdy * py + zc + zdx * 0.5);
+            float* row = &target.depth[static_cast<std::size_t>(y) * target.stride];
+            int x = startX;
+#if OCCLUSION_LANES == 8
+            const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            const __m256 step0 = _mm256_set1_ps(static_cast<float>(dx[0]));
+            const __m256 step1 = _mm256_set1_ps(static_cast<float>(dx[1]));
+            const __m256 step2 = _mm256_set1_ps(static_cast<float>(dx[2]));
+            const __m256 stepZ = _mm256_set1_ps(static_cast<float>(zdx));
+            const __m256 zero = _mm256_setzero_ps();
+            for (; x <= maxX; x += 8) {
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lane);
+                const __m256 w0 = _mm256_add_ps(_mm256_set1_ps(e0), _mm256_mul_ps(step0, px));
+                const __m256 w1 = _mm256_add_ps(_mm256_set1_ps(e1), _mm256_mul_ps(step1, px));
+                const __m256 w2 = _mm256_add_ps(_mm256_set1_ps(e2), _mm256_mul_ps(step2, px));
+                const __m256 covered = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ),
+                                                                   _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)),
+                                                     _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(covered) == 0) continue;
+                const __m256 depth = _mm256_loadu_ps(row + x);
+                const __m256 pz = _mm256_add_ps(_mm256_set1_ps(z), _mm256_mul_ps(stepZ, px));
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(depth, _mm256_min_ps(depth, pz), covered));
+            }
+#elif OCCLUSION_LANES == 4
+            const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            const __m128 step0 = _mm_set1_ps(static_cast<float>(dx[0]));
+            const __m128 step1 = _mm_set1_ps(static_cast<float>(dx[1]));
+            const __m128 step2 = _mm_set1_ps(static_cast<float>(dx[2]));
+            const __m128 stepZ = _mm_set1_ps(static_cast<float>(zdx));
+            const __m128 zero = _mm_setzero_ps();
+            for (; x <= maxX; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+                const __m128 w0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(step0, px));
+                const __m128 w1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(step1, px));
+                const __m128 w2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(step2, px));
+                const __m128 covered = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)),
+                                                  _mm_cmpge_ps(w2, zero));
+                if (_mm_movemask_ps(covered) == 0) continue;
+                const __m128 depth = _mm_loadu_ps(row + x);
+                const __m128 pz = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(stepZ, px));
+                // без SSE4.1 blendv: покрытые — минимум, остальные — прежняя глубина
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, _mm_min_ps(depth, pz)), _mm_andnot_ps(covered, depth)));
+            }
+#else
+            for (; x <= maxX; ++x) {
+                const float px = static_cast<float>(x);
+                if (e0 + static_cast<float>(dx[0]) * px < 0.0f || e1 + static_cast<float>(dx[1]) * px < 0.0f ||
+                    e2 + static_cast<float>(dx[2]) * px < 0.0f) continue;
+                row[x] = std::min(row[x], z + static_cast<float>(zdx) * px);
+            }
+#endif
+        }
+    }
+
+    std::vector<Level> levels;   // 0 — буфер растеризации, дальше пирамида
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<glm::vec4> clipVertices;
+};
@@ -0,0 +1,194 @@
+#pragma once
+#include "Utils.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+/* ------------------------------------------------------------------ */
+// Очередь отрисовки: каждый кадр объекты попадают в неё с 64-битным ключом,
+// сортируются по нему и рисуются подряд, так что объекты с общей программой,
+// текстурой и VAO идут друг за другом и состояние GL меняется реже.
+//
+// Ключ, старшие поля важнее:
+//   [63..48] программа   [47..32] текстура   [31..20] VAO   [19..0] глубина
+// В поля пишутся имена объектов GL, обрезанные до ширины поля. Совпадение
+// после обрезки только портит группировку: лишние смены состояния всё равно
+// отсекает RenderStateCache по настоящим значениям.
+
+const int SORT_KEY_DEPTH_BITS = 20;
+const int SORT_KEY_VAO_BITS = 12;
+const int SORT_KEY_TEXTURE_BITS = 16;
+const int SORT_KEY_PROGRAM_BITS = 16;
+
+// depth — расстояние до камеры вдоль взгляда; внутри одного состояния
+// объекты идут от ближних к дальним (меньше перерисовки пикселей)
+std::uint64_t makeSortKey(GLuint program, GLuint texture, GLuint vao,
+                          float depth, float nearPlane, float farPlane) {
+    const std::uint64_t depthMax = (1ull << SORT_KEY_DEPTH_BITS) - 1;
+    float t = (depth - nearPlane) / (farPlane - nearPlane);
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    const std::uint64_t d = static_cast<std::uint64_t>(t * static_cast<float>(depthMax));
+
+    std::uint64_t key = program & ((1ull << SORT_KEY_PROGRAM_BITS) - 1);
+    key = (key << SORT_KEY_TEXTURE_BITS) | (texture & ((1ull << SORT_KEY_TEXTURE_BITS) - 1));
+    key = (key << SORT_KEY_VAO_BITS) | (vao & ((1ull << SORT_KEY_VAO_BITS) - 1));
+    key = (key << SORT_KEY_DEPTH_BITS) | d;
+    return key;
+}
+
+struct RenderItem {
+    std::uint64_t key;
+    std::uint32_t index;   // номер объекта в сцене
+};
+
+class RenderQueue {
+public:
+    void clear() { items.clear(); }
+    void reserve(std::size_t count) {
+        items.reserve(count);
+        scratch.reserve(count);
+    }
+    void push(std::uint64_t key, std::uint32_t index) { items.push_back({ key, index }); }
+
+    // Поразрядная сортировка LSD по байтам ключа, устойчивая. Гистограммы
+    // всех байтов считаются за один проход; байт, одинаковый у всех ключей
+    // (обычно старшие байты программы и текстуры), прохода не требует.
+    // Буферы переживают кадр, так что после первого кадра памяти не выделяет.
+    void sort() {
+        const std::size_t n = items.size();
+        if (n < 2) return;
+
+        std::size_t counts[8][256];
+        std::memset(counts, 0, sizeof(counts));
+        for (const RenderItem& item : items)
+            for (int b = 0; b < 8; ++b) ++counts[b][(item.key >> (b * 8)) & 0xFF];
+
+        scratch.resize(n);
+        for (int b = 0; b < 8; ++b) {
+            const std::size_t* count = counts[b];
+            if (count[(items[0].key >> (b * 8)) & 0xFF] == n) continue;
+
+            std::size_t offset[256];
+            std::size_t sum = 0;
+            for (int i = 0; i < 256; ++i) {
+                offset[i] = sum;
+                sum += count[i];
+            }
+            for (const RenderItem& item : items)
+                scratch[offset[(item.key >> (b * 8)) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+    }
+
+    const RenderItem* begin() const { return items.data(); }
+    const RenderItem* end() const { return items.data() + items.size(); }
+    std::size_t size() const { return items.size(); }
+
+private:
+    std::vector<RenderItem> items;
+    std::vector<RenderItem> scratch;
+};
+
+/* ------------------------------------------------------------------ */
+// Смены состояния за кадр
+struct RenderStateStats {
+    std::size_t draws = 0;
+    std::size_t instances = 0;
+    std::size_t programs = 0;
+    std::size_t textures = 0;
+    std::size_t vertexArrays = 0;
+
+    std::size_t changes() const { return programs + textures + vertexArrays; }
+    bool operator!=(const RenderStateStats& o) const {
+        return draws != o.draws || instances != o.instances || programs != o.programs || textures != o.textures || vertexArrays != o.vertexArrays;
+    }
+};
+
+// Текущее состояние GL: повторная привязка того же объекта не вызывает GL.
+// requested — сколько привязок просили (столько делал цикл без очереди),
+// changed — сколько ушло в GL.
+class RenderStateCache {
+public:
+    RenderStateStats requested, changed;
+
+    // Начало кадра: состояние неизвестно, счётчики с нуля
+    void begin() {
+        program = texture = vertexArray = 0;
+        requested = changed = RenderStateStats();
+    }
+
+    // true, если программа сменилась — пора задать её uniform'ы кадра
+    bool useProgram(GLuint p) {
+        ++requested.programs;
+        if (p == program) return false;
+        glUseProgram(p);
+        program = p;
+        ++changed.programs;
+        return true;
+    }
+
+    // Текстура на блоке 0
+    void bindTexture(GLuint t) {
+        ++requested.textures;
+        if (t == texture) return;
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, t);
+        texture = t;
+        ++changed.textures;
+    }
+
+    // true, если VAO сменился
+    bool bindVertexArray(GLuint vao) {
+        ++requested.vertexArrays;
+        if (vao == vertexArray) return false;
+        glBindVertexArray(vao);
+        vertexArray = vao;
+        ++changed.vertexArrays;
+        return true;
+    }
+
+    void draw(const Mesh& mesh) {
+        bindVertexArray(mesh.vao);
+        mesh.drawBound();
+        countDraw(1);
+    }
+
+    // VAO меша уже привязан через bindVertexArray (вместе с ним — атрибуты
+    // экземпляров, см. Instancing.h)
+    void drawInstanced(const Mesh& mesh, std::size_t count) {
+        mesh.drawBoundInstanced(static_cast<GLsizei>(count));
+        countDraw(count);
+    }
+
+    // Вызов отрисовки мимо draw/drawInstanced (glMultiDrawElementsIndirect)
+    void countDraw(std::size_t instances) {
+        ++requested.draws;
+        ++changed.draws;
+        requested.instances += instances;
+        changed.instances += instances;
+    }
+
+    // Конец кадра: отвязать всё, как это делал Mesh::draw
+    void end() {
+        glBindVertexArray(0);
+        glUseProgram(0);
+        program = texture = vertexArray = 0;
+    }
+
+private:
+    GLuint program = 0;
+    GLuint texture = 0;
+    GLuint vertexArray = 0;
+};
+
+// Смены состояния без очереди и с ней
+void printRenderStateReport(const RenderStateStats& requested, const RenderStateStats& changed) {
+    std::cout << "State changes per frame: " << requested.changes() << " -> " << changed.changes()
+              << " (programs " << requested.programs << " -> " << changed.programs
+              << ", textures " << requested.textures << " -> " << changed.textures
+              << ", VAOs " << requested.vertexArrays << " -> " << changed.vertexArrays
+              << ", draws " << changed.draws << " for " << changed.instances << " instances)" << std::endl;
+}
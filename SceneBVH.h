@@ -0,0 +1,500 @@
+#pragma once
+#include "Frustum.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/* ------------------------------------------------------------------ */
+// Иерархия ограничивающих коробок (BVH) над объектами сцены: отсечение по
+// пирамиде, луч для выбора мышью и ближайшие объекты (например, к
+// источнику света) за O(log n) вместо обхода всех sceneObjects.
+//
+// build строит дерево по SAH (разбиение по корзинам центров): узел
+// делится там, где сумма «площадь x число объектов» детей меньше всего.
+// Когда объекты двигаются, update меняет коробку объекта, а refit
+// пересчитывает коробки по пути к корню — дерево остаётся верным, но
+// разбиение стареет. Если sahCost() вырос заметно (в 1.5–2 раза против
+// buildCost()), дешевле построить заново. Добавить или убрать объект —
+// тоже через build.
+//
+// Объекты поддерева лежат в objectIndices подряд, так что узел, целиком
+// попавший в пирамиду, отдаёт их без обхода детей.
+
+// Коробка по осям в мировых координатах
+struct BoundingBox {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void expand(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+    void expand(const BoundingBox& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    bool empty() const { return min.x > max.x; }
+
+    // Половина площади поверхности — SAH нужны только отношения
+    float halfArea() const {
+        if (empty()) return 0.0f;
+        const glm::vec3 d = max - min;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    // Квадрат расстояния от точки до коробки (0 внутри)
+    float distance2(const glm::vec3& p) const {
+        const glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    bool operator==(const BoundingBox& b) const { return min == b.min && max == b.max; }
+};
+
+// Коробка модели [min, max] после матрицы m (Arvo): центр переносится
+// матрицей, полуразмеры — модулем её 3x3
+BoundingBox transformBox(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max) {
+    const glm::vec3 center = glm::vec3(m * glm::vec4((min + max) * 0.5f, 1.0f));
+    const glm::vec3 half = (max - min) * 0.5f;
+    glm::vec3 extent(0.0f);
+    for (int column = 0; column < 3; ++column)
+        extent += glm::abs(glm::vec3(m[column])) * half[column];
+    BoundingBox b;
+    b.min = center - extent;
+    b.max = center + extent;
+    return b;
+}
+
+// Результат raycast: ближайший объект и расстояние в длинах direction
+struct RayHit {
+    std::uint32_t object = std::numeric_limits<std::uint32_t>::max();
+    float distance = std::numeric_limits<float>::max();
+    bool hit() const { return object != std::numeric_limits<std::uint32_t>::max(); }
+};
+
+// Сколько работы сделал запрос (накапливается); общая для SceneBVH и LooseOctree
+struct SpatialQueryStats {
+    std::size_t nodesVisited = 0;
+    std::size_t objectsTested = 0;
+};
+
+class SceneBVH {
+public:
+    static const std::uint32_t MAX_LEAF_OBJECTS = 4;
+    static const int SAH_BINS = 16;
+    // Глубже дерево не растёт (лист берёт все объекты узла) — стеки обхода
+    // фиксированного размера
+    static const std::uint32_t MAX_DEPTH = 48;
+
+    // Построить дерево по мировым коробкам объектов; номер объекта —
+    // его индекс в boxes
+    void build(const std::vector<BoundingBox>& objectBoxes) {
+        boxes = objectBoxes;
+        const std::uint32_t count = static_cast<std::uint32_t>(boxes.size());
+        nodes.clear();
+        parents.clear();
+        dirtyLeaves.clear();
+        objectIndices.resize(count);
+        leafOfObject.assign(count, 0);
+        centers.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            objectIndices[i] = i;
+            centers[i] = boxes[i].center();
+        }
+        if (count == 0) {
+            initialCost = 0.0f;
+            return;
+        }
+
+        nodes.reserve(2 * count / MAX_LEAF_OBJECTS + 1);
+        parents.reserve(nodes.capacity());
+        nodes.push_back(Node());
+        parents.push_back(0);
+        nodes[0].first = 0;
+        nodes[0].count = count;
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack(1, { 0, 0 });   // узел, глубина
+        while (!stack.empty()) {
+            const std::uint32_t index = stack.back().first, depth = stack.back().second;
+            stack.pop_back();
+            if (!split(index, depth < MAX_DEPTH)) continue;
+            const std::uint32_t left = nodes[index].left;
+            stack.push_back({ left + 1, depth + 1 });
+            stack.push_back({ left, depth + 1 });
+        }
+        dirtyFlags.assign(nodes.size(), 0);
+        initialCost = sahCost();
+    }
+
+    // Заново по текущим коробкам объектов (после update), когда refit
+    // слишком испортил разбиение
+    void rebuild() { build(boxes); }
+
+    // Новая коробка объекта; дерево обновится в refit
+    void update(std::uint32_t object, const BoundingBox& box) {
+        boxes[object] = box;
+        const std::uint32_t leaf = leafOfObject[object];
+        if (!dirtyFlags[leaf]) {
+            dirtyFlags[leaf] = 1;
+            dirtyLeaves.push_back(leaf);
+        }
+    }
+
+    // Пересчитать коробки после update. Путь к корню обрывается на узле,
+    // чья коробка не изменилась; если изменилась большая часть листьев,
+    // дешевле один проход по всем узлам снизу вверх.
+    void refit() {
+        if (dirtyLeaves.empty()) return;
+        if (dirtyLeaves.size() * 4 > nodes.size()) {
+            refitAll();
+            return;
+        }
+        for (std::uint32_t leaf : dirtyLeaves) {
+            dirtyFlags[leaf] = 0;
+            nodes[leaf].box = objectBounds(nodes[leaf].first, nodes[leaf].count);
+            for (std::uint32_t node = leaf; node != 0;) {
+                node = parents[node];
+                const std::uint32_t left = nodes[node].left;
+                BoundingBox box = nodes[left].box;
+                box.expand(nodes[left + 1].box);
+                if (box == nodes[node].box) break;
+                nodes[node].box = box;
+            }
+        }
+        dirtyLeaves.clear();
+    }
+
+    // Все коробки заново: дети всегда дальше в массиве, чем родитель
+    void refitAll() {
+        for (std::size_t i = nodes.size(); i-- > 0;) {
+            Node& node = nodes[i];
+            if (node.left == 0) {
+                node.box = objectBounds(node.first, node.count);
+            }
+            else {
+                node.box = nodes[node.left].box;
+                node.box.expand(nodes[node.left + 1].box);
+            }
+        }
+        for (std::uint32_t leaf : dirtyLeaves) dirtyFlags[leaf] = 0;
+        dirtyLeaves.clear();
+    }
+
+    // Объекты, чьи коробки хотя бы частично в пирамиде (дописываются в out).
+    // Плоскости, внутри которых узел целиком, детям уже не проверяются.
+    void queryFrustum(const Frustum& f, std::vector<std::uint32_t>& out, SpatialQueryStats* stats = nullptr) const {
+        if (nodes.empty()) return;
+        std::uint32_t stack[MAX_DEPTH + 2][2];   // узел, маска непроверенных плоскостей
+        int top = 0;
+        stack[top][0] = 0;
+        stack[top++][1] = FRUSTUM_ALL_PLANES;
+        while (top > 0) {
+            --top;
+            const Node& node = nodes[stack[top][0]];
+            std::uint32_t planes = stack[top][1];
+            if (stats) ++stats->nodesVisited;
+            if (!boxInFrustum(f, node.box.min, node.box.max, planes)) continue;
+
+            if (planes == 0) {
+                // целиком внутри — всё поддерево без обхода
+                out.insert(out.end(), objectIndices.begin() + node.first,
+                           objectIndices.begin() + node.first + node.count);
+                continue;
+            }
+            if (node.left == 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const std::uint32_t object = objectIndices[i];
+                    std::uint32_t objectPlanes = planes;
+                    if (stats) ++stats->objectsTested;
+                    if (boxInFrustum(f, boxes[object].min, boxes[object].max, objectPlanes)) out.push_back(object);
+                }
+                continue;
+            }
+            stack[top][0] = node.left;
+            stack[top++][1] = planes;
+            stack[top][0] = node.left + 1;
+            stack[top++][1] = planes;
+        }
+    }
+
+    // Ближайший объект на луче origin + t * direction, t в [0, hit.distance).
+    // test(object, tBox) уточняет попадание (например, по треугольникам
+    // меша): возвращает t или отрицательное число при промахе. tBox — вход
+    // луча в коробку объекта.
+    template <class HitTest>
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit, HitTest test,
+                 SpatialQueryStats* stats = nullptr) const {
+        if (nodes.empty()) return false;
+        const glm::vec3 inverse = glm::vec3(1.0f) / direction;
+        std::pair<std::uint32_t, float> stack[MAX_DEPTH + 2];   // узел, вход луча в его коробку
+        int top = 0;
+        const float tRoot = rayBox(nodes[0].box, origin, inverse, hit.distance);
+        if (tRoot < 0.0f) return false;
+        stack[top++] = { 0, tRoot };
+        bool found = false;
+        while (top > 0) {
+            --top;
+            // ближе уже нашли — узел не нужен
+            if (stack[top].second > hit.distance) continue;
+            const Node& node = nodes[stack[top].first];
+            if (stats) ++stats->nodesVisited;
+
+            if (node.left == 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const std::uint32_t object = objectIndices[i];
+                    if (stats) ++stats->objectsTested;
+                    const float tBox = rayBox(boxes[object], origin, inverse, hit.distance);
+                    if (tBox < 0.0f) continue;
+                    const float t = test(object, tBox);
+                    if (t >= 0.0f && t < hit.distance) {
+                        hit.object = object;
+                        hit.distance = t;
+                        found = true;
+                    }
+                }
+                continue;
+            }
+            // ближний ребёнок — последним в стек, чтобы обойти его первым
+            const float tLeft = rayBox(nodes[node.left].box, origin, inverse, hit.distance);
+            const float tRight = rayBox(nodes[node.left + 1].box, origin, inverse, hit.distance);
+            const bool leftFirst = tLeft >= 0.0f && (tRight < 0.0f || tLeft <= tRight);
+            if (leftFirst) {
+                if (tRight >= 0.0f) stack[top++] = { node.left + 1, tRight };
+                stack[top++] = { node.left, tLeft };
+            }
+            else {
+                if (tLeft >= 0.0f) stack[top++] = { node.left, tLeft };
+                if (tRight >= 0.0f) stack[top++] = { node.left + 1, tRight };
+            }
+        }
+        return found;
+    }
+
+    // То же с попаданием по коробкам объектов
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                 SpatialQueryStats* stats = nullptr) const {
+        return raycast(origin, direction, hit, [](std::uint32_t, float tBox) { return tBox; }, stats);
+    }
+
+    // До count объектов, ближайших к point (по расстоянию до коробки, не
+    // дальше maxDistance), от ближнего к дальнему
+    void nearest(const glm::vec3& point, std::size_t count, std::vector<std::uint32_t>& out,
+                 float maxDistance = std::numeric_limits<float>::max(), SpatialQueryStats* stats = nullptr) const {
+        if (nodes.empty() || count == 0) return;
+        const float limit2 = maxDistance < std::sqrt(std::numeric_limits<float>::max())
+                           ? maxDistance * maxDistance : std::numeric_limits<float>::max();
+        // узлы — по возрастанию расстояния, найденные — куча с дальним наверху
+        std::vector<std::pair<float, std::uint32_t>> open, found;
+        auto farther = [](const std::pair<float, std::uint32_t>& a, const std::pair<float, std::uint32_t>& b) {
+            return a.first > b.first;
+        };
+        open.push_back({ nodes[0].box.distance2(point), 0 });
+        while (!open.empty()) {
+            std::pop_heap(open.begin(), open.end(), farther);
+            const std::pair<float, std::uint32_t> entry = open.back();
+            open.pop_back();
+            const float bound = found.size() == count ? found.front().first : limit2;
+            if (entry.first > bound) break;
+
+            const Node& node = nodes[entry.second];
+            if (stats) ++stats->nodesVisited;
+            if (node.left == 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const std::uint32_t object = objectIndices[i];
+                    if (stats) ++stats->objectsTested;
+                    const float d2 = boxes[object].distance2(point);
+                    if (d2 > limit2) continue;
+                    if (found.size() < count) {
+                        found.push_back({ d2, object });
+                        std::push_heap(found.begin(), found.end());
+                    }
+                    else if (d2 < found.front().first) {
+                        std::pop_heap(found.begin(), found.end());
+                        found.back() = { d2, object };
+                        std::push_heap(found.begin(), found.end());
+                    }
+                }
+                continue;
+            }
+            for (std::uint32_t child = node.left; child <= node.left + 1; ++child) {
+                const float d2 = nodes[child].box.distance2(point);
+                if (d2 > (found.size() == count ? found.front().first : limit2)) continue;
+                open.push_back({ d2, child });
+                std::push_heap(open.begin(), open.end(), farther);
+            }
+        }
+        std::sort_heap(found.begin(), found.end());
+        for (const auto& f : found) out.push_back(f.second);
+    }
+
+    // Все объекты, чьи коробки задевают сферу (радиус действия источника)
+    void querySphere(const glm::vec3& center, float radius, std::vector<std::uint32_t>& out,
+                     SpatialQueryStats* stats = nullptr) const {
+        if (nodes.empty()) return;
+        const float radius2 = radius * radius;
+        std::uint32_t stack[MAX_DEPTH + 2];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (stats) ++stats->nodesVisited;
+            if (node.box.distance2(center) > radius2) continue;
+            if (node.left != 0) {
+                stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+                continue;
+            }
+            for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const std::uint32_t object = objectIndices[i];
+                if (stats) ++stats->objectsTested;
+                if (boxes[object].distance2(center) <= radius2) out.push_back(object);
+            }
+        }
+    }
+
+    // Стоимость дерева по SAH относительно корня: обход узла — 1,
+    // проверка объекта — 1. После refit растёт, после build — минимальна.
+    float sahCost() const {
+        if (nodes.empty()) return 0.0f;
+        const float rootArea = nodes[0].box.halfArea();
+        if (rootArea <= 0.0f) return static_cast<float>(boxes.size());
+        float cost = 0.0f;
+        for (const Node& node : nodes)
+            cost += node.box.halfArea() * (node.left == 0 ? static_cast<float>(node.count) : 1.0f);
+        return cost / rootArea;
+    }
+
+    float buildCost() const { return initialCost; }
+    std::size_t nodeCount() const { return nodes.size(); }
+    // Память под дерево и данные объектов
+    std::size_t memoryBytes() const {
+        return nodes.capacity() * sizeof(Node) + parents.capacity() * sizeof(std::uint32_t) +
+               dirtyFlags.capacity() + dirtyLeaves.capacity() * sizeof(std::uint32_t) +
+               (objectIndices.capacity() + leafOfObject.capacity()) * sizeof(std::uint32_t) +
+               boxes.capacity() * sizeof(BoundingBox) + centers.capacity() * sizeof(glm::vec3);
+    }
+    std::size_t objectCount() const { return boxes.size(); }
+    const BoundingBox& objectBox(std::uint32_t object) const { return boxes[object]; }
+
+private:
+    struct Node {
+        BoundingBox box;
+        std::uint32_t left = 0;    // 0 — лист; правый ребёнок — left + 1
+        std::uint32_t first = 0;   // объекты поддерева: objectIndices[first, first + count)
+        std::uint32_t count = 0;
+    };
+
+    BoundingBox objectBounds(std::uint32_t first, std::uint32_t count) const {
+        BoundingBox b;
+        for (std::uint32_t i = first; i < first + count; ++i) b.expand(boxes[objectIndices[i]]);
+        return b;
+    }
+
+    // Вход луча в коробку (t >= 0) или -1, если промах или дальше tMax
+    static float rayBox(const BoundingBox& b, const glm::vec3& origin, const glm::vec3& inverse, float tMax) {
+        const glm::vec3 t0 = (b.min - origin) * inverse;
+        const glm::vec3 t1 = (b.max - origin) * inverse;
+        const glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+        const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+        return enter <= exit ? enter : -1.0f;
+    }
+
+    // Коробка узла и, если выгодно (и allowed), разбиение на двух детей по SAH
+    bool split(std::uint32_t index, bool allowed) {
+        const std::uint32_t first = nodes[index].first, count = nodes[index].count;
+        BoundingBox bounds, centroidBounds;
+        for (std::uint32_t i = first; i < first + count; ++i) {
+            bounds.expand(boxes[objectIndices[i]]);
+            centroidBounds.expand(centers[objectIndices[i]]);
+        }
+        nodes[index].box = bounds;
+        for (std::uint32_t i = first; i < first + count; ++i) leafOfObject[objectIndices[i]] = index;
+        if (count <= 1 || !allowed) return false;
+
+        // лучшее разбиение по корзинам центров на каждой оси
+        struct Bin {
+            BoundingBox box;
+            std::uint32_t count = 0;
+        };
+        int bestAxis = -1, bestBin = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (extent[axis] <= 0.0f) continue;
+            const float scale = SAH_BINS / extent[axis];
+            Bin bins[SAH_BINS];
+            for (std::uint32_t i = first; i < first + count; ++i) {
+                const std::uint32_t object = objectIndices[i];
+                int b = static_cast<int>((centers[object][axis] - centroidBounds.min[axis]) * scale);
+                b = std::min(b, SAH_BINS - 1);
+                bins[b].box.expand(boxes[object]);
+                ++bins[b].count;
+            }
+            // площади правых частей справа налево, затем проход слева
+            float rightArea[SAH_BINS];
+            std::uint32_t rightCount[SAH_BINS];
+            BoundingBox right;
+            std::uint32_t n = 0;
+            for (int b = SAH_BINS - 1; b > 0; --b) {
+                right.expand(bins[b].box);
+                n += bins[b].count;
+                rightArea[b] = right.halfArea();
+                rightCount[b] = n;
+            }
+            BoundingBox left;
+            n = 0;
+            for (int b = 0; b < SAH_BINS - 1; ++b) {
+                left.expand(bins[b].box);
+                n += bins[b].count;
+                if (n == 0 || rightCount[b + 1] == 0) continue;
+                const float cost = left.halfArea() * n + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        const float area = bounds.halfArea();
+        const float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+        if (count <= MAX_LEAF_OBJECTS && (bestAxis < 0 || splitCost >= static_cast<float>(count))) return false;
+
+        std::uint32_t middle;
+        if (bestAxis >= 0) {
+            const float scale = SAH_BINS / extent[bestAxis];
+            const float minCenter = centroidBounds.min[bestAxis];
+            auto* begin = objectIndices.data() + first;
+            middle = static_cast<std::uint32_t>(std::partition(begin, begin + count, [&](std::uint32_t object) {
+                const int b = std::min(static_cast<int>((centers[object][bestAxis] - minCenter) * scale), SAH_BINS - 1);
+                return b <= bestBin;
+            }) - objectIndices.data());
+        }
+        else {
+            // все центры совпадают — делим пополам как есть
+            middle = first + count / 2;
+        }
+
+        const std::uint32_t left = static_cast<std::uint32_t>(nodes.size());
+        nodes[index].left = left;
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        parents.push_back(index);
+        parents.push_back(index);
+        nodes[left].first = first;
+        nodes[left].count = middle - first;
+        nodes[left + 1].first = middle;
+        nodes[left + 1].count = first + count - middle;
+        return true;
+    }
+
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> parents;        // по узлам; у корня 0
+    std::vector<std::uint32_t> objectIndices;  // объекты в порядке листьев
+    std::vector<std::uint32_t> leafOfObject;
+    std::vector<BoundingBox> boxes;            // по номеру объекта
+    std::vector<glm::vec3> centers;
+    std::vector<std::uint32_t> dirtyLeaves;
+    std::vector<std::uint8_t> dirtyFlags;      // по узлам: лист уже в dirtyLeaves
+    float initialCost = 0.0f;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Простой пул потоков под одну операцию — parallelFor.
+// Потоки создаются один раз и спят между вызовами.
+// Вызывающий поток тоже берёт задачи, поэтому пул из N потоков
+// даёт параллелизм N + 1.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned workerCount) {
+        for (unsigned i = 0; i < workerCount; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Вызывает fn(i) для всех i из [0, count). Порядок вызовов не задан,
+    // maxThreads ограничивает число одновременно работающих потоков.
+    void parallelFor(std::size_t count, unsigned maxThreads,
+                     const std::function<void(std::size_t)>& fn) {
+        if (count == 0) return;
+        unsigned helpers = maxThreads > 1 ? maxThreads - 1 : 0;
+        if (helpers > workers.size()) helpers = static_cast<unsigned>(workers.size());
+        if (count == 1 || helpers == 0) {
+            for (std::size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+
+        std::unique_lock<std::mutex> callLock(callMutex);     // один parallelFor за раз
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            taskCount = count;
+            next = 0;
+            activeHelpers = helpers;
+            pendingHelpers = helpers;
+            ++generation;
+        }
+        wake.notify_all();
+
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pendingHelpers == 0; });
+        task = nullptr;
+    }
+
+    // Общий пул на всё приложение: по потоку на ядро
+    static ThreadPool& shared() {
+        static ThreadPool pool(std::thread::hardware_concurrency() > 1
+                                   ? std::thread::hardware_concurrency() - 1 : 0);
+        return pool;
+    }
+
+private:
+    void runTasks() {
+        for (;;) {
+            std::size_t i = next.fetch_add(1);
+            if (i >= taskCount) break;
+            (*task)(i);
+        }
+    }
+
+    void workerLoop() {
+        unsigned long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || (generation != seen && activeHelpers > 0); });
+                if (stopping) return;
+                seen = generation;
+                --activeHelpers;
+            }
+            runTasks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pendingHelpers == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex callMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(std::size_t)>* task = nullptr;
+    std::size_t taskCount = 0;
+    std::atomic<std::size_t> next{ 0 };
+    unsigned activeHelpers = 0;
+    unsigned pendingHelpers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
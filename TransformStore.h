@@ -0,0 +1,239 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TRANSFORM_STORE_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_STORE_LANES 4
+#else
+#define TRANSFORM_STORE_LANES 1
+#endif
+
+/* ------------------------------------------------------------------ */
+// Положения большого числа объектов в виде структуры массивов: позиции,
+// синусы/косинусы углов и масштабы лежат каждый в своём массиве, так что
+// сборка матриц читает память подряд и считает 8 (AVX) или 4 (SSE)
+// объекта за раз. Для десятков тысяч объектов это заметно быстрее, чем
+// glm::translate/rotate/scale по каждому SceneObject, где поля перемешаны
+// с мешем, строками и handle'ами GL.
+//
+// Поворот — в градусах, порядок осей как в lab14.cpp:
+//   модель = T * Rx * Ry * Rz * S
+// Синус и косинус считаются в setRotation, а не при сборке: повороты
+// меняются реже, чем собираются матрицы. Иерархии нет — для неё Transform.
+//
+// compose пересобирает только блоки (по TRANSFORM_STORE_LANES объектов),
+// в которых что-то менялось. Кроме матрицы модели собирается матрица
+// нормалей: для TRS это R * S^-1, обращать матрицу не нужно.
+
+class TransformStore {
+public:
+    static const std::size_t LANES = TRANSFORM_STORE_LANES;
+
+    // Новый объект, возвращает его номер
+    std::size_t add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+        const std::size_t index = count++;
+        if (index == padded) grow();
+        setPosition(index, position);
+        setRotation(index, rotation);
+        setScale(index, scale);
+        return index;
+    }
+
+    void setPosition(std::size_t i, const glm::vec3& p) {
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+        markDirty(i);
+    }
+
+    void setRotation(std::size_t i, const glm::vec3& degrees) {
+        const float x = glm::radians(degrees.x), y = glm::radians(degrees.y), z = glm::radians(degrees.z);
+        sinX[i] = std::sin(x); cosX[i] = std::cos(x);
+        sinY[i] = std::sin(y); cosY[i] = std::cos(y);
+        sinZ[i] = std::sin(z); cosZ[i] = std::cos(z);
+        markDirty(i);
+    }
+
+    void setScale(std::size_t i, const glm::vec3& s) {
+        sx[i] = s.x; sy[i] = s.y; sz[i] = s.z;
+        markDirty(i);
+    }
+
+    glm::vec3 position(std::size_t i) const { return glm::vec3(px[i], py[i], pz[i]); }
+
+    // Пересобрать матрицы изменённых объектов; возвращает число блоков
+    std::size_t compose() {
+        std::size_t composed = 0;
+        for (std::size_t block = 0; block < dirty.size(); ++block) {
+            if (!dirty[block]) continue;
+            composeBlock(block * LANES);
+            dirty[block] = 0;
+            ++composed;
+        }
+        return composed;
+    }
+
+    // Все матрицы заново, без учёта флагов (для замеров)
+    void composeAll() {
+        for (std::size_t first = 0; first < padded; first += LANES) composeBlock(first);
+        std::fill(dirty.begin(), dirty.end(), std::uint8_t(0));
+    }
+
+    // Действительны после compose
+    const glm::mat4& model(std::size_t i) const { return models[i]; }
+    // Столбцы матрицы нормалей, w не используется (раскладка InstanceData::normal)
+    const glm::vec4* normal(std::size_t i) const { return normals[i].columns; }
+
+    std::size_t size() const { return count; }
+
+private:
+    struct NormalColumns {
+        glm::vec4 columns[3];
+    };
+
+    void grow() {
+        padded += LANES;
+        // хвостовые объекты блока — единичные, чтобы ядрам не нужна была обработка остатка
+        for (std::vector<float>* a : { &px, &py, &pz, &sinX, &sinY, &sinZ }) a->resize(padded, 0.0f);
+        for (std::vector<float>* a : { &cosX, &cosY, &cosZ, &sx, &sy, &sz }) a->resize(padded, 1.0f);
+        models.resize(padded, glm::mat4(1.0f));
+        normals.resize(padded);
+        dirty.push_back(1);
+    }
+
+    void markDirty(std::size_t i) { dirty[i / LANES] = 1; }
+
+#if TRANSFORM_STORE_LANES == 8
+    // Четыре вектора x, y, z, w по 8 объектов — столбец column у каждого
+    static void storeColumns(float* out, std::size_t stride, std::size_t column,
+                             __m256 x, __m256 y, __m256 z, __m256 w) {
+        const __m256 t0 = _mm256_unpacklo_ps(x, y), t1 = _mm256_unpackhi_ps(x, y);
+        const __m256 t2 = _mm256_unpacklo_ps(z, w), t3 = _mm256_unpackhi_ps(z, w);
+        const __m256 v[4] = {
+            _mm256_shuffle_ps(t0, t2, 0x44), _mm256_shuffle_ps(t0, t2, 0xEE),
+            _mm256_shuffle_ps(t1, t3, 0x44), _mm256_shuffle_ps(t1, t3, 0xEE),
+        };
+        for (std::size_t k = 0; k < 4; ++k) {
+            _mm_storeu_ps(out + k * stride + column * 4, _mm256_castps256_ps128(v[k]));
+            _mm_storeu_ps(out + (k + 4) * stride + column * 4, _mm256_extractf128_ps(v[k], 1));
+        }
+    }
+
+    void composeBlock(std::size_t first) {
+        const __m256 one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+        const __m256 sa = _mm256_loadu_ps(&sinX[first]), ca = _mm256_loadu_ps(&cosX[first]);
+        const __m256 sb = _mm256_loadu_ps(&sinY[first]), cb = _mm256_loadu_ps(&cosY[first]);
+        const __m256 sc = _mm256_loadu_ps(&sinZ[first]), cc = _mm256_loadu_ps(&cosZ[first]);
+        const __m256 scaleX = _mm256_loadu_ps(&sx[first]);
+        const __m256 scaleY = _mm256_loadu_ps(&sy[first]);
+        const __m256 scaleZ = _mm256_loadu_ps(&sz[first]);
+
+        // Rx * Ry * Rz по столбцам
+        const __m256 sbcc = _mm256_mul_ps(sb, cc), sbsc = _mm256_mul_ps(sb, sc);
+        const __m256 r00 = _mm256_mul_ps(cb, cc);
+        const __m256 r10 = _mm256_add_ps(_mm256_mul_ps(ca, sc), _mm256_mul_ps(sa, sbcc));
+        const __m256 r20 = _mm256_sub_ps(_mm256_mul_ps(sa, sc), _mm256_mul_ps(ca, sbcc));
+        const __m256 r01 = _mm256_sub_ps(zero, _mm256_mul_ps(cb, sc));
+        const __m256 r11 = _mm256_sub_ps(_mm256_mul_ps(ca, cc), _mm256_mul_ps(sa, sbsc));
+        const __m256 r21 = _mm256_add_ps(_mm256_mul_ps(sa, cc), _mm256_mul_ps(ca, sbsc));
+        const __m256 r02 = sb;
+        const __m256 r12 = _mm256_sub_ps(zero, _mm256_mul_ps(sa, cb));
+        const __m256 r22 = _mm256_mul_ps(ca, cb);
+
+        float* m = &models[first][0][0];
+        const std::size_t ms = sizeof(glm::mat4) / sizeof(float);
+        storeColumns(m, ms, 0, _mm256_mul_ps(r00, scaleX), _mm256_mul_ps(r10, scaleX), _mm256_mul_ps(r20, scaleX), zero);
+        storeColumns(m, ms, 1, _mm256_mul_ps(r01, scaleY), _mm256_mul_ps(r11, scaleY), _mm256_mul_ps(r21, scaleY), zero);
+        storeColumns(m, ms, 2, _mm256_mul_ps(r02, scaleZ), _mm256_mul_ps(r12, scaleZ), _mm256_mul_ps(r22, scaleZ), zero);
+        storeColumns(m, ms, 3, _mm256_loadu_ps(&px[first]), _mm256_loadu_ps(&py[first]), _mm256_loadu_ps(&pz[first]), one);
+
+        const __m256 invX = _mm256_div_ps(one, scaleX);
+        const __m256 invY = _mm256_div_ps(one, scaleY);
+        const __m256 invZ = _mm256_div_ps(one, scaleZ);
+        float* n = &normals[first].columns[0].x;
+        const std::size_t ns = sizeof(NormalColumns) / sizeof(float);
+        storeColumns(n, ns, 0, _mm256_mul_ps(r00, invX), _mm256_mul_ps(r10, invX), _mm256_mul_ps(r20, invX), zero);
+        storeColumns(n, ns, 1, _mm256_mul_ps(r01, invY), _mm256_mul_ps(r11, invY), _mm256_mul_ps(r21, invY), zero);
+        storeColumns(n, ns, 2, _mm256_mul_ps(r02, invZ), _mm256_mul_ps(r12, invZ), _mm256_mul_ps(r22, invZ), zero);
+    }
+#elif TRANSFORM_STORE_LANES == 4
+    // Четыре вектора x, y, z, w по 4 объекта — столбец column у каждого
+    static void storeColumns(float* out, std::size_t stride, std::size_t column,
+                             __m128 x, __m128 y, __m128 z, __m128 w) {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(out + column * 4, x);
+        _mm_storeu_ps(out + stride + column * 4, y);
+        _mm_storeu_ps(out + 2 * stride + column * 4, z);
+        _mm_storeu_ps(out + 3 * stride + column * 4, w);
+    }
+
+    void composeBlock(std::size_t first) {
+        const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+        const __m128 sa = _mm_loadu_ps(&sinX[first]), ca = _mm_loadu_ps(&cosX[first]);
+        const __m128 sb = _mm_loadu_ps(&sinY[first]), cb = _mm_loadu_ps(&cosY[first]);
+        const __m128 sc = _mm_loadu_ps(&sinZ[first]), cc = _mm_loadu_ps(&cosZ[first]);
+        const __m128 scaleX = _mm_loadu_ps(&sx[first]);
+        const __m128 scaleY = _mm_loadu_ps(&sy[first]);
+        const __m128 scaleZ = _mm_loadu_ps(&sz[first]);
+
+        // Rx * Ry * Rz по столбцам
+        const __m128 sbcc = _mm_mul_ps(sb, cc), sbsc = _mm_mul_ps(sb, sc);
+        const __m128 r00 = _mm_mul_ps(cb, cc);
+        const __m128 r10 = _mm_add_ps(_mm_mul_ps(ca, sc), _mm_mul_ps(sa, sbcc));
+        const __m128 r20 = _mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(ca, sbcc));
+        const __m128 r01 = _mm_sub_ps(zero, _mm_mul_ps(cb, sc));
+        const __m128 r11 = _mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sa, sbsc));
+        const __m128 r21 = _mm_add_ps(_mm_mul_ps(sa, cc), _mm_mul_ps(ca, sbsc));
+        const __m128 r02 = sb;
+        const __m128 r12 = _mm_sub_ps(zero, _mm_mul_ps(sa, cb));
+        const __m128 r22 = _mm_mul_ps(ca, cb);
+
+        float* m = &models[first][0][0];
+        const std::size_t ms = sizeof(glm::mat4) / sizeof(float);
+        storeColumns(m, ms, 0, _mm_mul_ps(r00, scaleX), _mm_mul_ps(r10, scaleX), _mm_mul_ps(r20, scaleX), zero);
+        storeColumns(m, ms, 1, _mm_mul_ps(r01, scaleY), _mm_mul_ps(r11, scaleY), _mm_mul_ps(r21, scaleY), zero);
+        storeColumns(m, ms, 2, _mm_mul_ps(r02, scaleZ), _mm_mul_ps(r12, scaleZ), _mm_mul_ps(r22, scaleZ), zero);
+        storeColumns(m, ms, 3, _mm_loadu_ps(&px[first]), _mm_loadu_ps(&py[first]), _mm_loadu_ps(&pz[first]), one);
+
+        const __m128 invX = _mm_div_ps(one, scaleX);
+        const __m128 invY = _mm_div_ps(one, scaleY);
+        const __m128 invZ = _mm_div_ps(one, scaleZ);
+        float* n = &normals[first].columns[0].x;
+        const std::size_t ns = sizeof(NormalColumns) / sizeof(float);
+        storeColumns(n, ns, 0, _mm_mul_ps(r00, invX), _mm_mul_ps(r10, invX), _mm_mul_ps(r20, invX), zero);
+        storeColumns(n, ns, 1, _mm_mul_ps(r01, invY), _mm_mul_ps(r11, invY), _mm_mul_ps(r21, invY), zero);
+        storeColumns(n, ns, 2, _mm_mul_ps(r02, invZ), _mm_mul_ps(r12, invZ), _mm_mul_ps(r22, invZ), zero);
+    }
+#else
+    // Без SSE (ARM и др.): тот же расчёт по одному объекту
+    void composeBlock(std::size_t i) {
+        const float sa = sinX[i], ca = cosX[i], sb = sinY[i], cb = cosY[i], sc = sinZ[i], cc = cosZ[i];
+        const glm::vec3 c0(cb * cc, ca * sc + sa * sb * cc, sa * sc - ca * sb * cc);
+        const glm::vec3 c1(-cb * sc, ca * cc - sa * sb * sc, sa * cc + ca * sb * sc);
+        const glm::vec3 c2(sb, -sa * cb, ca * cb);
+        glm::mat4& m = models[i];
+        m[0] = glm::vec4(c0 * sx[i], 0.0f);
+        m[1] = glm::vec4(c1 * sy[i], 0.0f);
+        m[2] = glm::vec4(c2 * sz[i], 0.0f);
+        m[3] = glm::vec4(px[i], py[i], pz[i], 1.0f);
+        NormalColumns& n = normals[i];
+        n.columns[0] = glm::vec4(c0 / sx[i], 0.0f);
+        n.columns[1] = glm::vec4(c1 / sy[i], 0.0f);
+        n.columns[2] = glm::vec4(c2 / sz[i], 0.0f);
+    }
+#endif
+
+    std::size_t count = 0, padded = 0;
+    std::vector<float> px, py, pz;
+    std::vector<float> sinX, cosX, sinY, cosY, sinZ, cosZ;
+    std::vector<float> sx, sy, sz;
+    std::vector<glm::mat4> models;
+    std::vector<NormalColumns> normals;
+    std::vector<std::uint8_t> dirty;   // по блоку из LANES объектов
+};
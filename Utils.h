@@ -2,14 +2,20 @@
 #include <gl/glew.h>
 #include <SFML/Graphics.hpp>
 #include <glm/glm.hpp>
-#include <unordered_map>
 #include <tuple>
+#include <array>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <memory>
+#include "MappedFile.h"
+#include "ObjParser.h"
+#include "ThreadPool.h"
+#include "IndexTripleTable.h"
+#include "VertexQuantization.h"
+#include "UniformTable.h"
 
 struct Vertex {
     glm::vec3 position{};
@@ -17,11 +23,81 @@ struct Vertex {
     glm::vec2 texCoord{};
 };
 
+// Uniform'ы распаковки вершин в шейдере (см. Mesh::setDequantizeUniforms)
+constexpr UniformKey UNIFORM_QUANT_OFFSET("quantOffset");
+constexpr UniformKey UNIFORM_QUANT_SCALE("quantScale");
+constexpr UniformKey UNIFORM_OCT_NORMALS("octNormals");
+
 struct Mesh {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     GLuint vao = 0, vbo = 0, ebo = 0;
+    GLsizei uploadedIndexCount = 0; // сколько индексов загружено в ebo
+
+    // Ограничивающие объёмы в координатах модели (computeBounds):
+    // коробка и сфера с центром в центре коробки
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    // Упаковать вершины при uploadToGPU в PackedVertex (VertexQuantization.h):
+    // вдвое меньше памяти и трафика вершин. Шейдер должен уметь распаковку
+    // (quantOffset/quantScale/octNormals), см. setDequantizeUniforms.
+    bool quantize = false;
+    VertexQuantization quantization;   // параметры и ошибка загруженного буфера
 
+    // Геометрия из бинарного кэша (см. MeshCache.h): указатели смотрят
+    // прямо в отображённый файл, векторы vertices/indices при этом пусты.
+    // Отображение освобождается после uploadToGPU.
+    std::shared_ptr<MappedFile> mapping;
+    const Vertex* mappedVertices = nullptr;
+    const unsigned int* mappedIndices = nullptr;
+    std::size_t mappedVertexCount = 0;
+    std::size_t mappedIndexCount = 0;
+
+    std::size_t vertexCount() const { return mapping ? mappedVertexCount : vertices.size(); }
+    std::size_t indexCount() const { return mapping ? mappedIndexCount : indices.size(); }
+    const Vertex* vertexData() const { return mapping ? mappedVertices : vertices.data(); }
+    const unsigned int* indexData() const { return mapping ? mappedIndices : indices.data(); }
+
+    // Скопировать геометрию из отображения в векторы (для обработки на CPU)
+    void copyMappedToVectors() {
+        if (!mapping) return;
+        vertices.assign(mappedVertices, mappedVertices + mappedVertexCount);
+        indices.assign(mappedIndices, mappedIndices + mappedIndexCount);
+        releaseMapping();
+    }
+
+    // Пересчитать bounds* по вершинам (векторы или отображение кэша)
+    void computeBounds() {
+        const Vertex* v = vertexData();
+        const std::size_t n = vertexCount();
+        if (n == 0) {
+            boundsMin = boundsMax = boundsCenter = glm::vec3(0.0f);
+            boundsRadius = 0.0f;
+            return;
+        }
+        boundsMin = boundsMax = v[0].position;
+        for (std::size_t i = 1; i < n; ++i) {
+            boundsMin = glm::min(boundsMin, v[i].position);
+            boundsMax = glm::max(boundsMax, v[i].position);
+        }
+        boundsCenter = (boundsMin + boundsMax) * 0.5f;
+        float radius2 = 0.0f;
+        for (std::size_t i = 0; i < n; ++i) {
+            const glm::vec3 d = v[i].position - boundsCenter;
+            radius2 = std::max(radius2, glm::dot(d, d));
+        }
+        boundsRadius = std::sqrt(radius2);
+    }
+
+    void releaseMapping() {
+        mapping.reset();
+        mappedVertices = nullptr;
+        mappedIndices = nullptr;
+        mappedVertexCount = mappedIndexCount = 0;
+    }
 
     void uploadToGPU() {
         glGenVertexArrays(1, &vao);
@@ -30,144 +106,403 @@ struct Mesh {
 
         glBindVertexArray(vao);
 
+        // из кэша данные уходят в драйвер прямо из отображения файла
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER,
-            vertices.size() * sizeof(Vertex),
-            vertices.data(),
-            GL_STATIC_DRAW);
+        std::vector<PackedVertex> packed;
+        if (quantize) {
+            quantization = quantizeVertices(vertexData(), vertexCount(), packed);
+            glBufferData(GL_ARRAY_BUFFER,
+                packed.size() * sizeof(PackedVertex),
+                packed.data(),
+                GL_STATIC_DRAW);
+        }
+        else {
+            quantization = VertexQuantization();
+            glBufferData(GL_ARRAY_BUFFER,
+                vertexCount() * sizeof(Vertex),
+                vertexData(),
+                GL_STATIC_DRAW);
+        }
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            indices.size() * sizeof(unsigned int),
-            indices.data(),
+            indexCount() * sizeof(unsigned int),
+            indexData(),
             GL_STATIC_DRAW);
+        uploadedIndexCount = static_cast<GLsizei>(indexCount());
 
-        // позиция
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-            sizeof(Vertex), (void*)0);
-        // нормаль
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-            sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        // tex‑coord
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
-            sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        if (quantize) {
+            // позиция: uint16 -> [0, 1], дальше quantOffset + p * quantScale
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+            // нормаль: 2 x snorm16, z = 0, разворачивается octDecode
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE,
+                sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+            // tex‑coord: half float
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE,
+                sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+        }
+        else {
+            // позиция
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                sizeof(Vertex), (void*)0);
+            // нормаль
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+                sizeof(Vertex), (void*)offsetof(Vertex, normal));
+            // tex‑coord
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
+                sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        }
 
         glBindVertexArray(0);
+
+        // GPU получил свою копию — отображение больше не нужно
+        releaseMapping();
+    }
+
+    // Параметры распаковки для программы uniforms (она должна быть активна).
+    // У неупакованного меша — тождественные, так что одна программа
+    // рисует оба формата.
+    void setDequantizeUniforms(const UniformTable& uniforms) const {
+        glUniform3fv(uniforms[UNIFORM_QUANT_OFFSET], 1, &quantization.offset[0]);
+        glUniform3fv(uniforms[UNIFORM_QUANT_SCALE], 1, &quantization.scale[0]);
+        glUniform1i(uniforms[UNIFORM_OCT_NORMALS], quantization.packed ? 1 : 0);
     }
 
     void draw() const {
         glBindVertexArray(vao);
         glDrawElements(GL_TRIANGLES,
-            static_cast<GLsizei>(indices.size()),
+            uploadedIndexCount,
             GL_UNSIGNED_INT, nullptr);
         glBindVertexArray(0);
     }
+
+    // То же без привязки VAO: его уже привязал вызывающий (RenderStateCache
+    // в RenderQueue.h не перепривязывает VAO между объектами с одним мешем)
+    void drawBound() const {
+        glDrawElements(GL_TRIANGLES,
+            uploadedIndexCount,
+            GL_UNSIGNED_INT, nullptr);
+    }
+
+    // count экземпляров за один вызов, VAO уже привязан (Instancing.h)
+    void drawBoundInstanced(GLsizei count) const {
+        glDrawElementsInstanced(GL_TRIANGLES,
+            uploadedIndexCount,
+            GL_UNSIGNED_INT, nullptr, count);
+    }
+
+    // Несколько диапазонов индексов за один вызов — например, видимые
+    // мешлеты после cullMeshlets (Meshlets.h); offsets в байтах
+    void drawRanges(const GLsizei* counts, const void* const* offsets, GLsizei rangeCount) const {
+        if (rangeCount == 0) return;
+        glBindVertexArray(vao);
+        glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets, rangeCount);
+        glBindVertexArray(0);
+    }
+
+    void cleanup() {
+        if (ebo) glDeleteBuffers(1, &ebo);
+        if (vbo) glDeleteBuffers(1, &vbo);
+        if (vao) glDeleteVertexArrays(1, &vao);
+        ebo = 0;
+        vbo = 0;
+        vao = 0;
+        uploadedIndexCount = 0;
+    }
 };
 
 /* ------------------------------------------------------------------ */
-// Хеш‑функция для кортежа (posIdx, texIdx, normIdx)
-struct IndexTripleHash {
-    std::size_t operator()(const std::tuple<int, int, int>& t) const noexcept {
-        std::size_t h1 = std::hash<int>{}(std::get<0>(t));
-        std::size_t h2 = std::hash<int>{}(std::get<1>(t));
-        std::size_t h3 = std::hash<int>{}(std::get<2>(t));
-        // простое комбинирование
-        return ((h1 ^ (h2 << 1)) >> 1) ^ (h3 << 1);
-    }
+// Отчёт об упаковке вершин меша после uploadToGPU с quantize = true
+void printQuantizationReport(const std::string& name, const VertexQuantization& q) {
+    if (!q.packed) return;
+    const float extent = std::max({ q.scale.x, q.scale.y, q.scale.z });
+    std::cout << name << ": vertices " << q.vertexCount << ", "
+              << q.vertexCount * sizeof(Vertex) / 1024 << " KB -> "
+              << q.vertexCount * sizeof(PackedVertex) / 1024 << " KB"
+              << "; max error: position " << q.maxPositionError
+              << " (" << (extent > 0.0f ? 100.0f * q.maxPositionError / extent : 0.0f) << "% of bounds)"
+              << ", normal " << q.maxNormalError << " deg"
+              << ", uv " << q.maxTexCoordError << '\n';
+}
+
+/* ------------------------------------------------------------------ */
+// Индекс OBJ -> 0‑база; отрицательные считаются от конца уже прочитанного.
+// 0 означает «индекс не указан» и даёт -1.
+int resolveOBJIndex(int idx, std::size_t count) {
+    if (idx > 0) return idx - 1;
+    if (idx < 0) return idx + static_cast<int>(count);
+    return -1;
+}
+
+/* ------------------------------------------------------------------ */
+// Кусок OBJ‑файла, выровненный по границам строк.
+// Разбирается независимо; базовые смещения v/vt/vn известны заранее
+// из первого прохода, поэтому относительные (отрицательные) индексы
+// разрешаются так же, как при последовательном чтении.
+struct OBJChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    std::size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    std::size_t positionBase = 0, texCoordBase = 0, normalBase = 0;
+
+    // треугольники после веерной триангуляции: по три (pos, tex, norm);
+    // после dedupOBJChunk — только уникальные тройки куска
+    std::vector<std::tuple<int, int, int>> corners;
+    // после dedupOBJChunk: номер тройки в corners для каждого угла
+    std::vector<unsigned int> cornerVertex;
 };
 
+// Индексы вне списков (битый или обрезанный файл) дают нулевой атрибут;
+// приводим их к -1 до таблицы дедупликации, чтобы такие углы сливались,
+// а не копились в одной корзине
+void clampOBJCorner(std::tuple<int, int, int>& corner,
+                    std::size_t positionCount, std::size_t texCoordCount, std::size_t normalCount) {
+    int& pi = std::get<0>(corner);
+    int& ti = std::get<1>(corner);
+    int& ni = std::get<2>(corner);
+    if (pi < 0 || static_cast<std::size_t>(pi) >= positionCount) pi = -1;
+    if (ti < 0 || static_cast<std::size_t>(ti) >= texCoordCount) ti = -1;
+    if (ni < 0 || static_cast<std::size_t>(ni) >= normalCount) ni = -1;
+}
+
+// Первый проход: только считаем записи v/vt/vn
+void countOBJChunk(OBJChunk& chunk) {
+    ObjCursor cur(chunk.begin, chunk.end);
+    while (!cur.eof()) {
+        switch (cur.readRecord()) {
+            case OBJ_POSITION: ++chunk.positionCount; break;
+            case OBJ_TEXCOORD: ++chunk.texCoordCount; break;
+            case OBJ_NORMAL:   ++chunk.normalCount;   break;
+            default: break;
+        }
+        cur.nextLine();
+    }
+}
+
+// Второй проход: атрибуты пишутся сразу на свои места в общих массивах,
+// грани — в локальный список углов куска
+void parseOBJChunk(OBJChunk& chunk, glm::vec3* positions, glm::vec2* texCoords, glm::vec3* normals) {
+    std::size_t pCount = chunk.positionBase;
+    std::size_t tCount = chunk.texCoordBase;
+    std::size_t nCount = chunk.normalBase;
+
+    // вершины текущей грани; буфер переиспользуется между строками
+    std::vector<std::tuple<int, int, int>> faceIndices;
+
+    ObjCursor cur(chunk.begin, chunk.end);
+    while (!cur.eof()) {
+        switch (cur.readRecord()) {
+            case OBJ_POSITION: {
+                glm::vec3 p(0.0f);
+                cur.readFloat(p.x); cur.readFloat(p.y); cur.readFloat(p.z);
+                positions[pCount++] = p;
+                break;
+            }
+            case OBJ_TEXCOORD: {
+                glm::vec2 t(0.0f);
+                cur.readFloat(t.x); cur.readFloat(t.y);
+                texCoords[tCount++] = t;
+                break;
+            }
+            case OBJ_NORMAL: {
+                glm::vec3 n(0.0f);
+                cur.readFloat(n.x); cur.readFloat(n.y); cur.readFloat(n.z);
+                normals[nCount++] = n;
+                break;
+            }
+            case OBJ_FACE: {
+                faceIndices.clear();
+                int rawV, rawT, rawN;
+                while (cur.readFaceVertex(rawV, rawT, rawN)) {
+                    // OBJ‑индексация начинается с 1, переводим в 0‑базу
+                    faceIndices.emplace_back(resolveOBJIndex(rawV, pCount),
+                                             resolveOBJIndex(rawT, tCount),
+                                             resolveOBJIndex(rawN, nCount));
+                }
+                // Triangulation fan‑style: (0, i, i+1)
+                for (size_t i = 1; i + 1 < faceIndices.size(); ++i) {
+                    chunk.corners.push_back(faceIndices[0]);
+                    chunk.corners.push_back(faceIndices[i]);
+                    chunk.corners.push_back(faceIndices[i + 1]);
+                }
+                break;
+            }
+            default:
+                // остальные префиксы (mtllib, usemtl, o, s и т.п.) игнорируем
+                break;
+        }
+        cur.nextLine();
+    }
+}
+
+// Дедупликация внутри куска (параллельный loadOBJ): corners сжимается до
+// уникальных троек в порядке первого появления, cornerVertex получает
+// номер тройки для каждого угла. Таблица строится только на диапазон
+// позиций, на которые ссылается кусок, и живёт до конца вызова
+void dedupOBJChunk(OBJChunk& chunk,
+                   std::size_t positionCount, std::size_t texCoordCount, std::size_t normalCount) {
+    int lo = 0, hi = -1;
+    for (auto& corner : chunk.corners) {
+        clampOBJCorner(corner, positionCount, texCoordCount, normalCount);
+        const int pi = std::get<0>(corner);
+        if (pi < 0) continue;
+        if (hi < lo) lo = hi = pi;
+        else { lo = std::min(lo, pi); hi = std::max(hi, pi); }
+    }
+
+    // сдвиг на lo взаимно однозначен, -1 остаётся вне диапазона
+    IndexTripleTable localCache(static_cast<std::size_t>(hi - lo + 1));
+    std::vector<std::tuple<int, int, int>> unique;
+    chunk.cornerVertex.resize(chunk.corners.size());
+    for (std::size_t i = 0; i < chunk.corners.size(); ++i) {
+        const auto& corner = chunk.corners[i];
+        const int pi = std::get<0>(corner);
+        bool inserted;
+        chunk.cornerVertex[i] = localCache.findOrInsert(pi < 0 ? -1 : pi - lo, std::get<1>(corner), std::get<2>(corner),
+            static_cast<unsigned int>(unique.size()), inserted);
+        if (inserted) unique.push_back(corner);
+    }
+    chunk.corners.swap(unique);
+}
+
+// Делит текст на ~chunkCount кусков по границам строк
+std::vector<OBJChunk> splitOBJ(const char* data, std::size_t size, std::size_t chunkCount) {
+    std::vector<OBJChunk> chunks;
+    const char* end = data + size;
+    const char* begin = data;
+    for (std::size_t i = 1; i <= chunkCount && begin < end; ++i) {
+        const char* split = (i == chunkCount) ? end : data + size / chunkCount * i;
+        if (split < begin) split = begin;
+        while (split < end && *split != '\n') ++split;
+        if (split < end) ++split;                  // '\n' остаётся в этом куске
+
+        OBJChunk chunk;
+        chunk.begin = begin;
+        chunk.end = split;
+        chunks.push_back(std::move(chunk));
+        begin = split;
+    }
+    return chunks;
+}
+
 /* ------------------------------------------------------------------ */
-// Улучшенный загрузчик
-bool loadOBJ(const std::string& path, Mesh& outMesh) {
+// Загрузчик: файл отображается в память и разбирается ObjCursor'ом
+// без istringstream и без аллокаций на каждую строку.
+//
+// threads > 1 включает параллельный режим (0 — по числу ядер): файл
+// режется на куски по строкам, куски разбираются на ThreadPool::shared().
+// Дедупликация тоже параллельна: каждый кусок сводит свои углы к
+// уникальным тройкам (dedupOBJChunk), последовательно через общую таблицу
+// проходят только эти тройки, по кускам в исходном порядке, а индексы
+// переводятся в общие снова параллельно. Первое появление тройки в файле
+// остаётся первым, поэтому вершины и индексы получаются ровно такими же,
+// как при threads == 1.
+bool loadOBJ(const std::string& path, Mesh& outMesh, unsigned threads = 1) {
     std::vector<glm::vec3> positions;
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> texCoords;
 
-    std::unordered_map<std::tuple<int, int, int>, unsigned int, IndexTripleHash> vertexCache;
-
-    std::ifstream file(path);
-    if (!file) {
+    MappedFile file;
+    if (!file.open(path)) {
         std::cerr << "Cannot open OBJ file: " << path << '\n';
         return false;
     }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        // игнорируем пустые строки и комментарии
-        if (line.empty() || line[0] == '#') continue;
+    // мелкие файлы делить не имеет смысла
+    const std::size_t minChunkBytes = 1 << 20;
+    ThreadPool& pool = ThreadPool::shared();
+    if (threads == 0) threads = pool.size();
+    std::size_t chunkCount = std::min<std::size_t>(threads, file.size() / minChunkBytes);
+    if (chunkCount < 1) chunkCount = 1;
+    // по несколько кусков на поток — меньше простоев на неравных кусках
+    if (chunkCount > 1) chunkCount *= 4;
+
+    std::vector<OBJChunk> chunks = splitOBJ(file.data(), file.size(), chunkCount);
+
+    pool.parallelFor(chunks.size(), threads, [&](std::size_t i) { countOBJChunk(chunks[i]); });
+
+    std::size_t pTotal = 0, tTotal = 0, nTotal = 0;
+    for (auto& chunk : chunks) {
+        chunk.positionBase = pTotal; pTotal += chunk.positionCount;
+        chunk.texCoordBase = tTotal; tTotal += chunk.texCoordCount;
+        chunk.normalBase = nTotal;   nTotal += chunk.normalCount;
+    }
+    positions.resize(pTotal);
+    texCoords.resize(tTotal);
+    normals.resize(nTotal);
 
-        std::istringstream ss(line);
-        std::string prefix; ss >> prefix;
+    pool.parallelFor(chunks.size(), threads, [&](std::size_t i) {
+        parseOBJChunk(chunks[i], positions.data(), texCoords.data(), normals.data());
+    });
 
-        if (prefix == "v") {                     // позиция
-            glm::vec3 p; ss >> p.x >> p.y >> p.z;
-            positions.push_back(p);
+    if (chunks.size() > 1) {
+        pool.parallelFor(chunks.size(), threads, [&](std::size_t i) {
+            dedupOBJChunk(chunks[i], pTotal, tTotal, nTotal);
+        });
+    }
+
+    std::size_t cornerTotal = 0;
+    for (const auto& chunk : chunks)
+        cornerTotal += chunks.size() > 1 ? chunk.cornerVertex.size() : chunk.corners.size();
+    outMesh.indices.reserve(outMesh.indices.size() + cornerTotal);
+
+    // Таблица по числу позиций — точному, а не оценке, так что она не
+    // перестраивается. Вершин у замкнутой треугольной сетки около
+    // (число углов) / 6, но не меньше, чем самый длинный из списков v/vt/vn
+    IndexTripleTable vertexCache(pTotal);
+    const std::size_t expectedVertices = std::max({ cornerTotal / 6, pTotal, tTotal, nTotal });
+    outMesh.vertices.reserve(outMesh.vertices.size() + expectedVertices);
+
+    // Если уже есть такая комбинация — её индекс, иначе новый Vertex
+    auto mergeCorner = [&](const std::tuple<int, int, int>& corner) {
+        int pi, ti, ni;
+        std::tie(pi, ti, ni) = corner;
+        bool inserted;
+        unsigned int index = vertexCache.findOrInsert(pi, ti, ni,
+            static_cast<unsigned int>(outMesh.vertices.size()), inserted);
+        if (inserted) {
+            Vertex v{};
+            v.position = pi >= 0 ? positions[pi] : glm::vec3(0.0f);
+            v.normal = ni >= 0 ? normals[ni] : glm::vec3(0.0f);
+            v.texCoord = ti >= 0 ? texCoords[ti] : glm::vec2(0.0f);
+            outMesh.vertices.push_back(v);
         }
-        else if (prefix == "vt") {               // tex‑coord
-            glm::vec2 t; ss >> t.x >> t.y;
-            texCoords.push_back(t);
+        return index;
+    };
+
+    if (chunks.size() == 1) {
+        // Слияние: дедупликация строго в порядке файла
+        for (auto& corner : chunks[0].corners) {
+            clampOBJCorner(corner, pTotal, tTotal, nTotal);
+            outMesh.indices.push_back(mergeCorner(corner));
         }
-        else if (prefix == "vn") {               // нормаль
-            glm::vec3 n; ss >> n.x >> n.y >> n.z;
-            normals.push_back(n);
+        std::vector<std::tuple<int, int, int>>().swap(chunks[0].corners);
+    }
+    else {
+        // Слияние: через общую таблицу идут только уникальные тройки
+        // кусков, по порядку; remap[c][k] — общий номер k-й тройки куска c
+        std::vector<std::vector<unsigned int>> remap(chunks.size());
+        std::vector<std::size_t> indexBase(chunks.size());
+        std::size_t indexTotal = outMesh.indices.size();
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            remap[c].reserve(chunks[c].corners.size());
+            for (const auto& corner : chunks[c].corners) remap[c].push_back(mergeCorner(corner));
+            std::vector<std::tuple<int, int, int>>().swap(chunks[c].corners);
+            indexBase[c] = indexTotal;
+            indexTotal += chunks[c].cornerVertex.size();
         }
-        else if (prefix == "f") {                // грань
-            // читаем все вершины грани в вектор
-            std::vector<std::tuple<int, int, int>> faceIndices;
-            std::string vertStr;
-            while (ss >> vertStr) {
-                // заменяем '/' на пробел, чтобы легко разобрать
-                std::replace(vertStr.begin(), vertStr.end(), '/', ' ');
-                std::istringstream vs(vertStr);
-                int vi = 0, ti = 0, ni = 0;
-                vs >> vi;                     // позиция всегда есть
-                if (vs.peek() != EOF) vs >> ti; // tex‑coord может отсутствовать
-                if (vs.peek() != EOF) vs >> ni; // нормаль может отсутствовать
-
-                // OBJ‑индексация начинается с 1, переводим в 0‑базу
-                vi = (vi > 0) ? vi - 1 : vi + static_cast<int>(positions.size());
-                ti = (ti > 0) ? ti - 1 : ti + static_cast<int>(texCoords.size());
-                ni = (ni > 0) ? ni - 1 : ni + static_cast<int>(normals.size());
-
-                faceIndices.emplace_back(vi, ti, ni);
-            }
 
-            // Triangulation fan‑style: (0, i, i+1)
-            for (size_t i = 1; i + 1 < faceIndices.size(); ++i) {
-                std::array<std::tuple<int, int, int>, 3> tri = {
-                    faceIndices[0],
-                    faceIndices[i],
-                    faceIndices[i + 1]
-                };
-
-                for (const auto& idxTuple : tri) {
-                    // Если уже есть такая комбинация — используем её индекс
-                    auto it = vertexCache.find(idxTuple);
-                    if (it != vertexCache.end()) {
-                        outMesh.indices.push_back(it->second);
-                        continue;
-                    }
-
-                    // Иначе создаём новый Vertex
-                    Vertex v{};
-                    int pi, ti, ni;
-                    std::tie(pi, ti, ni) = idxTuple;
-
-                    v.position = positions[pi];
-                    v.normal = (ni >= 0 && ni < static_cast<int>(normals.size())) ? normals[ni] : glm::vec3(0.0f);
-                    v.texCoord = (ti >= 0 && ti < static_cast<int>(texCoords.size())) ? texCoords[ti] : glm::vec2(0.0f);
-
-                    unsigned int newIndex = static_cast<unsigned int>(outMesh.vertices.size());
-                    outMesh.vertices.push_back(v);
-                    outMesh.indices.push_back(newIndex);
-                    vertexCache[idxTuple] = newIndex;
-                }
-            }
-        }
-        // остальные префиксы (mtllib, usemtl, o, s и т.п.) игнорируем
+        outMesh.indices.resize(indexTotal);
+        pool.parallelFor(chunks.size(), threads, [&](std::size_t c) {
+            unsigned int* out = outMesh.indices.data() + indexBase[c];
+            for (unsigned int local : chunks[c].cornerVertex) *out++ = remap[c][local];
+            std::vector<unsigned int>().swap(chunks[c].cornerVertex);
+        });
     }
 
     // Если нормали не заданы в файле – посчитаем их усреднением по граням
@@ -191,5 +526,6 @@ bool loadOBJ(const std::string& path, Mesh& outMesh) {
             outMesh.vertices[i].normal = glm::normalize(accum[i]);
     }
 
+    outMesh.computeBounds();
     return true;
 }
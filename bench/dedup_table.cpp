@@ -0,0 +1,199 @@
+// Микробенчмарк дедупликации вершин: прежний
+// std::unordered_map<std::tuple<int,int,int>> с IndexTripleHash против
+// IndexTripleTable. Поток углов треугольников такой же, как в loadOBJ;
+// таблица, как и там, создаётся по числу позиций.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/dedup_table.cpp -o dedup_table
+// Запуск:
+//   ./dedup_table [клеток сетки по стороне, по умолчанию 1000]
+#include "IndexTripleTable.h"
+#include <unordered_map>
+#include <tuple>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+/* ------------------------------------------------------------------ */
+// Прежняя хеш‑функция из Utils.h
+struct IndexTripleHash {
+    std::size_t operator()(const std::tuple<int, int, int>& t) const noexcept {
+        std::size_t h1 = std::hash<int>{}(std::get<0>(t));
+        std::size_t h2 = std::hash<int>{}(std::get<1>(t));
+        std::size_t h3 = std::hash<int>{}(std::get<2>(t));
+        return ((h1 ^ (h2 << 1)) >> 1) ^ (h3 << 1);
+    }
+};
+
+// Аллокатор, считающий текущий и пиковый объём памяти контейнера
+struct AllocStats {
+    static std::size_t current;
+    static std::size_t peak;
+    static std::size_t calls;
+    static void reset() { current = peak = calls = 0; }
+};
+std::size_t AllocStats::current = 0;
+std::size_t AllocStats::peak = 0;
+std::size_t AllocStats::calls = 0;
+
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template <class U> CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        AllocStats::current += n * sizeof(T);
+        ++AllocStats::calls;
+        if (AllocStats::current > AllocStats::peak) AllocStats::peak = AllocStats::current;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) {
+        AllocStats::current -= n * sizeof(T);
+        ::operator delete(p);
+    }
+    template <class U> bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using Key = std::tuple<int, int, int>;
+using LegacyMap = std::unordered_map<Key, unsigned int, IndexTripleHash, std::equal_to<Key>,
+    CountingAllocator<std::pair<const Key, unsigned int>>>;
+
+/* ------------------------------------------------------------------ */
+// Углы треугольников сетки cells x cells квадов (две треугольника на квад)
+// normalMode: 0 — v/vt/vn с одинаковыми индексами, 1 — одна общая нормаль,
+// 2 — плоское затенение (своя нормаль у каждого квада, как у low-poly моделей)
+std::vector<Key> gridCorners(int cells, int normalMode) {
+    std::vector<Key> corners;
+    corners.reserve(static_cast<std::size_t>(cells) * cells * 6);
+    const int n = cells + 1;
+    for (int y = 0; y < cells; ++y)
+        for (int x = 0; x < cells; ++x) {
+            int a = y * n + x, b = a + 1, c = a + n + 1, d = a + n;
+            for (int v : { a, b, c, a, c, d })
+                corners.emplace_back(v, v, normalMode == 0 ? v : normalMode == 1 ? 0 : y * cells + x);
+        }
+    return corners;
+}
+
+// Веер (конус): segments треугольников вокруг общей вершины 0, у каждой
+// грани своя нормаль — тройки с одной позицией, которых столько же, сколько
+// граней. Индексация по позиции здесь вырождается в квадратичную
+std::vector<Key> fanCorners(int segments) {
+    std::vector<Key> corners;
+    corners.reserve(static_cast<std::size_t>(segments) * 3);
+    for (int f = 0; f < segments; ++f) {
+        const int a = 1 + f, b = 1 + (f + 1) % segments;
+        for (int v : { 0, a, b }) corners.emplace_back(v, -1, f);
+    }
+    return corners;
+}
+
+// Тройки, позиция которых вне списка v (битый файл): loadOBJ заменяет её
+// на -1, и все они попадают в одну корзину
+std::vector<Key> invalidCorners(std::size_t count) {
+    std::vector<Key> corners(count);
+    for (std::size_t i = 0; i < count; ++i) corners[i] = Key(-1, static_cast<int>(i % 64), static_cast<int>(i));
+    return corners;
+}
+
+// Случайные тройки без порядка: позиция из [0, range), vt и vn из небольших
+// списков — так выглядят модели, собранные из нескольких частей
+std::vector<Key> randomCorners(std::size_t count, int range) {
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> dist(0, range - 1);
+    std::uniform_int_distribution<int> small(0, 63);
+    std::vector<Key> corners(count);
+    for (auto& k : corners) k = Key(dist(rng), small(rng), small(rng));
+    return corners;
+}
+
+struct Result {
+    double seconds;
+    std::size_t unique;
+    std::size_t peakBytes;
+    std::size_t allocations;
+    std::uint64_t checksum;
+    std::size_t spilled;
+};
+
+Result runLegacy(const std::vector<Key>& corners) {
+    AllocStats::reset();
+    Result r{};
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        LegacyMap vertexCache;
+        unsigned int next = 0;
+        for (const Key& k : corners) {
+            auto it = vertexCache.find(k);
+            if (it != vertexCache.end()) { r.checksum += it->second; continue; }
+            vertexCache[k] = next;
+            r.checksum += next++;
+        }
+        r.unique = vertexCache.size();
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    r.peakBytes = AllocStats::peak;
+    r.allocations = AllocStats::calls;
+    return r;
+}
+
+Result runTable(const std::vector<Key>& corners, std::size_t positionCount) {
+    Result r{};
+    auto t0 = std::chrono::steady_clock::now();
+    IndexTripleTable vertexCache(positionCount);
+    unsigned int next = 0;
+    for (const Key& k : corners) {
+        bool inserted;
+        r.checksum += vertexCache.findOrInsert(std::get<0>(k), std::get<1>(k), std::get<2>(k), next, inserted);
+        if (inserted) ++next;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    r.unique = vertexCache.size();
+    // блоки записей не перевыделяются; при удвоении вторичной таблицы
+    // старая половина ещё жива
+    r.spilled = vertexCache.spilled();
+    r.allocations = vertexCache.allocationCount();
+    r.peakBytes = vertexCache.memoryBytes();
+    return r;
+}
+
+// Длина в символах, а не байтах — для выравнивания колонок
+std::size_t utf8Length(const char* s) {
+    std::size_t n = 0;
+    for (; *s; ++s) n += (static_cast<unsigned char>(*s) & 0xC0) != 0x80;
+    return n;
+}
+
+void report(const char* name, const std::vector<Key>& corners, std::size_t positionCount) {
+    Result legacy = runLegacy(corners);
+    Result table = runTable(corners, positionCount);
+
+    auto line = [&](const char* label, const Result& r) {
+        std::printf("    %s%*s %8.1f ms %8.1f M lookups/s  peak %7.1f MB %9zu аллокаций  %s\n",
+            label, static_cast<int>(30 - utf8Length(label)), "", r.seconds * 1e3, corners.size() / r.seconds / 1e6, r.peakBytes / (1024.0 * 1024.0), r.allocations,
+            r.checksum == legacy.checksum && r.unique == legacy.unique ? "" : "РАЗЛИЧАЕТСЯ");
+    };
+    std::printf("%s: %zu углов, %zu уникальных вершин\n", name, corners.size(), legacy.unique);
+    line("unordered_map<tuple>", legacy);
+    line("IndexTripleTable", table);
+    if (table.spilled) std::printf("    во вторичной таблице %zu записей\n", table.spilled);
+}
+
+int main(int argc, char** argv) {
+    int cells = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+    const std::size_t gridPositions = static_cast<std::size_t>(cells + 1) * (cells + 1);
+    report("сетка v/vt/vn", gridCorners(cells, 0), gridPositions);
+    report("сетка с общей нормалью", gridCorners(cells, 1), gridPositions);
+    report("сетка с плоским затенением", gridCorners(cells, 2), gridPositions);
+    report("веер вокруг общей вершины", fanCorners(cells * 60), static_cast<std::size_t>(cells) * 60 + 1);
+    report("тройки без позиции", invalidCorners(static_cast<std::size_t>(cells) * 60), 1);
+    report("случайные тройки", randomCorners(static_cast<std::size_t>(cells) * cells, cells * cells / 4),
+        static_cast<std::size_t>(cells) * cells / 4);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Кластерное назначение источников (lab14/LightClusters.h): время на CPU в
+// зависимости от числа источников, 64..4096, при сетке 16x9x24 и
+// перспективе lab14 (60°, 16:9, 0.1..100). GPU не нужен.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. -Ilab14 bench/light_clusters.cpp -o light_clusters
+// Запуск:
+//   ./light_clusters
+//
+// Источники — сферы радиусом 1..4 в первых 30 единицах перед камерой.
+// Проверка: для случайных точек пирамиды каждый источник, в сферу
+// которого точка попала, должен быть в списке её кластера (иначе шейдер
+// его потеряет).
+#include "LightClusters.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+void run(LightClusters& clusters, std::size_t count) {
+    std::mt19937 rng(static_cast<unsigned>(count));
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), depth(0.5f, 30.0f), radius(1.0f, 4.0f);
+    const float tanY = std::tan(glm::radians(60.0f) * 0.5f), tanX = tanY * 16.0f / 9.0f;
+    auto randomPoint = [&]() {
+        const float d = depth(rng);
+        return glm::vec3(unit(rng) * tanX * d, unit(rng) * tanY * d, -d);
+    };
+
+    std::vector<glm::vec4> spheres(count);
+    for (glm::vec4& s : spheres) s = glm::vec4(randomPoint(), radius(rng));
+
+    const int repeats = static_cast<int>(std::max<std::size_t>(10, 20000 / count));
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) clusters.assign(spheres);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / repeats;
+
+    const std::vector<std::uint32_t>& grid = clusters.clusterGrid();
+    const std::vector<std::uint32_t>& indices = clusters.indices();
+    std::uint32_t maxPerCluster = 0, occupied = 0;
+    for (int c = 0; c < LightClusters::COUNT; ++c) {
+        maxPerCluster = std::max(maxPerCluster, grid[2 * c + 1]);
+        occupied += grid[2 * c + 1] > 0;
+    }
+
+    std::size_t missed = 0, samples = 20000;
+    for (std::size_t i = 0; i < samples; ++i) {
+        const glm::vec3 p = randomPoint();
+        const int c = clusters.clusterOf(p);
+        if (c < 0) continue;
+        const std::uint32_t* begin = indices.data() + grid[2 * c];
+        const std::uint32_t* end = begin + grid[2 * c + 1];
+        for (std::uint32_t light = 0; light < count; ++light) {
+            const glm::vec3 d = p - glm::vec3(spheres[light]);
+            if (glm::dot(d, d) <= spheres[light].w * spheres[light].w && !std::binary_search(begin, end, light)) ++missed;
+        }
+    }
+
+    std::printf("%6zu %10.3f ms %10zu %9.1f %6u %9.1f %7zu\n", count, ms, indices.size(),
+        occupied ? static_cast<double>(indices.size()) / occupied : 0.0, maxPerCluster,
+        static_cast<double>(indices.size()) / count, missed);
+}
+
+int main() {
+    LightClusters clusters;
+    clusters.setProjection(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    std::printf("%d x %d x %d clusters\n\n", LightClusters::TILES_X, LightClusters::TILES_Y, LightClusters::SLICES);
+    std::printf("%6s %13s %10s %9s %6s %9s %7s\n", "lights", "assign", "indices", "avg/clus", "max", "clus/lgt", "missed");
+    for (std::size_t count : { 64, 128, 256, 512, 1024, 2048, 4096 }) run(clusters, count);
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Отчёт оптимизации меша (MeshOptimizer.h): ACMR/ATVR и перерисовка до
+// и после, время прохода и проверка, что набор треугольников не изменился.
+// GPU не нужен — кэш и растеризация моделируются на CPU.
+//
+// Для перерисовки сравниваются: исходный порядок, только кэш вершин и
+// кэш + optimizeOverdraw при нескольких порогах потери ACMR.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/mesh_optimize.cpp -o mesh_optimize -lGLEW -lGL -pthread
+// Запуск (из корня, чтобы нашлись model.obj и Objects/):
+//   ./mesh_optimize [клеток сетки по стороне, по умолчанию 300]
+#include "Utils.h"
+#include "MeshOptimizer.h"
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <array>
+
+/* ------------------------------------------------------------------ */
+// Регулярная сетка cells x cells квадов, треугольники по строкам —
+// как после loadOBJ для файла, записанного построчно
+Mesh makeGrid(int cells) {
+    Mesh mesh;
+    const int n = cells + 1;
+    for (int y = 0; y < n; ++y)
+        for (int x = 0; x < n; ++x) {
+            Vertex v{};
+            v.position = glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(y));
+            v.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            v.texCoord = glm::vec2(x / float(cells), y / float(cells));
+            mesh.vertices.push_back(v);
+        }
+    for (int y = 0; y < cells; ++y)
+        for (int x = 0; x < cells; ++x) {
+            unsigned a = y * n + x, b = a + 1, c = a + n + 1, d = a + n;
+            for (unsigned i : { a, b, c, a, c, d }) mesh.indices.push_back(i);
+        }
+    return mesh;
+}
+
+// Тор: невыпуклый, поэтому в отличие от сферы часть граней загораживает
+// другие и порядок отрисовки влияет на перерисовку
+Mesh makeTorus(int segments, int sides) {
+    Mesh mesh;
+    const float R = 1.0f, r = 0.35f, twoPi = 6.2831853f;
+    for (int i = 0; i <= segments; ++i)
+        for (int j = 0; j <= sides; ++j) {
+            float u = twoPi * i / segments, v = twoPi * j / sides;
+            Vertex vert{};
+            glm::vec3 ring(std::cos(u), 0.0f, std::sin(u));
+            vert.normal = ring * std::cos(v) + glm::vec3(0.0f, std::sin(v), 0.0f);
+            vert.position = ring * R + vert.normal * r;
+            vert.texCoord = glm::vec2(float(i) / segments, float(j) / sides);
+            mesh.vertices.push_back(vert);
+        }
+    const int n = sides + 1;
+    for (int i = 0; i < segments; ++i)
+        for (int j = 0; j < sides; ++j) {
+            unsigned a = i * n + j, b = a + n, c = b + 1, d = a + 1;
+            for (unsigned k : { a, d, c, a, c, b }) mesh.indices.push_back(k);
+        }
+    return mesh;
+}
+
+// Несколько сфер в одном буфере, разбросанных по кубу, — сцена,
+// запечённая в один меш: здесь грани разных сфер закрывают друг друга
+Mesh makeSphereCluster(int count, int stacks, int slices) {
+    Mesh mesh;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> pos(-2.0f, 2.0f);
+    const float pi = 3.14159265f;
+    for (int s = 0; s < count; ++s) {
+        const glm::vec3 center(pos(rng), pos(rng), pos(rng));
+        const unsigned base = static_cast<unsigned>(mesh.vertices.size());
+        for (int i = 0; i <= stacks; ++i)
+            for (int j = 0; j <= slices; ++j) {
+                float theta = pi * i / stacks, phi = 2.0f * pi * j / slices;
+                Vertex v{};
+                v.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                v.position = center + v.normal * 0.8f;
+                v.texCoord = glm::vec2(float(j) / slices, float(i) / stacks);
+                mesh.vertices.push_back(v);
+            }
+        const unsigned n = slices + 1;
+        for (int i = 0; i < stacks; ++i)
+            for (int j = 0; j < slices; ++j) {
+                unsigned a = base + i * n + j, b = a + n, c = b + 1, d = a + 1;
+                for (unsigned k : { a, d, c, a, c, b }) mesh.indices.push_back(k);
+            }
+    }
+    return mesh;
+}
+
+// Тот же меш со случайным порядком треугольников — худший случай
+// для кэша (например, после склейки частей модели)
+Mesh shuffleTriangles(Mesh mesh) {
+    std::vector<std::array<unsigned, 3>> tris(mesh.indices.size() / 3);
+    for (std::size_t t = 0; t < tris.size(); ++t)
+        tris[t] = { mesh.indices[t * 3], mesh.indices[t * 3 + 1], mesh.indices[t * 3 + 2] };
+    std::shuffle(tris.begin(), tris.end(), std::mt19937(7));
+    for (std::size_t t = 0; t < tris.size(); ++t)
+        for (int k = 0; k < 3; ++k) mesh.indices[t * 3 + k] = tris[t][k];
+    return mesh;
+}
+
+// Треугольники как отсортированный список троек позиций с сохранённой
+// ориентацией (начало — с наименьшей вершины): не зависит от порядка
+// треугольников и от нумерации вершин
+std::vector<std::array<float, 9>> triangleSet(const Mesh& mesh) {
+    std::vector<std::array<float, 9>> set;
+    for (std::size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+        std::array<std::array<float, 3>, 3> p;
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec3& v = mesh.vertices[mesh.indices[t + k]].position;
+            p[k] = { v.x, v.y, v.z };
+        }
+        int first = 0;
+        for (int k = 1; k < 3; ++k) if (p[k] < p[first]) first = k;
+        std::array<float, 9> key;
+        for (int k = 0; k < 3; ++k)
+            for (int c = 0; c < 3; ++c) key[k * 3 + c] = p[(first + k) % 3][c];
+        set.push_back(key);
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+// Длина в символах, а не байтах — для выравнивания колонок
+std::size_t utf8Length(const char* s) {
+    std::size_t n = 0;
+    for (; *s; ++s) n += (static_cast<unsigned char>(*s) & 0xC0) != 0x80;
+    return n;
+}
+
+void report(const char* name, Mesh mesh) {
+    const auto reference = triangleSet(mesh);
+
+    // только кэш вершин — чтобы увидеть, что даёт optimizeOverdraw сверху
+    Mesh cacheOnly = mesh;
+    optimizeVertexCache(cacheOnly.indices, cacheOnly.vertices.size());
+    VertexCacheStats cacheStats = analyzeVertexCache(cacheOnly.indices.data(), cacheOnly.indices.size(),
+                                                     cacheOnly.vertices.size());
+    OverdrawStats cacheOverdraw = analyzeOverdraw(cacheOnly.vertices.data(), cacheOnly.vertices.size(),
+                                                  cacheOnly.indices.data(), cacheOnly.indices.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    MeshOptimizeReport r = optimizeMesh(mesh);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    bool same = triangleSet(mesh) == reference;
+    std::printf("%s%*s %8zu tris  ACMR %.3f -> %.3f (только кэш %.3f)  ATVR %.3f -> %.3f  %8.2f ms  %s\n",
+        name, static_cast<int>(34 - utf8Length(name)), "", mesh.indices.size() / 3,
+        r.before.acmr, r.after.acmr, cacheStats.acmr, r.before.atvr, r.after.atvr,
+        ms, same ? "" : "ТРЕУГОЛЬНИКИ РАЗЛИЧАЮТСЯ");
+    std::printf("%36s перерисовка %.3f -> %.3f (только кэш %.3f)%s\n", "",
+        r.overdrawBefore.overdraw, r.overdrawAfter.overdraw, cacheOverdraw.overdraw,
+        r.overdrawApplied ? "" : "  optimizeOverdraw не применён");
+
+    // компромисс кэш / перерисовка по порогу
+    for (float threshold : { 1.0f, 1.05f, 1.25f, 1.5f, 3.0f }) {
+        Mesh m = cacheOnly;
+        bool applied = optimizeOverdraw(m.indices, m.vertices, threshold);
+        VertexCacheStats cs = analyzeVertexCache(m.indices.data(), m.indices.size(), m.vertices.size());
+        OverdrawStats os = analyzeOverdraw(m.vertices.data(), m.vertices.size(), m.indices.data(), m.indices.size());
+        std::printf("%36s порог %.2f: ACMR %.3f  перерисовка %.3f%s\n", "", threshold, cs.acmr, os.overdraw,
+            applied ? "" : "  (оставлен порядок кэша)");
+    }
+}
+
+int main(int argc, char** argv) {
+    int cells = argc > 1 ? std::atoi(argv[1]) : 300;
+
+    const char* files[] = {
+        "model.obj",
+        "Objects/SphereSmoothobj.obj",
+        "Objects/utah_teapot_lowpoly.obj",
+        "Objects/Icosahedron.obj",
+        "Objects/test-cube.obj",
+    };
+    for (const char* path : files) {
+        Mesh mesh;
+        if (!loadOBJ(path, mesh)) continue;
+        report(path, mesh);
+    }
+
+    report("тор 96x48", makeTorus(96, 48));
+    report("тор 96x48 (перемешан)", shuffleTriangles(makeTorus(96, 48)));
+    report("20 сфер в одном меше", makeSphereCluster(20, 24, 48));
+
+    Mesh grid = makeGrid(cells);
+    char name[64];
+    std::snprintf(name, sizeof(name), "сетка %dx%d (по строкам)", cells, cells);
+    report(name, grid);
+    std::snprintf(name, sizeof(name), "сетка %dx%d (перемешана)", cells, cells);
+    report(name, shuffleTriangles(grid));
+    return 0;
+}
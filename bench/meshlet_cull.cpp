@@ -0,0 +1,201 @@
+// Отсечение мешлетов на CPU (Meshlets.h): сколько треугольников уходит
+// на отрисовку и сколько из них действительно видно, на сетке из моделей
+// Objects/. GPU не нужен — отсечение и «истинная» видимость считаются на CPU.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/meshlet_cull.cpp -o meshlet_cull -lGLEW -lGL -pthread
+// Запуск (из корня, чтобы нашлись model.obj и Objects/):
+//   ./meshlet_cull [объектов по стороне сетки, по умолчанию 64]
+//
+// Сравниваются: всё подряд, отсечение объектов по сфере и отсечение
+// мешлетов (пирамида + конус нормалей). «Видимые» — треугольники, лицевые
+// к камере и хотя бы частично в пирамиде (перекрытие не учитывается).
+#include "Utils.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+struct Model {
+    std::string name;
+    Mesh mesh;
+    std::vector<Meshlet> meshlets;
+    glm::vec3 center;
+    float radius;
+};
+
+struct Instance {
+    const Model* model;
+    glm::mat4 transform;
+};
+
+// UV-сфера 64x32 — плотная модель рядом с маленькими из Objects/
+Mesh makeSphere(int slices, int stacks) {
+    Mesh mesh;
+    const float pi = 3.14159265f;
+    for (int i = 0; i <= stacks; ++i)
+        for (int j = 0; j <= slices; ++j) {
+            float theta = pi * i / stacks, phi = 2.0f * pi * j / slices;
+            Vertex v{};
+            v.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            v.position = v.normal;
+            v.texCoord = glm::vec2(float(j) / slices, float(i) / stacks);
+            mesh.vertices.push_back(v);
+        }
+    const unsigned n = slices + 1;
+    for (int i = 0; i < stacks; ++i)
+        for (int j = 0; j < slices; ++j) {
+            unsigned a = i * n + j, b = a + n, c = b + 1, d = a + 1;
+            for (unsigned k : { a, d, c, a, c, b }) mesh.indices.push_back(k);
+        }
+    return mesh;
+}
+
+void prepare(Model& m) {
+    optimizeVertexCache(m.mesh.indices, m.mesh.vertices.size());
+    optimizeVertexFetch(m.mesh.vertices, m.mesh.indices);
+    m.meshlets = buildMeshlets(m.mesh);
+
+    glm::vec3 lo = m.mesh.vertices[0].position, hi = lo;
+    for (const Vertex& v : m.mesh.vertices) {
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+    }
+    m.center = (lo + hi) * 0.5f;
+    m.radius = 0.0f;
+    for (const Vertex& v : m.mesh.vertices) m.radius = std::max(m.radius, glm::length(v.position - m.center));
+}
+
+// Длина в символах, а не байтах — для выравнивания колонок
+std::size_t utf8Length(const char* s) {
+    std::size_t n = 0;
+    for (; *s; ++s) n += (static_cast<unsigned char>(*s) & 0xC0) != 0x80;
+    return n;
+}
+
+// Строка, дополненная пробелами до width символов
+std::string pad(const char* s, std::size_t width) {
+    std::size_t length = utf8Length(s);
+    return std::string(s) + std::string(length < width ? width - length : 0, ' ');
+}
+
+// Лицевые треугольники, задевающие пирамиду
+std::size_t visibleTriangles(const Model& m, const glm::mat4& model, const glm::mat4& viewProjection,
+                             const glm::vec3& cameraPos) {
+    const Frustum frustum = extractFrustum(viewProjection * model);
+    const glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+    std::size_t visible = 0;
+    const auto& idx = m.mesh.indices;
+    for (std::size_t i = 0; i + 2 < idx.size(); i += 3) {
+        const glm::vec3& a = m.mesh.vertices[idx[i]].position;
+        const glm::vec3& b = m.mesh.vertices[idx[i + 1]].position;
+        const glm::vec3& c = m.mesh.vertices[idx[i + 2]].position;
+        if (glm::dot(glm::cross(b - a, c - a), camera - a) <= 0.0f) continue;
+        glm::vec3 center = (a + b + c) / 3.0f;
+        float radius = std::max({ glm::length(a - center), glm::length(b - center), glm::length(c - center) });
+        if (sphereInFrustum(frustum, center, radius)) ++visible;
+    }
+    return visible;
+}
+
+int main(int argc, char** argv) {
+    int side = argc > 1 ? std::atoi(argv[1]) : 64;
+
+    const char* files[] = {
+        "model.obj",
+        "Objects/Cube.obj", "Objects/Dodecahedron.obj", "Objects/Icosahedron.obj",
+        "Objects/MinFlatSphere.obj", "Objects/Octahedron.obj", "Objects/SphereSmoothobj.obj",
+        "Objects/Tetrahedron.obj", "Objects/test-cube.obj", "Objects/utah_teapot_lowpoly.obj",
+    };
+    std::vector<Model> models;
+    for (const char* path : files) {
+        Model m;
+        m.name = path;
+        if (!loadOBJ(path, m.mesh) || m.mesh.indices.empty()) continue;
+        models.push_back(std::move(m));
+    }
+    {
+        Model m;
+        m.name = "UV-сфера 64x32";
+        m.mesh = makeSphere(64, 32);
+        models.push_back(std::move(m));
+    }
+
+    std::printf("%s %6s %s %6s\n", pad("модель", 34).c_str(), "tris", pad("мешлеты", 8).c_str(), "tri/ml");
+    for (Model& m : models) {
+        prepare(m);
+        std::printf("%s %6zu %8zu %6.1f\n", pad(m.name.c_str(), 34).c_str(), m.mesh.indices.size() / 3, m.meshlets.size(),
+            m.mesh.indices.size() / 3.0 / std::max<std::size_t>(m.meshlets.size(), 1));
+    }
+
+    // сетка side x side, модели по кругу, случайный поворот, размер ~1
+    std::vector<Instance> instances;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    for (int z = 0; z < side; ++z)
+        for (int x = 0; x < side; ++x) {
+            const Model& m = models[(z * side + x) % models.size()];
+            glm::mat4 t(1.0f);
+            t = glm::translate(t, glm::vec3(x * 3.0f, 0.0f, -z * 3.0f));
+            t = glm::rotate(t, angle(rng), glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+            t = glm::scale(t, glm::vec3(1.0f / m.radius));
+            t = glm::translate(t, -m.center);
+            instances.push_back({ &m, t });
+        }
+
+    // камера у угла сетки, смотрит вдоль диагонали
+    const glm::vec3 cameraPos(-4.0f, 3.0f, 4.0f);
+    const glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(side * 1.5f, 0.0f, -side * 1.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1280.0f / 720.0f, 0.1f, 100.0f);
+    const glm::mat4 viewProjection = projection * view;
+
+    std::size_t total = 0, visible = 0;
+    for (const Instance& inst : instances) {
+        total += inst.model->mesh.indices.size() / 3;
+        visible += visibleTriangles(*inst.model, inst.transform, viewProjection, cameraPos);
+    }
+
+    // отсечение объектов по ограничивающей сфере
+    std::size_t objectSubmitted = 0, objectDraws = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        const Frustum frustum = extractFrustum(viewProjection);
+        for (const Instance& inst : instances) {
+            glm::vec3 c = glm::vec3(inst.transform * glm::vec4(inst.model->center, 1.0f));
+            if (!sphereInFrustum(frustum, c, 1.0f)) continue;   // модели отмасштабированы к радиусу 1
+            objectSubmitted += inst.model->mesh.indices.size() / 3;
+            ++objectDraws;
+        }
+    }
+    double objectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    // отсечение мешлетов
+    MeshletCullStats stats;
+    MeshletDrawRanges ranges;
+    std::size_t meshletDraws = 0, rangeCount = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (const Instance& inst : instances) {
+        ranges.clear();
+        cullMeshlets(inst.model->meshlets, inst.transform, viewProjection, cameraPos, ranges, &stats);
+        if (!ranges.counts.empty()) ++meshletDraws;
+        rangeCount += ranges.counts.size();
+    }
+    double meshletMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("\nсетка %dx%d объектов, %zu треугольников, видимых %zu (%.1f%%)\n",
+        side, side, total, visible, 100.0 * visible / total);
+    std::printf("  %s %s %s %s %s\n", pad("", 28).c_str(), pad("отправлено", 10).c_str(),
+        pad("лишних", 10).c_str(), pad("вызовов", 8).c_str(), "время");
+    std::printf("  %s %10zu %9.1f%% %8zu %10s\n", pad("без отсечения", 28).c_str(), total,
+        100.0 * (total - visible) / total, instances.size(), "-");
+    std::printf("  %s %10zu %9.1f%% %8zu %7.3f ms\n", pad("объекты по сфере", 28).c_str(), objectSubmitted,
+        100.0 * (objectSubmitted - visible) / objectSubmitted, objectDraws, objectMs);
+    std::printf("  %s %10zu %9.1f%% %8zu %7.3f ms\n", pad("мешлеты (пирамида + конус)", 28).c_str(), stats.submittedTriangles,
+        100.0 * (stats.submittedTriangles - visible) / stats.submittedTriangles, meshletDraws, meshletMs);
+    std::printf("  мешлетов %zu: вне пирамиды %zu, отброшено конусом %zu, видно %zu; диапазонов после слияния %zu\n",
+        stats.meshlets, stats.frustumCulled, stats.coneCulled, stats.visibleMeshlets, rangeCount);
+    return 0;
+}
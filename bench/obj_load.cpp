@@ -0,0 +1,315 @@
+// Бенчмарк загрузки OBJ: прежний istringstream-загрузчик против loadOBJ.
+// OpenGL-контекст не нужен — меряется только разбор на CPU.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/obj_load.cpp -o obj_load -lGLEW -lGL -pthread
+// Запуск (из корня, чтобы нашлись model.obj и Objects/):
+//   ./obj_load [число граней, по умолчанию 1000000] [макс. потоков, по умолчанию все ядра]
+//
+// Кроме сравнения с прежним загрузчиком печатает масштабирование
+// параллельного режима loadOBJ(path, mesh, threads) по 1..N потокам
+// и время загрузки через бинарный кэш (MeshCache.h).
+#include "Utils.h"
+#include "MeshCache.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+/* ------------------------------------------------------------------ */
+// Прежняя хеш‑функция vertexCache (до IndexTripleTable)
+struct IndexTripleHash {
+    std::size_t operator()(const std::tuple<int, int, int>& t) const noexcept {
+        std::size_t h1 = std::hash<int>{}(std::get<0>(t));
+        std::size_t h2 = std::hash<int>{}(std::get<1>(t));
+        std::size_t h3 = std::hash<int>{}(std::get<2>(t));
+        return ((h1 ^ (h2 << 1)) >> 1) ^ (h3 << 1);
+    }
+};
+
+/* ------------------------------------------------------------------ */
+// Эталон: загрузчик в том виде, в каком он был до перехода на ObjCursor.
+bool loadOBJLegacy(const std::string& path, Mesh& outMesh) {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+
+    std::unordered_map<std::tuple<int, int, int>, unsigned int, IndexTripleHash> vertexCache;
+
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream ss(line);
+        std::string prefix; ss >> prefix;
+
+        if (prefix == "v") {
+            glm::vec3 p(0.0f); ss >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (prefix == "vt") {
+            glm::vec2 t(0.0f); ss >> t.x >> t.y;
+            texCoords.push_back(t);
+        }
+        else if (prefix == "vn") {
+            glm::vec3 n(0.0f); ss >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (prefix == "f") {
+            std::vector<std::tuple<int, int, int>> faceIndices;
+            std::string vertStr;
+            while (ss >> vertStr) {
+                std::replace(vertStr.begin(), vertStr.end(), '/', ' ');
+                std::istringstream vs(vertStr);
+                int vi = 0, ti = 0, ni = 0;
+                vs >> vi;
+                if (vs.peek() != EOF) vs >> ti;
+                if (vs.peek() != EOF) vs >> ni;
+
+                vi = (vi > 0) ? vi - 1 : vi + static_cast<int>(positions.size());
+                ti = (ti > 0) ? ti - 1 : ti + static_cast<int>(texCoords.size());
+                ni = (ni > 0) ? ni - 1 : ni + static_cast<int>(normals.size());
+
+                faceIndices.emplace_back(vi, ti, ni);
+            }
+
+            for (size_t i = 1; i + 1 < faceIndices.size(); ++i) {
+                std::array<std::tuple<int, int, int>, 3> tri = {
+                    faceIndices[0], faceIndices[i], faceIndices[i + 1]
+                };
+                for (const auto& idxTuple : tri) {
+                    auto it = vertexCache.find(idxTuple);
+                    if (it != vertexCache.end()) {
+                        outMesh.indices.push_back(it->second);
+                        continue;
+                    }
+                    Vertex v{};
+                    int pi, ti, ni;
+                    std::tie(pi, ti, ni) = idxTuple;
+                    v.position = positions[pi];
+                    v.normal = (ni >= 0 && ni < static_cast<int>(normals.size())) ? normals[ni] : glm::vec3(0.0f);
+                    v.texCoord = (ti >= 0 && ti < static_cast<int>(texCoords.size())) ? texCoords[ti] : glm::vec2(0.0f);
+
+                    unsigned int newIndex = static_cast<unsigned int>(outMesh.vertices.size());
+                    outMesh.vertices.push_back(v);
+                    outMesh.indices.push_back(newIndex);
+                    vertexCache[idxTuple] = newIndex;
+                }
+            }
+        }
+    }
+
+    if (normals.empty()) {
+        std::vector<glm::vec3> accum(outMesh.vertices.size(), glm::vec3(0.0f));
+        for (size_t i = 0; i < outMesh.indices.size(); i += 3) {
+            unsigned int i0 = outMesh.indices[i];
+            unsigned int i1 = outMesh.indices[i + 1];
+            unsigned int i2 = outMesh.indices[i + 2];
+            const glm::vec3& p0 = outMesh.vertices[i0].position;
+            const glm::vec3& p1 = outMesh.vertices[i1].position;
+            const glm::vec3& p2 = outMesh.vertices[i2].position;
+            glm::vec3 faceNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+            accum[i0] += faceNormal;
+            accum[i1] += faceNormal;
+            accum[i2] += faceNormal;
+        }
+        for (size_t i = 0; i < outMesh.vertices.size(); ++i)
+            outMesh.vertices[i].normal = glm::normalize(accum[i]);
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+// Синтетическая сетка из квадов v/vt/vn: cells x cells граней.
+// relative = true: строки вершин чередуются с гранями, а грани
+// ссылаются на вершины отрицательными (относительными) индексами.
+std::string writeGridOBJ(int cells, bool relative = false) {
+    std::string path = "bench_grid_" + std::to_string(cells) + (relative ? "_rel" : "") + ".obj";
+    std::ofstream out(path, std::ios::binary);
+    char buf[128];
+    const int n = cells + 1;
+    auto writeRow = [&](int y) {
+        for (int x = 0; x < n; ++x) {
+            float fx = x / float(cells), fy = y / float(cells);
+            out.write(buf, std::snprintf(buf, sizeof(buf), "v %.6f %.6f %.6f\n",
+                fx * 10.0f - 5.0f, 0.25f * std::sin(fx * 20.0f) * std::cos(fy * 20.0f), fy * 10.0f - 5.0f));
+            out.write(buf, std::snprintf(buf, sizeof(buf), "vt %.6f %.6f\n", fx, fy));
+            out.write(buf, std::snprintf(buf, sizeof(buf), "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f));
+        }
+    };
+    auto writeFaces = [&](int y, int written) {
+        for (int x = 0; x < cells; ++x) {
+            int a = y * n + x + 1, b = a + 1, c = a + n + 1, d = a + n;
+            if (relative) { a -= written + 1; b -= written + 1; c -= written + 1; d -= written + 1; }
+            out.write(buf, std::snprintf(buf, sizeof(buf), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                a, a, a, b, b, b, c, c, c, d, d, d));
+        }
+    };
+
+    if (relative) {
+        writeRow(0);
+        for (int y = 1; y < n; ++y) {
+            writeRow(y);
+            writeFaces(y - 1, (y + 1) * n);
+        }
+    }
+    else {
+        for (int y = 0; y < n; ++y) writeRow(y);
+        for (int y = 0; y < cells; ++y) writeFaces(y, n * n);
+    }
+    return path;
+}
+
+std::size_t fileSize(const std::string& path) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return f ? static_cast<std::size_t>(f.tellg()) : 0;
+}
+
+std::size_t countFaces(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) return 0;
+    std::size_t faces = 0;
+    ObjCursor cur(file.data(), file.data() + file.size());
+    while (!cur.eof()) {
+        cur.skipSpaces();
+        if (cur.p + 1 < cur.end && cur.p[0] == 'f' && (cur.p[1] == ' ' || cur.p[1] == '\t')) ++faces;
+        cur.nextLine();
+    }
+    return faces;
+}
+
+// Лучшее время из нескольких прогонов, в секундах
+template <class Loader>
+double timeLoader(Loader load, const std::string& path, Mesh& result, int runs) {
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r) {
+        Mesh mesh;
+        auto t0 = std::chrono::steady_clock::now();
+        load(path, mesh);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        if (r + 1 == runs) result = std::move(mesh);
+    }
+    return best;
+}
+
+// Сравнение результатов: топология должна совпадать, атрибуты — до ULP
+bool sameMesh(const Mesh& a, const Mesh& b, float& maxDiff) {
+    maxDiff = 0.0f;
+    if (a.vertices.size() != b.vertices.size() || a.indices != b.indices) return false;
+    for (size_t i = 0; i < a.vertices.size(); ++i) {
+        const Vertex& va = a.vertices[i];
+        const Vertex& vb = b.vertices[i];
+        for (int k = 0; k < 3; ++k) {
+            maxDiff = std::max(maxDiff, std::fabs(va.position[k] - vb.position[k]));
+            maxDiff = std::max(maxDiff, std::fabs(va.normal[k] - vb.normal[k]));
+        }
+        for (int k = 0; k < 2; ++k)
+            maxDiff = std::max(maxDiff, std::fabs(va.texCoord[k] - vb.texCoord[k]));
+    }
+    return maxDiff < 1e-5f;
+}
+
+void benchFile(const std::string& path, int runs) {
+    const std::size_t bytes = fileSize(path);
+    const std::size_t faces = countFaces(path);
+    if (bytes == 0) {
+        std::printf("%-36s  (нет файла)\n", path.c_str());
+        return;
+    }
+
+    Mesh legacy, fast;
+    double tLegacy = timeLoader([](const std::string& p, Mesh& m) { return loadOBJLegacy(p, m); }, path, legacy, runs);
+    double tFast = timeLoader([](const std::string& p, Mesh& m) { return loadOBJ(p, m); }, path, fast, runs);
+
+    float maxDiff = 0.0f;
+    bool same = sameMesh(legacy, fast, maxDiff);
+
+    const double mb = bytes / (1024.0 * 1024.0);
+    std::printf("%-36s %9.2f MB %9zu faces\n", path.c_str(), mb, faces);
+    std::printf("    istringstream: %9.2f ms %9.1f MB/s %12.0f faces/s\n",
+        tLegacy * 1e3, mb / tLegacy, faces / tLegacy);
+    std::printf("    ObjCursor:     %9.2f ms %9.1f MB/s %12.0f faces/s  x%.1f\n",
+        tFast * 1e3, mb / tFast, faces / tFast, tLegacy / tFast);
+    std::printf("    vertices %zu, indices %zu, %s (max diff %.2g)\n",
+        fast.vertices.size(), fast.indices.size(), same ? "совпадает" : "РАЗЛИЧАЕТСЯ", maxDiff);
+}
+
+// Масштабирование параллельного режима loadOBJ по числу потоков
+void benchThreads(const std::string& path, unsigned maxThreads, int runs) {
+    const std::size_t bytes = fileSize(path);
+    const double mb = bytes / (1024.0 * 1024.0);
+
+    Mesh serial;
+    double tSerial = timeLoader([](const std::string& p, Mesh& m) { return loadOBJ(p, m, 1); },
+        path, serial, runs);
+    std::printf("%s: потоков 1..%u\n", path.c_str(), maxThreads);
+    std::printf("    %2u поток(ов): %9.2f ms %9.1f MB/s\n", 1u, tSerial * 1e3, mb / tSerial);
+
+    for (unsigned t = 2; t <= maxThreads; t *= 2) {
+        Mesh parallel;
+        double tp = timeLoader([t](const std::string& p, Mesh& m) { return loadOBJ(p, m, t); },
+            path, parallel, runs);
+        bool same = parallel.indices == serial.indices &&
+            parallel.vertices.size() == serial.vertices.size() &&
+            std::equal(parallel.vertices.begin(), parallel.vertices.end(), serial.vertices.begin(),
+                [](const Vertex& a, const Vertex& b) {
+                    return a.position == b.position && a.normal == b.normal && a.texCoord == b.texCoord;
+                });
+        std::printf("    %2u поток(ов): %9.2f ms %9.1f MB/s  x%.2f  %s\n",
+            t, tp * 1e3, mb / tp, tSerial / tp, same ? "совпадает" : "РАЗЛИЧАЕТСЯ");
+        if (t * 2 > maxThreads && t != maxThreads) t = maxThreads / 2;   // последним — все ядра
+    }
+}
+
+// Бинарный кэш: первый запуск (разбор + запись) против повторного (mmap)
+void benchCache(const std::string& path) {
+    std::remove(meshCachePath(path).c_str());
+
+    auto t0 = std::chrono::steady_clock::now();
+    Mesh cold;
+    loadOBJCached(path, cold);
+    auto t1 = std::chrono::steady_clock::now();
+    Mesh warm;
+    bool hit = readMeshCache(path, warm);
+    // отображение ленивое: трогаем каждую страницу, как это сделает glBufferData
+    volatile unsigned char sink = 0;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(warm.vertexData());
+    const std::size_t total = warm.vertexCount() * sizeof(Vertex) + warm.indexCount() * sizeof(unsigned int);
+    for (std::size_t i = 0; hit && i < total; i += 4096) sink = sink + bytes[i];
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::printf("%s: кэш\n", path.c_str());
+    std::printf("    разбор + запись: %9.2f ms\n", std::chrono::duration<double>(t1 - t0).count() * 1e3);
+    std::printf("    из кэша (mmap):  %9.2f ms  %s\n", std::chrono::duration<double>(t2 - t1).count() * 1e3,
+        hit && warm.vertexCount() == cold.vertexCount() ? "совпадает" : "ПРОМАХ");
+    std::remove(meshCachePath(path).c_str());
+}
+
+int main(int argc, char** argv) {
+    int targetFaces = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int cells = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(targetFaces))));
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : ThreadPool::shared().size();
+
+    benchFile("model.obj", 20);
+    benchFile("Objects/utah_teapot_lowpoly.obj", 20);
+
+    std::string grid = writeGridOBJ(cells);
+    benchFile(grid, 3);
+    benchThreads(grid, maxThreads, 3);
+    benchCache(grid);
+    std::remove(grid.c_str());
+
+    // относительные индексы через границы кусков
+    std::string relGrid = writeGridOBJ(cells, true);
+    benchFile(relGrid, 1);
+    benchThreads(relGrid, maxThreads, 3);
+    std::remove(relGrid.c_str());
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Программное отсечение перекрытых объектов (OcclusionBuffer.h) на
+// «городе»: сетка кварталов, в каждом здание из Objects/ (растянутый куб,
+// чайник или сфера) — загораживатели; между ними 10k и 100k мелких
+// коробок. Камера на улице у земли. GPU не нужен — всё на CPU.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/occlusion.cpp -o occlusion -lGLEW -lGL -pthread
+//   (-mavx или -march=native — растеризация по 8 пикселей, иначе SSE по 4)
+// Запуск (из корня, чтобы нашлись Objects/):
+//   ./occlusion
+//
+// Печатает время растеризации, пирамиды и проверок, сколько коробок
+// прошло пирамиду видимости и сколько из них закрыто. Проверка пирамиды:
+// каждая закрытая ею коробка должна быть закрыта и по полному буферу
+// (уровень 0), иначе пирамида потеряла видимый объект.
+#include "Utils.h"
+#include "Frustum.h"
+#include "OcclusionBuffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+struct Occluder {
+    const Mesh* mesh;
+    glm::mat4 model;
+};
+
+// Та же проверка, что boxVisible, но по всем пикселям уровня 0
+bool visibleAtFullResolution(const OcclusionBuffer& buffer, const glm::mat4& viewProjection,
+                             const glm::vec3& min, const glm::vec3& max) {
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 1.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec4 c = viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+                                                       corner & 4 ? max.z : min.z, 1.0f);
+        if (c.w <= 0.0f || c.z < -c.w) return true;
+        minX = std::min(minX, (c.x / c.w * 0.5f + 0.5f) * buffer.width());
+        maxX = std::max(maxX, (c.x / c.w * 0.5f + 0.5f) * buffer.width());
+        minY = std::min(minY, (c.y / c.w * 0.5f + 0.5f) * buffer.height());
+        maxY = std::max(maxY, (c.y / c.w * 0.5f + 0.5f) * buffer.height());
+        nearest = std::min(nearest, c.z / c.w * 0.5f + 0.5f);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= buffer.width() || minY >= buffer.height()) return true;
+    const float* depth = buffer.levelDepth(0);
+    for (int y = std::max(0, static_cast<int>(std::floor(minY)) - 1);
+         y <= std::min(buffer.height() - 1, static_cast<int>(std::floor(maxY)) + 1); ++y)
+        for (int x = std::max(0, static_cast<int>(std::floor(minX)) - 1);
+             x <= std::min(buffer.width() - 1, static_cast<int>(std::floor(maxX)) + 1); ++x)
+            if (nearest <= depth[y * buffer.levelStride(0) + x]) return true;
+    return false;
+}
+
+void run(const std::vector<Occluder>& occluders, float citySize, std::size_t count) {
+    std::mt19937 rng(static_cast<unsigned>(count));
+    std::uniform_real_distribution<float> ground(0.0f, citySize), height(0.0f, 2.0f), size(0.1f, 0.4f);
+    std::vector<glm::vec3> mins(count), maxs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const glm::vec3 c(ground(rng), height(rng), ground(rng));
+        const glm::vec3 h(size(rng));
+        mins[i] = c - h;
+        maxs[i] = c + h;
+    }
+
+    // камера на перекрёстке у края города смотрит вдоль улицы
+    const glm::vec3 eye(10.0f, 1.7f, 10.0f);
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, citySize * 1.5f) *
+        glm::lookAt(eye, eye + glm::vec3(1.0f, 0.0f, 0.35f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = extractFrustum(viewProjection);
+
+    OcclusionBuffer buffer;
+    const int frames = 20;
+    double rasterMs = 0.0, pyramidMs = 0.0, frustumMs = 0.0, occlusionMs = 0.0;
+    std::vector<std::uint32_t> inFrustum, visible;
+    for (int frame = 0; frame < frames; ++frame) {
+        auto t0 = std::chrono::steady_clock::now();
+        buffer.begin(viewProjection);
+        for (const Occluder& o : occluders)
+            buffer.drawOccluder(o.model, o.mesh->vertexData(), sizeof(Vertex), o.mesh->vertexCount(),
+                                o.mesh->indexData(), o.mesh->indexCount());
+        rasterMs += msSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        buffer.buildPyramid();
+        pyramidMs += msSince(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        inFrustum.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint32_t planes = FRUSTUM_ALL_PLANES;
+            if (boxInFrustum(frustum, mins[i], maxs[i], planes)) inFrustum.push_back(static_cast<std::uint32_t>(i));
+        }
+        frustumMs += msSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        visible.clear();
+        for (std::uint32_t i : inFrustum)
+            if (buffer.boxVisible(mins[i], maxs[i])) visible.push_back(i);
+        occlusionMs += msSince(t0);
+    }
+
+    std::size_t lost = 0, fullResolutionOccluded = 0;
+    std::vector<char> passed(count, 0);
+    for (std::uint32_t i : visible) passed[i] = 1;
+    for (std::uint32_t i : inFrustum) {
+        const bool full = visibleAtFullResolution(buffer, viewProjection, mins[i], maxs[i]);
+        fullResolutionOccluded += !full;
+        lost += full && !passed[i];
+    }
+
+    std::printf("%zu boxes: %zu in frustum, %zu occluded (%.0f%%), full-resolution test %zu occluded, lost %zu\n",
+        count, inFrustum.size(), inFrustum.size() - visible.size(),
+        inFrustum.empty() ? 0.0 : 100.0 * (inFrustum.size() - visible.size()) / inFrustum.size(),
+        fullResolutionOccluded, lost);
+    std::printf("  raster %.3f ms (%zu triangles), pyramid %.3f ms, frustum %.3f ms, occlusion %.3f ms (%.1f ns/box)\n\n",
+        rasterMs / frames, buffer.trianglesDrawn, pyramidMs / frames, frustumMs / frames, occlusionMs / frames,
+        inFrustum.empty() ? 0.0 : occlusionMs / frames * 1e6 / inFrustum.size());
+}
+
+int main() {
+    const char* paths[] = { "Objects/Cube.obj", "Objects/utah_teapot_lowpoly.obj", "Objects/SphereSmoothobj.obj" };
+    Mesh meshes[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!loadOBJ(paths[i], meshes[i])) {
+            std::fprintf(stderr, "Failed to load %s\n", paths[i]);
+            return 1;
+        }
+        meshes[i].computeBounds();
+    }
+
+    // квартал 10x10, здание в его середине, улицы шириной 4 между ними
+    const int blocks = 16;
+    const float blockSize = 10.0f;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> storeys(3.0f, 12.0f);
+    std::vector<Occluder> occluders;
+    std::size_t triangles = 0;
+    for (int bz = 0; bz < blocks; ++bz)
+        for (int bx = 0; bx < blocks; ++bx) {
+            const int kind = (bx * 7 + bz * 3) % 8 == 0 ? 1 + (bx + bz) % 2 : 0;   // редко — чайник или сфера
+            const Mesh& mesh = meshes[kind];
+            const float h = storeys(rng);
+            // коробку меша — в коробку здания 6 x h x 6 на земле
+            const glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+            const glm::vec3 scale = glm::vec3(6.0f, h, 6.0f) / extent;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((bx + 0.5f) * blockSize + 2.0f, h * 0.5f,
+                                                                        (bz + 0.5f) * blockSize + 2.0f));
+            model = glm::scale(model, scale);
+            model = glm::translate(model, -mesh.boundsCenter);
+            occluders.push_back({ &mesh, model });
+            triangles += mesh.indexCount() / 3;
+        }
+    std::printf("OcclusionBuffer %dx%d, %d lanes, %zu occluders, %zu triangles\n\n", OcclusionBuffer().width(),
+        OcclusionBuffer().height(), OCCLUSION_LANES, occluders.size(), triangles);
+
+    for (std::size_t count : { 10000, 100000 }) run(occluders, blocks * blockSize + 4.0f, count);
+    return 0;
+}
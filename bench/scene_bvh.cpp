@@ -0,0 +1,205 @@
+// BVH над объектами сцены (SceneBVH.h): построение, refit после движения
+// части объектов и запросы — пирамида, лучи, ближайшие — против обхода
+// всех объектов подряд. Сцены из 1k, 10k и 100k коробок; ответы BVH
+// сверяются с перебором. На тех же сценах и движениях — свободное
+// октодерево (LooseOctree.h): вставка, перенос, отсечение и память.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/scene_bvh.cpp -o scene_bvh
+// Запуск:
+//   ./scene_bvh
+#include "SceneBVH.h"
+#include "LooseOctree.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Вход луча в коробку или -1 (как в SceneBVH, для перебора)
+float rayBox(const BoundingBox& b, const glm::vec3& origin, const glm::vec3& inverse) {
+    const glm::vec3 t0 = (b.min - origin) * inverse, t1 = (b.max - origin) * inverse;
+    const glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    const float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    return enter <= exit ? enter : -1.0f;
+}
+
+void run(std::size_t count) {
+    std::mt19937 rng(static_cast<unsigned>(count));
+    const float side = 4.0f * std::cbrt(static_cast<float>(count));   // ~64 единицы объёма на объект
+    std::uniform_real_distribution<float> coord(0.0f, side), size(0.25f, 1.0f), unit(-1.0f, 1.0f);
+
+    std::vector<BoundingBox> boxes(count);
+    for (BoundingBox& b : boxes) {
+        const glm::vec3 c(coord(rng), coord(rng), coord(rng));
+        const glm::vec3 h(size(rng), size(rng), size(rng));
+        b.min = c - h;
+        b.max = c + h;
+    }
+
+    const std::vector<BoundingBox> initial = boxes;
+
+    // построение
+    SceneBVH bvh;
+    auto t0 = std::chrono::steady_clock::now();
+    bvh.build(boxes);
+    const double buildMs = msSince(t0);
+
+    // refit: сдвигается каждый десятый объект, затем все
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; i += 10) {
+        const glm::vec3 d(unit(rng), unit(rng), unit(rng));
+        boxes[i].min += d;
+        boxes[i].max += d;
+        bvh.update(static_cast<std::uint32_t>(i), boxes[i]);
+    }
+    bvh.refit();
+    const double refitPartMs = msSince(t0);
+    const std::vector<BoundingBox> afterPart = boxes;
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const glm::vec3 d(unit(rng), unit(rng), unit(rng));
+        boxes[i].min += d;
+        boxes[i].max += d;
+        bvh.update(static_cast<std::uint32_t>(i), boxes[i]);
+    }
+    bvh.refit();
+    const double refitAllMs = msSince(t0);
+    const float refitCost = bvh.sahCost();
+    SceneBVH fresh;
+    fresh.build(boxes);
+
+    // октодерево: те же коробки и те же движения
+    LooseOctree octree;
+    t0 = std::chrono::steady_clock::now();
+    octree.build(initial);
+    const double octreeBuildMs = msSince(t0);
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; i += 10) octree.update(static_cast<std::uint32_t>(i), afterPart[i]);
+    const double octreePartMs = msSince(t0);
+    const std::size_t partRelocations = octree.relocationCount();
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) octree.update(static_cast<std::uint32_t>(i), boxes[i]);
+    const double octreeAllMs = msSince(t0);
+
+    // пирамида: камера в центре сцены смотрит вдоль x, дальняя плоскость —
+    // на краю сцены, так что видна часть объектов, как в большом мире
+    const glm::vec3 eye(side * 0.5f);
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, side * 0.5f) *
+        glm::lookAt(eye, eye + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = extractFrustum(viewProjection);
+    BoundingSpheres spheres;
+    for (const BoundingBox& b : boxes) spheres.push(b.center(), glm::length(b.max - b.min) * 0.5f);
+
+    const int frustumRepeats = static_cast<int>(std::max<std::size_t>(10, 1000000 / count));
+    std::vector<std::uint32_t> visible;
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < frustumRepeats; ++r) {
+        visible.clear();
+        cullSpheres(frustum, spheres, visible);
+    }
+    const double linearFrustumMs = msSince(t0) / frustumRepeats;
+    const std::size_t linearVisible = visible.size();
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < frustumRepeats; ++r) {
+        visible.clear();
+        fresh.queryFrustum(frustum, visible);
+    }
+    const double bvhFrustumMs = msSince(t0) / frustumRepeats;
+    SpatialQueryStats bvhStats, refitStats, octreeStats;
+    std::vector<std::uint32_t> refitVisible, octreeVisible;
+    fresh.queryFrustum(frustum, refitVisible, &bvhStats);
+    refitVisible.clear();
+    bvh.queryFrustum(frustum, refitVisible, &refitStats);
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < frustumRepeats; ++r) {
+        octreeVisible.clear();
+        octree.queryFrustum(frustum, octreeVisible);
+    }
+    const double octreeFrustumMs = msSince(t0) / frustumRepeats;
+    octreeVisible.clear();
+    octree.queryFrustum(frustum, octreeVisible, &octreeStats);
+    std::sort(octreeVisible.begin(), octreeVisible.end());
+    std::sort(refitVisible.begin(), refitVisible.end());
+    std::vector<std::uint32_t> bvhVisible = visible;
+    std::sort(bvhVisible.begin(), bvhVisible.end());
+
+    // лучи из камеры в случайные точки сцены
+    const int rays = 2000;
+    std::vector<glm::vec3> directions(rays);
+    for (glm::vec3& d : directions) d = glm::normalize(glm::vec3(coord(rng), coord(rng), coord(rng)) - eye);
+    std::vector<std::uint32_t> linearHits(rays);
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rays; ++r) {
+        const glm::vec3 inverse = glm::vec3(1.0f) / directions[r];
+        float best = std::numeric_limits<float>::max();
+        linearHits[r] = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < count; ++i) {
+            const float t = rayBox(boxes[i], eye, inverse);
+            if (t >= 0.0f && t < best) {
+                best = t;
+                linearHits[r] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+    const double linearRayUs = msSince(t0) * 1000.0 / rays;
+    std::size_t rayMismatches = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rays; ++r) {
+        RayHit hit;
+        fresh.raycast(eye, directions[r], hit);
+        rayMismatches += hit.object != linearHits[r];
+    }
+    const double bvhRayUs = msSince(t0) * 1000.0 / rays;
+
+    // 8 ближайших к случайным точкам (назначение источников света)
+    const int queries = 500;
+    const std::size_t k = 8;
+    std::vector<glm::vec3> points(queries);
+    for (glm::vec3& p : points) p = glm::vec3(coord(rng), coord(rng), coord(rng));
+    std::vector<std::vector<std::uint32_t>> linearNearest(queries);
+    std::vector<std::pair<float, std::uint32_t>> byDistance(count);
+    t0 = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        for (std::size_t i = 0; i < count; ++i)
+            byDistance[i] = { boxes[i].distance2(points[q]), static_cast<std::uint32_t>(i) };
+        std::partial_sort(byDistance.begin(), byDistance.begin() + k, byDistance.end());
+        for (std::size_t i = 0; i < k; ++i) linearNearest[q].push_back(byDistance[i].second);
+    }
+    const double linearNearestUs = msSince(t0) * 1000.0 / queries;
+    std::size_t nearestMismatches = 0;
+    std::vector<std::uint32_t> nearest;
+    t0 = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        nearest.clear();
+        fresh.nearest(points[q], k, nearest);
+        nearestMismatches += nearest != linearNearest[q];
+    }
+    const double bvhNearestUs = msSince(t0) * 1000.0 / queries;
+
+    std::printf("%zu objects: %zu nodes, build %.2f ms, SAH cost %.1f\n", count, bvh.nodeCount(), buildMs, bvh.buildCost());
+    std::printf("  refit: 10%% moved %.3f ms, all moved %.3f ms, SAH cost after %.1f (rebuilt %.1f)\n",
+        refitPartMs, refitAllMs, refitCost, fresh.buildCost());
+    std::printf("  frustum: linear spheres %8.3f ms (%zu visible), BVH boxes %8.3f ms (%zu visible)\n",
+        linearFrustumMs, linearVisible, bvhFrustumMs, visible.size());
+    std::printf("  nodes visited / objects tested: BVH %zu / %zu, refitted BVH %zu / %zu, octree %zu / %zu\n",
+        bvhStats.nodesVisited, bvhStats.objectsTested, refitStats.nodesVisited, refitStats.objectsTested,
+        octreeStats.nodesVisited, octreeStats.objectsTested);
+    std::printf("  octree: %zu nodes, insert %.2f ms, 10%% moved %.3f ms (%zu relocated), all moved %.3f ms,\n"
+                "          frustum %8.3f ms (%s BVH), memory %.1f KB vs BVH %.1f KB\n",
+        octree.nodeCount(), octreeBuildMs, octreePartMs, partRelocations, octreeAllMs, octreeFrustumMs,
+        octreeVisible == bvhVisible && refitVisible == bvhVisible ? "same objects as" : "DIFFERENT from",
+        octree.memoryBytes() / 1024.0, fresh.memoryBytes() / 1024.0);
+    std::printf("  ray:     linear %10.2f us, BVH %8.2f us, mismatches %zu\n", linearRayUs, bvhRayUs, rayMismatches);
+    std::printf("  nearest %zu: linear %7.2f us, BVH %8.2f us, mismatches %zu\n\n", k, linearNearestUs, bvhNearestUs,
+        nearestMismatches);
+}
+
+int main() {
+    for (std::size_t count : { 1000, 10000, 100000 }) run(count);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Сборка матриц модели и нормалей: прежний путь glm::translate/rotate/scale
+// по объектам-структурам (поля как у SceneObject) против TransformStore.
+// Замер на 1k, 10k и 100k объектов, два случая: неподвижная сцена
+// (пересборка всех матриц) и сцена, где каждый кадр поворачиваются все.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/transform_soa.cpp -o transform_soa -lGLEW -lGL -pthread
+//   (-mavx2 или -march=native — ядро на 8 объектов, иначе SSE на 4)
+// Запуск:
+//   ./transform_soa
+#include "Utils.h"
+#include "TransformStore.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+// Объект как в lab14.cpp до Transform: положение вперемешку с мешем и прочим
+struct AosObject {
+    Mesh mesh;
+    GLuint textureID = 0;
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 rotation;
+    std::string name;
+    glm::mat4 model;
+    glm::mat3 normal;
+};
+
+void composeAos(std::vector<AosObject>& objects) {
+    for (AosObject& obj : objects) {
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), obj.position);
+        m = glm::rotate(m, glm::radians(obj.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        m = glm::rotate(m, glm::radians(obj.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        m = glm::rotate(m, glm::radians(obj.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        obj.model = glm::scale(m, obj.scale);
+        obj.normal = glm::transpose(glm::inverse(glm::mat3(obj.model)));
+    }
+}
+
+// Время одного кадра (мс), лучшее из нескольких повторов
+template <class Frame>
+double measure(std::size_t objects, Frame frame) {
+    const int frames = static_cast<int>(std::max<std::size_t>(4, 2000000 / objects));
+    double best = 1e30;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) frame(f);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / frames;
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+void run(std::size_t count) {
+    std::mt19937 rng(static_cast<unsigned>(count));
+    std::uniform_real_distribution<float> coord(-50.0f, 50.0f), angle(0.0f, 360.0f), size(0.2f, 2.0f);
+
+    std::vector<AosObject> aos(count);
+    TransformStore store;
+    for (AosObject& obj : aos) {
+        obj.position = glm::vec3(coord(rng), coord(rng), coord(rng));
+        obj.rotation = glm::vec3(angle(rng), angle(rng), angle(rng));
+        obj.scale = glm::vec3(size(rng), size(rng), size(rng));
+        obj.name = "object";
+        store.add(obj.position, obj.rotation, obj.scale);
+    }
+
+    // расхождение с glm
+    composeAos(aos);
+    store.compose();
+    float modelError = 0.0f, normalError = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        const glm::mat4& m = store.model(i);
+        const glm::vec4* n = store.normal(i);
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r) modelError = std::max(modelError, std::abs(m[c][r] - aos[i].model[c][r]));
+        for (int c = 0; c < 3; ++c)
+            for (int r = 0; r < 3; ++r) normalError = std::max(normalError, std::abs(n[c][r] - aos[i].normal[c][r]));
+    }
+
+    const double aosStatic = measure(count, [&](int) { composeAos(aos); });
+    const double soaStatic = measure(count, [&](int) { store.composeAll(); });
+
+    // все объекты поворачиваются каждый кадр: синусы в setRotation входят в замер
+    const double aosAnimated = measure(count, [&](int f) {
+        for (AosObject& obj : aos) obj.rotation.y = static_cast<float>(f);
+        composeAos(aos);
+    });
+    const double soaAnimated = measure(count, [&](int f) {
+        for (std::size_t i = 0; i < count; ++i)
+            store.setRotation(i, glm::vec3(aos[i].rotation.x, static_cast<float>(f), aos[i].rotation.z));
+        store.compose();
+    });
+
+    std::printf("%7zu %10.3f ms %10.3f ms %6.1fx %10.3f ms %10.3f ms %6.1fx %9.2g %9.2g\n", count,
+        aosStatic, soaStatic, aosStatic / soaStatic, aosAnimated, soaAnimated, aosAnimated / soaAnimated,
+        modelError, normalError);
+}
+
+int main() {
+    std::printf("TransformStore: %zu объектов за раз\n\n", TransformStore::LANES);
+    std::printf("%7s %13s %13s %7s %13s %13s %7s %9s %9s\n", "objects", "static glm", "static SoA", "",
+        "rotated glm", "rotated SoA", "", "model err", "norm err");
+    for (std::size_t count : { 1000, 10000, 100000 }) run(count);
+    return 0;
+}
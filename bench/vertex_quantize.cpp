@@ -0,0 +1,68 @@
+// Упаковка вершин (VertexQuantization.h): объём буфера вершин и наибольшая
+// ошибка позиции, нормали и UV по моделям. GPU не нужен — распаковка
+// повторяет шейдер на CPU.
+//
+// Сборка (из корня репозитория):
+//   g++ -std=c++17 -O2 -I. bench/vertex_quantize.cpp -o vertex_quantize -lGLEW -lGL -pthread
+// Запуск (из корня, чтобы нашлись model.obj и Objects/):
+//   ./vertex_quantize
+#include "Utils.h"
+#include "VertexQuantization.h"
+#include <chrono>
+#include <cstdio>
+
+// Длина в символах, а не байтах — для выравнивания колонок
+std::size_t utf8Length(const char* s) {
+    std::size_t n = 0;
+    for (; *s; ++s) n += (static_cast<unsigned char>(*s) & 0xC0) != 0x80;
+    return n;
+}
+
+// UV-сфера: гладкие нормали по всей сфере — худший случай для развёртки
+Mesh makeSphere(int slices, int stacks) {
+    Mesh mesh;
+    const float pi = 3.14159265f;
+    for (int i = 0; i <= stacks; ++i)
+        for (int j = 0; j <= slices; ++j) {
+            float theta = pi * i / stacks, phi = 2.0f * pi * j / slices;
+            Vertex v{};
+            v.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            v.position = v.normal * 50.0f;
+            v.texCoord = glm::vec2(float(j) / slices, float(i) / stacks);
+            mesh.vertices.push_back(v);
+        }
+    return mesh;
+}
+
+void report(const char* name, const Mesh& mesh) {
+    std::vector<PackedVertex> packed;
+    auto t0 = std::chrono::steady_clock::now();
+    VertexQuantization q = quantizeVertices(mesh.vertices.data(), mesh.vertices.size(), packed);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    const float extent = std::max({ q.scale.x, q.scale.y, q.scale.z });
+    std::printf("%s%*s %8zu %9zu %9zu %12.3g %9.5f%% %9.4f %10.3g %8.2f ms\n",
+        name, static_cast<int>(34 - utf8Length(name)), "", q.vertexCount,
+        q.vertexCount * sizeof(Vertex), packed.size() * sizeof(PackedVertex),
+        q.maxPositionError, extent > 0.0f ? 100.0f * q.maxPositionError / extent : 0.0f,
+        q.maxNormalError, q.maxTexCoordError, ms);
+}
+
+int main() {
+    std::printf("%-34s %8s %9s %9s %12s %10s %9s %10s %11s\n",
+        "", "verts", "bytes", "packed", "pos err", "of bounds", "n err deg", "uv err", "time");
+
+    const char* files[] = {
+        "model.obj",
+        "Objects/Cube.obj", "Objects/Dodecahedron.obj", "Objects/Icosahedron.obj",
+        "Objects/MinFlatSphere.obj", "Objects/Octahedron.obj", "Objects/SphereSmoothobj.obj",
+        "Objects/Tetrahedron.obj", "Objects/test-cube.obj", "Objects/utah_teapot_lowpoly.obj",
+    };
+    for (const char* path : files) {
+        Mesh mesh;
+        if (!loadOBJ(path, mesh)) continue;
+        report(path, mesh);
+    }
+    report("UV-сфера 512x256, радиус 50", makeSphere(512, 256));
+    return 0;
+}
@@ -359,6 +359,7 @@ void InitShader()
 	LoadUniform(Task2, U2_affine, "affine");
 	LoadUniform(Task2, U2_proj, "proj");
 	LoadUniform(Task2, U2_mix_value, "mixValue");
+	LoadUniform(Task2, U2_texture, "ourTexture");
 
 	LoadAttrib(Task3, A3_vertex, "position");
 	//LoadAttrib(Task3, A3_color, "color");
@@ -366,6 +367,8 @@ void InitShader()
 	LoadUniform(Task3, U3_affine, "affine");
 	LoadUniform(Task3, U3_proj, "proj");
 	LoadUniform(Task3, U3_mix_value, "mixValue");
+	LoadUniform(Task3, U3_texture1, "ourTexture1");
+	LoadUniform(Task3, U3_texture2, "ourTexture2");
 
 	LoadAttrib(Task4, A4_vertex, "coord");
 	LoadAttrib(Task4, A4_color, "color");
@@ -401,7 +404,7 @@ void Draw(sf::Window& window)
 			glUniformMatrix4fv(U2_affine, 1, GL_FALSE, glm::value_ptr(affine));
 			glUniformMatrix4fv(U2_proj, 1, GL_FALSE, glm::value_ptr(proj));
 			glUniform1f(U2_mix_value, mix_value);
-			glUniform1i(glGetUniformLocation(Task2, "ourTexture"), 0);
+			glUniform1i(U2_texture, 0);
 			glEnableVertexAttribArray(A2_vertex);
 			glEnableVertexAttribArray(A2_color);
 			glEnableVertexAttribArray(A2_texCoord);
@@ -423,8 +426,8 @@ void Draw(sf::Window& window)
 			glUniformMatrix4fv(U3_affine, 1, GL_FALSE, glm::value_ptr(affine));
 			glUniformMatrix4fv(U3_proj, 1, GL_FALSE, glm::value_ptr(proj));
 			glUniform1f(U3_mix_value, mix_value);
-			glUniform1i(glGetUniformLocation(Task3, "ourTexture1"), 0);
-			glUniform1i(glGetUniformLocation(Task3, "ourTexture2"), 1);
+			glUniform1i(U3_texture1, 0);
+			glUniform1i(U3_texture2, 1);
 			glEnableVertexAttribArray(A3_vertex);
 			//glEnableVertexAttribArray(A3_color);
 			glEnableVertexAttribArray(A3_texCoord);
@@ -33,12 +33,15 @@ GLint A2_color;
 GLint A2_texCoord;
 GLint U2_affine;
 GLint U2_proj;
+GLint U2_texture;
 
 GLint A3_vertex;
 GLint A3_color;
 GLint A3_texCoord;
 GLint U3_affine;
 GLint U3_proj;
+GLint U3_texture1;
+GLint U3_texture2;
 
 GLint A4_vertex;
 GLint A4_color;
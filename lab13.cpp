@@ -1,5 +1,7 @@
 ﻿// main.cpp
 #include "Utils.h"
+#include "MeshCache.h"
+#include "FrameRingBuffer.h"
 #include <gl/GL.h>
 #include <SFML/Window.hpp>
 #include <SFML/OpenGL.hpp>
@@ -55,17 +57,36 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+layout(std140) uniform Frame {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec3 viewPos;
+};
+
+// распаковка PackedVertex (VertexQuantization.h); по умолчанию — float-вершины
+uniform vec3 quantOffset = vec3(0.0);
+uniform vec3 quantScale = vec3(1.0);
+uniform bool octNormals = false;
 
 out vec3 Normal;
 out vec3 FragPos;
 
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal  = mat3(transpose(inverse(model))) * aNormal;
+    vec3 position = quantOffset + aPos * quantScale;
+    vec3 normal = octNormals ? octDecode(aNormal.xy) : aNormal;
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal  = mat3(transpose(inverse(model))) * normal;
     gl_Position = proj * view * vec4(FragPos, 1.0);
 }
 )";
@@ -77,8 +98,14 @@ in vec3 FragPos;
 
 out vec4 FragColor;
 
+layout(std140) uniform Frame {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec3 viewPos;
+};
+
 uniform vec3 lightPos = vec3(5.0,5.0,5.0);
-uniform vec3 viewPos;
 uniform vec3 lightColor = vec3(1.0,1.0,1.0);
 uniform vec3 objectColor = vec3(0.8,0.5,0.3);
 
@@ -106,6 +133,22 @@ void main()
 }
 )";
 
+// Данные кадра — uniform-блок Frame (std140), общий для обоих шейдеров.
+// Структура повторяет его раскладку: mat4 — 64 байта, vec3 + float — 16.
+// Блок пишется в кольцевой буфер (FrameRingBuffer.h) и привязывается
+// glBindBufferRange на смещение кадра.
+const GLuint FRAME_UBO_BINDING = 0;
+
+struct FrameBlockStd140 {
+    glm::mat4 model;
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+static_assert(sizeof(FrameBlockStd140) == 208, "FrameBlockStd140 не совпадает с std140");
+
 // ---------- Утилита создания шейдера ----------
 GLuint compileShader(GLenum type, const char* src) {
     GLuint shader = glCreateShader(type);
@@ -176,17 +219,28 @@ int main() {
 
     // ----- Загрузка модели -----
     Mesh model;
-    if (!loadOBJ("model.obj", model)) {
+    if (!loadOBJCached("model.obj", model, 1, true)) {   // с оптимизацией под кэш вершин
         std::cerr << "Failed to load OBJ.\n";
         return -1;
     }
+    model.quantize = true;   // 16 байт на вершину вместо 32
     model.uploadToGPU();
+    printQuantizationReport("model.obj", model.quantization);
 
     // ----- Uniform locations -----
-    GLint locModel = glGetUniformLocation(shaderProgram, "model");
-    GLint locView = glGetUniformLocation(shaderProgram, "view");
-    GLint locProj = glGetUniformLocation(shaderProgram, "proj");
-    GLint locViewPos = glGetUniformLocation(shaderProgram, "viewPos");
+    UniformTable uniforms(shaderProgram);
+
+    // параметры распаковки — состояние программы, задаются один раз
+    glUseProgram(shaderProgram);
+    model.setDequantizeUniforms(uniforms);
+    glUseProgram(0);
+
+    // ----- Буфер данных кадра -----
+    GLuint frameBlock = glGetUniformBlockIndex(shaderProgram, "Frame");
+    if (frameBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(shaderProgram, frameBlock, FRAME_UBO_BINDING);
+    FrameRingBuffer frameRing;
+    frameRing.create(GL_UNIFORM_BUFFER, sizeof(FrameBlockStd140));
 
     // ----- Камера -----
     Camera cam;
@@ -243,18 +297,26 @@ int main() {
             static_cast<float>(window.getSize().y),
             0.1f, 100.0f);
 
-        glUniformMatrix4fv(locModel, 1, GL_FALSE, &modelMat[0][0]);
-        glUniformMatrix4fv(locView, 1, GL_FALSE, &viewMat[0][0]);
-        glUniformMatrix4fv(locProj, 1, GL_FALSE, &projMat[0][0]);
-        glUniform3fv(locViewPos, 1, &cam.position[0]);
+        frameRing.beginFrame();
+        RingAllocation allocation = frameRing.allocate(sizeof(FrameBlockStd140), frameRing.uniformOffsetAlignment());
+        FrameBlockStd140& frame = *static_cast<FrameBlockStd140*>(allocation.data);
+        frame.model = modelMat;
+        frame.view = viewMat;
+        frame.proj = projMat;
+        frame.viewPos = cam.position;
+        frameRing.flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UBO_BINDING, frameRing.id(),
+                          static_cast<GLintptr>(allocation.offset), sizeof(FrameBlockStd140));
 
         model.draw();
+        frameRing.endFrame();
 
         glUseProgram(0);
         window.display();
     }
 
     // ----- Очистка -----
+    frameRing.destroy();
     glDeleteVertexArrays(1, &model.vao);
     glDeleteBuffers(1, &model.vbo);
     glDeleteBuffers(1, &model.ebo);
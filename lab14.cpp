@@ -1,10 +1,23 @@
 ﻿// main.cpp
 #include "Utils.h"
+#include "AssetCache.h"
+#include "RenderQueue.h"
+#include "Instancing.h"
+#include "GeometryArena.h"
+#include "Transform.h"
+#include "Frustum.h"
+#include "SceneBVH.h"
+#include "LooseOctree.h"
+#include "OcclusionBuffer.h"
 #include <gl/GL.h>
 #include <SFML/Window.hpp>
 #include <SFML/OpenGL.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
 
 // ---------- Камера ----------
 class Camera {
@@ -13,32 +26,34 @@ public:
     float yaw = -90.0f; // горизонтальный угол
     float pitch = 0.0f;   // вертикальный угол
 
-    glm::mat4 getViewMatrix() const {
+    glm::vec3 getFront() const {
         glm::vec3 front;
         front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
         front.y = sin(glm::radians(pitch));
         front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-        return glm::lookAt(position, position + glm::normalize(front), glm::vec3(0, 1, 0));
+        return glm::normalize(front);
+    }
+
+    glm::mat4 getViewMatrix() const {
+        return glm::lookAt(position, position + getFront(), glm::vec3(0, 1, 0));
     }
 };
 
 // ---------- Структура объекта сцены ----------
 struct SceneObject {
-    Mesh mesh;
-    GLuint shaderProgram;
+    MeshHandle mesh;          // меш и программа общие с другими объектами (AssetCache)
+    ProgramHandle program;
     GLuint textureID;
-    glm::vec3 position;
-    glm::vec3 scale;
-    glm::vec3 rotation;
+    Transform transform;      // матрицы модели и нормалей пересчитываются только после изменений
+    glm::vec3 color{ 0.8f, 0.3f, 0.3f };   // цвет экземпляра (шейдер 3)
 
-    // Uniform locations для этого шейдера
-    GLint locModel;
+    // Uniform locations для этого шейдера (модель — атрибут экземпляра)
     GLint locView;
     GLint locProj;
     GLint locViewPos;
     GLint locTexture;
 
-    SceneObject() : shaderProgram(0), textureID(0) {}
+    SceneObject() : textureID(0) {}
 };
 
 // ---------- Шейдеры ----------
@@ -48,8 +63,9 @@ const char* vertexShaderSrc1 = R"(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;   // экземпляр, см. Instancing.h
+layout (location = 8) in mat3 aNormalMatrix;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
@@ -59,8 +75,8 @@ out vec2 TexCoord;
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal  = mat3(transpose(inverse(model))) * aNormal;
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal  = aNormalMatrix * aNormal;
     TexCoord = aTexCoord;
     gl_Position = proj * view * vec4(FragPos, 1.0);
 }
@@ -112,8 +128,8 @@ const char* vertexShaderSrc2 = R"(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;   // экземпляр, см. Instancing.h
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
@@ -122,7 +138,7 @@ out vec2 TexCoord;
 void main()
 {
     TexCoord = aTexCoord;
-    gl_Position = proj * view * model * vec4(aPos, 1.0);
+    gl_Position = proj * view * aModel * vec4(aPos, 1.0);
 }
 )";
 
@@ -148,18 +164,22 @@ const char* vertexShaderSrc3 = R"(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;   // экземпляр, см. Instancing.h
+layout (location = 7) in vec4 aColor;
+layout (location = 8) in mat3 aNormalMatrix;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
 out vec3 Normal;
 out vec3 FragPos;
+out vec3 ObjectColor;
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal  = mat3(transpose(inverse(model))) * aNormal;
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal  = aNormalMatrix * aNormal;
+    ObjectColor = aColor.rgb;
     gl_Position = proj * view * vec4(FragPos, 1.0);
 }
 )";
@@ -168,12 +188,12 @@ const char* fragmentShaderSrc3 = R"(
 #version 330 core
 in vec3 Normal;
 in vec3 FragPos;
+in vec3 ObjectColor;   // цвет экземпляра
 
 out vec4 FragColor;
 
 uniform vec3 lightPos = vec3(5.0,5.0,5.0);
 uniform vec3 viewPos;
-uniform vec3 objectColor = vec3(0.8,0.3,0.3);
 
 void main()
 {
@@ -188,7 +208,7 @@ void main()
     else if (intensity > 0.2) intensity = 0.3;
     else intensity = 0.1;
     
-    vec3 result = intensity * objectColor;
+    vec3 result = intensity * ObjectColor;
     FragColor = vec4(result, 1.0);
 }
 )";
@@ -359,12 +379,63 @@ GLuint loadTexture(const char* path) {
     return textureID;
 }
 
+// Мировая коробка объекта: коробка меша через матрицу модели
+BoundingBox worldBounds(SceneObject& obj) {
+    return transformBox(obj.transform.world(), obj.mesh->boundsMin, obj.mesh->boundsMax);
+}
+
+// ---------- Нагрузочная сцена ----------
+// count икосаэдров решёткой перед камерой: один меш и одна программа на
+// всех, цвет меняется по решётке — параметр материала из буфера экземпляров
+void addStressObjects(AssetCache& assets, std::vector<SceneObject>& sceneObjects, std::size_t count) {
+    MeshHandle mesh = assets.mesh("Objects/Icosahedron.obj");
+    if (!mesh) {
+        std::cerr << "Failed to load icosahedron OBJ.\n";
+        return;
+    }
+    ProgramHandle program = assets.program(vertexShaderSrc3, fragmentShaderSrc3);
+
+    const std::size_t side = static_cast<std::size_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+    const float spacing = 1.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t x = i % side, y = (i / side) % side, z = i / (side * side);
+        SceneObject obj;
+        obj.mesh = mesh;
+        obj.program = program;
+        obj.transform.setPosition(glm::vec3((x - side * 0.5f) * spacing, (y - side * 0.5f) * spacing, -3.0f - z * spacing));
+        obj.transform.setScale(glm::vec3(0.3f));
+        obj.transform.setRotation(glm::vec3(0.0f, static_cast<float>(i * 37 % 360), 0.0f));
+        obj.color = glm::vec3(0.3f + 0.6f * x / side, 0.3f + 0.6f * y / side, 0.3f + 0.6f * z / side);
+        obj.locView = program->uniforms["view"];
+        obj.locProj = program->uniforms["proj"];
+        obj.locViewPos = program->uniforms["viewPos"];
+        obj.locTexture = -1;
+        sceneObjects.push_back(std::move(obj));
+    }
+}
+
 // ---------- main ----------
-int main() {
+// lab14 [--stress N] [--mdi] [--octree]
+//   --stress N — добавить к сцене N икосаэдров (10000–100000),
+//                клавиша I включает и выключает инстансинг
+//   --mdi      — контекст GL 4.3, вся геометрия в общем буфере и отправка
+//                glMultiDrawElementsIndirect (GeometryArena.h)
+//   --octree   — отсекать через свободное октодерево (LooseOctree.h)
+//                вместо BVH; клавиша B перебирает перебор/BVH/октодерево
+int main(int argc, char** argv) {
+    std::size_t stressCount = 0;
+    bool mdiRequested = false;
+    bool octreeRequested = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) stressCount = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--mdi") == 0) mdiRequested = true;
+        else if (std::strcmp(argv[i], "--octree") == 0) octreeRequested = true;
+    }
+
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
-    settings.majorVersion = 3;
+    settings.majorVersion = mdiRequested ? 4 : 3;
     settings.minorVersion = 3;
     settings.attributeFlags = sf::ContextSettings::Core;
     sf::RenderWindow window(sf::VideoMode(sf::Vector2u(1280, 720)), "Multi-Object OBJ Viewer",
@@ -394,39 +465,50 @@ int main() {
     // ----- OpenGL init -----
     glEnable(GL_DEPTH_TEST);
 
+    const bool useMdi = mdiRequested && multiDrawIndirectSupported();
+    if (mdiRequested && !useMdi) {
+        std::cerr << "glMultiDrawElementsIndirect is not supported, using per-batch draws\n";
+    }
+
     // ----- Создаем несколько объектов сцены -----
+    // Один OBJ и одни исходники шейдеров дают один меш и одну программу
+    // на все объекты, которые их используют
+    AssetCache assets(createShaderProgram);
     std::vector<SceneObject> sceneObjects;
+    sceneObjects.reserve(5 + stressCount);
+    // Крупные объекты сцены загораживают остальные (OcclusionBuffer.h):
+    // их геометрия нужна и на CPU
+    MeshLoadOptions occluderMesh;
+    occluderMesh.keepOnCPU = true;
 
     // Объект 1: Сфера с первым шейдером
     {
         SceneObject obj;
 
         // Загружаем модель
-        if (!loadOBJ("Objects/MinFlatSphere.obj", obj.mesh)) {
+        obj.mesh = assets.mesh("Objects/MinFlatSphere.obj", occluderMesh);
+        if (!obj.mesh) {
             std::cerr << "Failed to load sphere OBJ.\n";
         }
         else {
-            obj.mesh.uploadToGPU();
-
             // Создаем шейдер
-            obj.shaderProgram = createShaderProgram(vertexShaderSrc1, fragmentShaderSrc1);
+            obj.program = assets.program(vertexShaderSrc1, fragmentShaderSrc1);
 
             // Загружаем текстуру
             //obj.textureID = loadTexture("Textures/stone_texture.png"); // Предполагается наличие текстуры
 
             // Настройки трансформации
-            obj.position = glm::vec3(-2.0f, 0.0f, 0.0f);
-            obj.scale = glm::vec3(1.0f, 1.0f, 1.0f);
-            obj.rotation = glm::vec3(0.0f, 0.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(-2.0f, 0.0f, 0.0f));
+            obj.transform.setScale(glm::vec3(1.0f, 1.0f, 1.0f));
+            obj.transform.setRotation(glm::vec3(0.0f, 0.0f, 0.0f));
 
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
+            obj.locView = obj.program->uniforms["view"];
+            obj.locProj = obj.program->uniforms["proj"];
+            obj.locViewPos = obj.program->uniforms["viewPos"];
+            obj.locTexture = obj.program->uniforms["texSampler"];
 
-            sceneObjects.push_back(obj);
+            sceneObjects.push_back(std::move(obj));
         }
     }
 
@@ -435,30 +517,28 @@ int main() {
         SceneObject obj;
 
         // Загружаем модель
-        if (!loadOBJ("Objects/MinFlatSphere.obj", obj.mesh)) {
+        obj.mesh = assets.mesh("Objects/MinFlatSphere.obj", occluderMesh);
+        if (!obj.mesh) {
             std::cerr << "Failed to load second sphere OBJ.\n";
         }
         else {
-            obj.mesh.uploadToGPU();
-
             // Создаем шейдер
-            obj.shaderProgram = createShaderProgram(vertexShaderSrc2, fragmentShaderSrc2);
+            obj.program = assets.program(vertexShaderSrc2, fragmentShaderSrc2);
 
             // Загружаем другую текстуру
             //obj.textureID = loadTexture("Textures/metal_texture.png"); // Предполагается наличие текстуры
 
             // Настройки трансформации
-            obj.position = glm::vec3(0.0f, 0.0f, 0.0f);
-            obj.scale = glm::vec3(0.8f, 0.8f, 0.8f);
-            obj.rotation = glm::vec3(0.0f, 45.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+            obj.transform.setScale(glm::vec3(0.8f, 0.8f, 0.8f));
+            obj.transform.setRotation(glm::vec3(0.0f, 45.0f, 0.0f));
 
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
+            obj.locView = obj.program->uniforms["view"];
+            obj.locProj = obj.program->uniforms["proj"];
+            obj.locTexture = obj.program->uniforms["texSampler"];
 
-            sceneObjects.push_back(obj);
+            sceneObjects.push_back(std::move(obj));
         }
     }
 
@@ -467,27 +547,25 @@ int main() {
         SceneObject obj;
 
         // Загружаем модель
-        if (!loadOBJ("Objects/MinFlatSphere.obj", obj.mesh)) {
+        obj.mesh = assets.mesh("Objects/MinFlatSphere.obj", occluderMesh);
+        if (!obj.mesh) {
             std::cerr << "Failed to load test cube OBJ.\n";
         }
         else {
-            obj.mesh.uploadToGPU();
-
             // Создаем шейдер (третий шейдер не использует текстуру)
-            obj.shaderProgram = createShaderProgram(vertexShaderSrc3, fragmentShaderSrc3);
+            obj.program = assets.program(vertexShaderSrc3, fragmentShaderSrc3);
 
             // Настройки трансформации
-            obj.position = glm::vec3(2.0f, 0.0f, 0.0f);
-            obj.scale = glm::vec3(1.2f, 1.2f, 1.2f);
-            obj.rotation = glm::vec3(0.0f, 90.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(2.0f, 0.0f, 0.0f));
+            obj.transform.setScale(glm::vec3(1.2f, 1.2f, 1.2f));
+            obj.transform.setRotation(glm::vec3(0.0f, 90.0f, 0.0f));
 
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
+            obj.locView = obj.program->uniforms["view"];
+            obj.locProj = obj.program->uniforms["proj"];
+            obj.locViewPos = obj.program->uniforms["viewPos"];
 
-            sceneObjects.push_back(obj);
+            sceneObjects.push_back(std::move(obj));
         }
     }
 
@@ -496,27 +574,25 @@ int main() {
         SceneObject obj;
 
         // Загружаем модель
-        if (!loadOBJ("Objects/MinFlatSphere.obj", obj.mesh)) {
+        obj.mesh = assets.mesh("Objects/MinFlatSphere.obj", occluderMesh);
+        if (!obj.mesh) {
             std::cerr << "Failed to load third sphere OBJ.\n";
         }
         else {
-            obj.mesh.uploadToGPU();
-
             // Создаем шейдер (третий шейдер не использует текстуру)
-            obj.shaderProgram = createShaderProgram(vertexShaderSrc3, fragmentShaderSrc3);
+            obj.program = assets.program(vertexShaderSrc3, fragmentShaderSrc3);
 
             // Настройки трансформации
-            obj.position = glm::vec3(0.0f, -0.4f, 2.0f);
-            obj.scale = glm::vec3(0.1f, 0.1f, 0.1f);
-            obj.rotation = glm::vec3(0.0f, 90.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(0.0f, -0.4f, 2.0f));
+            obj.transform.setScale(glm::vec3(0.1f, 0.1f, 0.1f));
+            obj.transform.setRotation(glm::vec3(0.0f, 90.0f, 0.0f));
 
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
+            obj.locView = obj.program->uniforms["view"];
+            obj.locProj = obj.program->uniforms["proj"];
+            obj.locViewPos = obj.program->uniforms["viewPos"];
 
-            sceneObjects.push_back(obj);
+            sceneObjects.push_back(std::move(obj));
         }
     }
 
@@ -525,27 +601,25 @@ int main() {
         SceneObject obj;
 
         // Загружаем модель
-        if (!loadOBJ("Objects/MinFlatSphere.obj", obj.mesh)) {
+        obj.mesh = assets.mesh("Objects/MinFlatSphere.obj", occluderMesh);
+        if (!obj.mesh) {
             std::cerr << "Failed to load third sphere OBJ.\n";
         }
         else {
-            obj.mesh.uploadToGPU();
-
             // Создаем шейдер (третий шейдер не использует текстуру)
-            obj.shaderProgram = createShaderProgram(vertexShaderSrc3, fragmentShaderSrc3);
+            obj.program = assets.program(vertexShaderSrc3, fragmentShaderSrc3);
 
             // Настройки трансформации
-            obj.position = glm::vec3(-1.0f, -0.5f, 1.0f);
-            obj.scale = glm::vec3(0.2f, 0.2f, 0.2f);
-            obj.rotation = glm::vec3(0.0f, 90.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(-1.0f, -0.5f, 1.0f));
+            obj.transform.setScale(glm::vec3(0.2f, 0.2f, 0.2f));
+            obj.transform.setRotation(glm::vec3(0.0f, 90.0f, 0.0f));
 
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
+            obj.locView = obj.program->uniforms["view"];
+            obj.locProj = obj.program->uniforms["proj"];
+            obj.locViewPos = obj.program->uniforms["viewPos"];
 
-            sceneObjects.push_back(obj);
+            sceneObjects.push_back(std::move(obj));
         }
     }
 
@@ -554,6 +628,8 @@ int main() {
         std::cerr << "No objects loaded!\n";
         return -1;
     }
+    if (stressCount) addStressObjects(assets, sceneObjects, stressCount);
+    assets.printReport();
 
     // ----- Камера -----
     Camera cam;
@@ -561,6 +637,98 @@ int main() {
     sf::Vector2i lastMousePos = sf::Mouse::getPosition(window);
     bool firstMouse = true;
 
+    // ----- Очередь отрисовки -----
+    const float nearPlane = 0.1f, farPlane = 100.0f;
+    RenderQueue renderQueue;
+    RenderStateCache renderState;
+    RenderStateStats lastRequested, lastChanged;
+
+    // ----- Отсечение по пирамиде видимости -----
+    // Сферы мешей (Mesh::computeBounds) переводятся в мир и проверяются
+    // пачками cullSpheres; в очередь попадают только видимые объекты
+    BoundingSpheres worldSpheres;
+    std::vector<std::uint32_t> visibleObjects;
+    FrustumCullStats cullStats;
+    bool culling = true;
+
+    // BVH по мировым коробкам (SceneBVH.h): отсечение без обхода всех
+    // объектов и выбор объекта лучом. Строится один раз; объекты, чей
+    // Transform изменился, обновляются refit'ом — их номера сеттеры
+    // Transform кладут в movedObjects. Свободное октодерево (LooseOctree.h)
+    // по тем же коробкам — другой индекс для отсечения: вставка и перенос
+    // объекта дешевле, обход пирамиды дороже
+    SceneBVH sceneBVH;
+    LooseOctree sceneOctree;
+    std::vector<std::uint32_t> movedObjects;
+    {
+        std::vector<BoundingBox> boxes;
+        boxes.reserve(sceneObjects.size());
+        for (std::size_t i = 0; i < sceneObjects.size(); ++i) {
+            boxes.push_back(worldBounds(sceneObjects[i]));
+            sceneObjects[i].transform.trackChanges(&movedObjects, static_cast<std::uint32_t>(i));
+        }
+        sceneBVH.build(boxes);
+        sceneOctree.build(boxes);
+    }
+    std::cout << "Scene index: BVH " << sceneBVH.nodeCount() << " nodes, " << sceneBVH.memoryBytes() / 1024
+              << " KB; octree " << sceneOctree.nodeCount() << " nodes, " << sceneOctree.memoryBytes() / 1024 << " KB" << std::endl;
+    enum class CullingIndex { Linear, BVH, Octree };
+    CullingIndex cullingIndex = octreeRequested ? CullingIndex::Octree : CullingIndex::BVH;
+    // Октодерево обновляется, только пока по нему отсекают; иначе сдвиги
+    // лишь помечают его устаревшим, и оно строится заново при переключении
+    bool octreeStale = false;
+    SpatialQueryStats indexStats;
+
+    // ----- Отсечение перекрытых (OcclusionBuffer.h) -----
+    // Видимые объекты с геометрией на CPU, занимающие на экране заметную
+    // долю (радиус больше OCCLUDER_MIN_SIZE расстояния), рисуются в
+    // программный буфер глубины; остальные видимые проверяются коробкой
+    // по его пирамиде. Клавиша O включает и выключает
+    const float OCCLUDER_MIN_SIZE = 0.1f;
+    OcclusionBuffer occlusionBuffer;
+    std::vector<char> isOccluder(sceneObjects.size(), 0);
+    std::size_t occluderCount = 0, occludedCount = 0;
+    bool occlusion = true;
+
+    // ----- Инстансинг -----
+    // Объекты с общими мешем, программой и текстурой — одна пачка, один вызов
+    InstanceBuffer instanceBuffer;   // матрицы и цвета кадра, кольцевой буфер
+    std::vector<InstanceBatch> batches;
+    bool instancing = true;
+    auto sameState = [&](std::size_t a, std::size_t b) {
+        const SceneObject& x = sceneObjects[a];
+        const SceneObject& y = sceneObjects[b];
+        return x.mesh == y.mesh && x.program == y.program && x.textureID == y.textureID;
+    };
+
+    // ----- Общий буфер геометрии (--mdi) -----
+    // Атрибуты экземпляров привязываются к VAO арены раз в кадр (на секцию
+    // кольцевого буфера): выборку для каждой команды сдвигает её baseInstance.
+    // Меши, которые арена не приняла (упакованные или пустые), рисуются
+    // обычными пачками из своих VAO
+    GeometryArena arena;
+    IndirectCommandBuffer indirect;
+    std::vector<const ArenaRange*> batchRanges;   // диапазон пачки в арене или nullptr
+    if (useMdi) {
+        ArenaRange range;
+        std::size_t rejected = 0;
+        for (const SceneObject& obj : sceneObjects)
+            if (!arena.add(*obj.mesh, range)) ++rejected;
+        arena.upload();
+        if (rejected)
+            std::cout << "Geometry arena: " << rejected << " objects not in the arena, drawn per batch" << std::endl;
+    }
+    auto sameMaterial = [&](std::size_t a, std::size_t b) {
+        const SceneObject& x = sceneObjects[a];
+        const SceneObject& y = sceneObjects[b];
+        return x.program == y.program && x.textureID == y.textureID;
+    };
+
+    // Время CPU на отправку кадра (загрузка экземпляров и вызовы GL), среднее за секунду
+    double submitSeconds = 0.0;
+    int submitFrames = 0;
+    sf::Clock submitClock;
+
     // ----- Главный цикл -----
     while (window.isOpen()) {
         float deltaTime = deltaClock.restart().asSeconds();
@@ -574,6 +742,32 @@ int main() {
             {
                 if (keyPressed->code == sf::Keyboard::Key::Escape)
                     window.close();
+                if (keyPressed->code == sf::Keyboard::Key::I) {
+                    instancing = !instancing;
+                    std::cout << "Instancing " << (instancing ? "on" : "off") << std::endl;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::C) {
+                    culling = !culling;
+                    std::cout << "Frustum culling " << (culling ? "on" : "off") << std::endl;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::B) {
+                    cullingIndex = cullingIndex == CullingIndex::Linear ? CullingIndex::BVH
+                                 : cullingIndex == CullingIndex::BVH ? CullingIndex::Octree : CullingIndex::Linear;
+                    std::cout << "Culling through " << (cullingIndex == CullingIndex::BVH ? "BVH"
+                                 : cullingIndex == CullingIndex::Octree ? "loose octree" : "linear sphere sweep") << std::endl;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::O) {
+                    occlusion = !occlusion;
+                    std::cout << "Occlusion culling " << (occlusion ? "on" : "off") << std::endl;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::P) {
+                    // объект в центре экрана
+                    RayHit hit;
+                    if (sceneBVH.raycast(cam.position, cam.getFront(), hit))
+                        std::cout << "Picked object " << hit.object << " at distance " << hit.distance << std::endl;
+                    else
+                        std::cout << "Nothing picked" << std::endl;
+                }
             }
         }
 
@@ -603,42 +797,237 @@ int main() {
         glm::mat4 projMat = glm::perspective(glm::radians(45.0f),
             static_cast<float>(window.getSize().x) /
             static_cast<float>(window.getSize().y),
-            0.1f, 100.0f);
-
-        // Рендерим каждый объект
-        for (auto& obj : sceneObjects) {
-            glUseProgram(obj.shaderProgram);
-
-            // Создаем матрицу модели для этого объекта
-            glm::mat4 modelMat = glm::mat4(1.0f);
-            modelMat = glm::translate(modelMat, obj.position);
-            modelMat = glm::rotate(modelMat, glm::radians(obj.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelMat = glm::rotate(modelMat, glm::radians(obj.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelMat = glm::rotate(modelMat, glm::radians(obj.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelMat = glm::scale(modelMat, obj.scale);
-
-            // Передаем uniform-переменные
-            glUniformMatrix4fv(obj.locModel, 1, GL_FALSE, &modelMat[0][0]);
-            glUniformMatrix4fv(obj.locView, 1, GL_FALSE, &viewMat[0][0]);
-            glUniformMatrix4fv(obj.locProj, 1, GL_FALSE, &projMat[0][0]);
-
-            // Передаем позицию камеры (если используется в шейдере)
-            if (obj.locViewPos != -1) {
-                glUniform3fv(obj.locViewPos, 1, &cam.position[0]);
+            nearPlane, farPlane);
+
+        // Сдвинутые объекты — в BVH (он нужен и для выбора лучом) и, если
+        // отсекаем по нему, в октодерево; если разбиение BVH испортилось
+        // вдвое, строим заново
+        const bool octreeActive = cullingIndex == CullingIndex::Octree;
+        if (!movedObjects.empty()) {
+            for (std::uint32_t i : movedObjects) {
+                sceneObjects[i].transform.acknowledgeChange();
+                const BoundingBox box = worldBounds(sceneObjects[i]);
+                sceneBVH.update(i, box);
+                if (octreeActive) sceneOctree.update(i, box);
+            }
+            if (!octreeActive) octreeStale = true;
+            movedObjects.clear();
+            sceneBVH.refit();
+            if (sceneBVH.sahCost() > 2.0f * sceneBVH.buildCost()) sceneBVH.rebuild();
+        }
+        if (octreeActive && octreeStale) {
+            std::vector<BoundingBox> boxes;
+            boxes.reserve(sceneObjects.size());
+            for (SceneObject& obj : sceneObjects) boxes.push_back(worldBounds(obj));
+            sceneOctree.build(boxes);
+            octreeStale = false;
+        }
+
+        visibleObjects.clear();
+        cullStats = FrustumCullStats();
+        indexStats = SpatialQueryStats();
+        if (culling && cullingIndex != CullingIndex::Linear) {
+            if (cullingIndex == CullingIndex::BVH)
+                sceneBVH.queryFrustum(extractFrustum(projMat * viewMat), visibleObjects, &indexStats);
+            else
+                sceneOctree.queryFrustum(extractFrustum(projMat * viewMat), visibleObjects, &indexStats);
+            cullStats.tested = indexStats.objectsTested;
+            cullStats.visible = visibleObjects.size();
+            cullStats.culled = sceneObjects.size() - visibleObjects.size();
+        }
+        else if (culling) {
+            // Мировая сфера объекта — центр сферы меша через матрицу модели,
+            // радиус умножен на наибольший масштаб по осям
+            worldSpheres.clear();
+            worldSpheres.reserve(sceneObjects.size());
+            for (SceneObject& obj : sceneObjects) {
+                const glm::mat4& world = obj.transform.world();
+                const float scale2 = std::max({ glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                                glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+                                                glm::dot(glm::vec3(world[2]), glm::vec3(world[2])) });
+                worldSpheres.push(glm::vec3(world * glm::vec4(obj.mesh->boundsCenter, 1.0f)),
+                                  obj.mesh->boundsRadius * std::sqrt(scale2));
+            }
+            cullSpheres(extractFrustum(projMat * viewMat), worldSpheres, visibleObjects, &cullStats);
+        }
+        else {
+            for (std::size_t i = 0; i < sceneObjects.size(); ++i) visibleObjects.push_back(static_cast<std::uint32_t>(i));
+            cullStats.tested = cullStats.visible = sceneObjects.size();
+        }
+
+        occluderCount = occludedCount = 0;
+        if (occlusion && !visibleObjects.empty()) {
+            occlusionBuffer.begin(projMat * viewMat);
+            for (std::uint32_t i : visibleObjects) {
+                SceneObject& obj = sceneObjects[i];
+                isOccluder[i] = 0;
+                if (obj.mesh->vertexCount() == 0) continue;
+                const BoundingBox box = worldBounds(obj);
+                if (glm::length(box.max - box.min) * 0.5f < OCCLUDER_MIN_SIZE * glm::length(box.center() - cam.position))
+                    continue;
+                occlusionBuffer.drawOccluder(obj.transform.world(), obj.mesh->vertexData(), sizeof(Vertex),
+                    obj.mesh->vertexCount(), obj.mesh->indexData(), obj.mesh->indexCount());
+                isOccluder[i] = 1;
+                ++occluderCount;
+            }
+            if (occluderCount > 0) {
+                occlusionBuffer.buildPyramid();
+                std::size_t kept = 0;
+                for (std::uint32_t i : visibleObjects) {
+                    if (!isOccluder[i]) {
+                        const BoundingBox box = worldBounds(sceneObjects[i]);
+                        if (!occlusionBuffer.boxVisible(box.min, box.max)) continue;
+                    }
+                    visibleObjects[kept++] = i;
+                }
+                occludedCount = visibleObjects.size() - kept;
+                visibleObjects.resize(kept);
+                cullStats.visible = kept;
+                cullStats.culled += occludedCount;
+            }
+        }
+
+        // Ключи сортировки: программа, текстура, VAO, глубина
+        renderQueue.clear();
+        for (std::uint32_t i : visibleObjects) {
+            const SceneObject& obj = sceneObjects[i];
+            const bool textured = obj.textureID != 0 && obj.locTexture != -1;
+            const float depth = -(viewMat * glm::vec4(obj.transform.position(), 1.0f)).z;
+            renderQueue.push(makeSortKey(obj.program->id, textured ? obj.textureID : 0, obj.mesh->vao,
+                depth, nearPlane, farPlane), i);
+        }
+        renderQueue.sort();
+
+        // Экземпляры в порядке очереди: у каждой пачки непрерывный диапазон.
+        // Без инстансинга (и без --mdi) объекты рисуются по одному и буфер
+        // экземпляров не заполняется
+        const bool perObject = !instancing && !useMdi;
+        InstanceData* instances = instanceBuffer.begin(perObject ? 0 : renderQueue.size());
+        std::size_t instanceCount = 0;
+        if (!perObject) {
+            for (const RenderItem& item : renderQueue) {
+                SceneObject& obj = sceneObjects[item.index];
+
+                // Матрицы из кэша Transform: у неподвижных объектов не пересчитываются
+                InstanceData& instance = instances[instanceCount++];
+                instance.model = obj.transform.world();
+                instance.color = glm::vec4(obj.color, 1.0f);
+                const glm::mat3& normalMatrix = obj.transform.normalMatrix();
+                for (int c = 0; c < 3; ++c) instance.normal[c] = glm::vec4(normalMatrix[c], 0.0f);
+            }
+        }
+        buildInstanceBatches(renderQueue, sameState, instancing, batches);
+
+        // Программа с uniform'ами камеры и текстура объекта
+        auto bindMaterial = [&](const SceneObject& obj) {
+            // Камера общая для всех объектов программы — задаём при смене программы
+            if (renderState.useProgram(obj.program->id)) {
+                glUniformMatrix4fv(obj.locView, 1, GL_FALSE, &viewMat[0][0]);
+                glUniformMatrix4fv(obj.locProj, 1, GL_FALSE, &projMat[0][0]);
+
+                // Передаем позицию камеры (если используется в шейдере)
+                if (obj.locViewPos != -1) {
+                    glUniform3fv(obj.locViewPos, 1, &cam.position[0]);
+                }
             }
 
             // Привязываем текстуру (если есть)
             if (obj.textureID != 0 && obj.locTexture != -1) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, obj.textureID);
+                renderState.bindTexture(obj.textureID);
                 glUniform1i(obj.locTexture, 0);
             }
+        };
+
+        // Рендерим пачки в порядке очереди
+        const auto submitStart = std::chrono::steady_clock::now();
+        instanceBuffer.flush();
+        renderState.begin();
+        if (useMdi) {
+            // Команда на пачку; подряд идущие пачки с одной программой и
+            // текстурой — один glMultiDrawElementsIndirect
+            indirect.clear();
+            batchRanges.clear();
+            for (const InstanceBatch& batch : batches) {
+                const ArenaRange* range = arena.find(*sceneObjects[batch.object].mesh);
+                batchRanges.push_back(range);
+                if (range) indirect.add(*range, batch.first, batch.count);
+            }
+            indirect.upload();
+            renderState.bindVertexArray(arena.merged.vao);
+            instanceBuffer.bindAttributes(0);
+            std::size_t command = 0;
+            for (std::size_t first = 0; first < batches.size();) {
+                const SceneObject& obj = sceneObjects[batches[first].object];
+                bindMaterial(obj);
+                if (!batchRanges[first]) {
+                    // меша нет в арене — обычная пачка из его VAO
+                    renderState.bindVertexArray(obj.mesh->vao);
+                    instanceBuffer.bindAttributes(batches[first].first);
+                    renderState.drawInstanced(*obj.mesh, batches[first].count);
+                    ++first;
+                    continue;
+                }
+
+                std::size_t last = first, instanceTotal = 0;
+                while (last < batches.size() && batchRanges[last] &&
+                       sameMaterial(batches[first].object, batches[last].object))
+                    instanceTotal += batches[last++].count;
+                // атрибуты VAO арены с начала кадра не менялись
+                renderState.bindVertexArray(arena.merged.vao);
+                indirect.draw(command, last - first);
+                renderState.countDraw(instanceTotal);
+                command += last - first;
+                first = last;
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else if (perObject) {
+            // По объекту: атрибуты экземпляра — текущими значениями, массивы
+            // выключаются один раз на привязку VAO
+            for (const RenderItem& item : renderQueue) {
+                const SceneObject& obj = sceneObjects[item.index];
+                bindMaterial(obj);
+                if (renderState.bindVertexArray(obj.mesh->vao)) InstanceBuffer::disableAttributes();
+                InstanceBuffer::setCurrent(obj.transform.world(), glm::vec4(obj.color, 1.0f), obj.transform.normalMatrix());
+                obj.mesh->drawBound();
+                renderState.countDraw(1);
+            }
+        }
+        else {
+            for (const InstanceBatch& batch : batches) {
+                const SceneObject& obj = sceneObjects[batch.object];
+                bindMaterial(obj);
+
+                // Рисуем пачку: атрибуты экземпляров — на её диапазон
+                renderState.bindVertexArray(obj.mesh->vao);
+                instanceBuffer.bindAttributes(batch.first);
+                renderState.drawInstanced(*obj.mesh, batch.count);
+            }
+        }
+        renderState.end();
+        instanceBuffer.end();
+        submitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+        ++submitFrames;
+        if (submitClock.getElapsedTime().asSeconds() >= 1.0f) {
+            std::cout << "CPU submit: " << submitSeconds * 1000.0 / submitFrames << " ms/frame, "
+                      << renderState.changed.draws << " draws for " << cullStats.visible << " of " << sceneObjects.size()
+                      << " objects, " << cullStats.culled << " culled, " << cullStats.tested << " tested, "
+                      << indexStats.nodesVisited << " index nodes, " << occludedCount << " occluded by "
+                      << occluderCount << " occluders (instancing "
+                      << (instancing ? "on" : "off") << (useMdi ? ", multi-draw indirect" : "")
+                      << (instanceBuffer.persistent() ? ", persistent ring" : ", orphaned buffer") << ")" << std::endl;
+            submitSeconds = 0.0;
+            submitFrames = 0;
+            submitClock.restart();
+        }
 
-            // Рисуем объект
-            obj.mesh.draw();
+        // Отчёт, когда число смен состояния изменилось
+        if (renderState.requested != lastRequested || renderState.changed != lastChanged) {
+            printRenderStateReport(renderState.requested, renderState.changed);
+            lastRequested = renderState.requested;
+            lastChanged = renderState.changed;
         }
 
-        glUseProgram(0);
         window.display();
     }
 
@@ -647,11 +1036,12 @@ int main() {
         if (obj.textureID != 0) {
             glDeleteTextures(1, &obj.textureID);
         }
-        if (obj.shaderProgram != 0) {
-            glDeleteProgram(obj.shaderProgram);
-        }
-        obj.mesh.cleanup();
     }
+    instanceBuffer.cleanup();
+    indirect.cleanup();
+    arena.cleanup();
+    // меши и программы удаляются вместе с последним handle'ом — пока жив контекст
+    sceneObjects.clear();
 
     return 0;
 }
\ No newline at end of file
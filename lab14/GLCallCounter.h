@@ -0,0 +1,94 @@
+#pragma once
+
+#include <iostream>
+#include <cstddef>
+#include <GL/glew.h>
+
+// Счётчик вызовов GL: после glewInit указатели GLEW на выбранные функции
+// подменяются обёртками, которые считают вызов и зовут настоящую функцию.
+// Функции GL 1.1 (glClear, glDrawElements, glBindTexture...) драйвер
+// экспортирует напрямую, мимо GLEW, поэтому они не считаются.
+
+template <auto* Slot>
+struct GLCallHook;
+
+template <class R, class... Args, R (GLAPIENTRY** Slot)(Args...)>
+struct GLCallHook<Slot> {
+    static inline R (GLAPIENTRY* original)(Args...) = nullptr;
+    static inline unsigned long calls = 0;
+
+    static R GLAPIENTRY call(Args... args) {
+        ++calls;
+        return original(args...);
+    }
+
+    static void install() {
+        if (*Slot == nullptr || *Slot == &call) return;
+        original = *Slot;
+        *Slot = &call;
+    }
+};
+
+struct GLCallCounterEntry {
+    const char* name;
+    unsigned long* calls;
+    void (*install)();
+};
+
+#define GL_COUNTED(fn) { #fn, &GLCallHook<&fn>::calls, &GLCallHook<&fn>::install }
+
+// Функции, которые вызываются в кадре
+GLCallCounterEntry* glCallCounterEntries(size_t& count) {
+    static GLCallCounterEntry entries[] = {
+        GL_COUNTED(glUseProgram),
+        GL_COUNTED(glGetUniformLocation),
+        GL_COUNTED(glUniform1i),
+        GL_COUNTED(glUniform1f),
+        GL_COUNTED(glUniform3f),
+        GL_COUNTED(glUniform3fv),
+        GL_COUNTED(glUniformMatrix4fv),
+        GL_COUNTED(glActiveTexture),
+        GL_COUNTED(glBindVertexArray),
+        GL_COUNTED(glBindBuffer),
+        GL_COUNTED(glBufferData),
+        GL_COUNTED(glBufferSubData),
+        GL_COUNTED(glBindBufferRange),
+        GL_COUNTED(glClientWaitSync),
+        GL_COUNTED(glDeleteSync),
+        GL_COUNTED(glFenceSync),
+    };
+    count = sizeof(entries) / sizeof(entries[0]);
+    return entries;
+}
+
+#undef GL_COUNTED
+
+void installGLCallCounter() {
+    size_t count;
+    GLCallCounterEntry* entries = glCallCounterEntries(count);
+    for (size_t i = 0; i < count; ++i) entries[i].install();
+}
+
+unsigned long glCallTotal() {
+    size_t count;
+    GLCallCounterEntry* entries = glCallCounterEntries(count);
+    unsigned long total = 0;
+    for (size_t i = 0; i < count; ++i) total += *entries[i].calls;
+    return total;
+}
+
+void resetGLCallCounter() {
+    size_t count;
+    GLCallCounterEntry* entries = glCallCounterEntries(count);
+    for (size_t i = 0; i < count; ++i) *entries[i].calls = 0;
+}
+
+// Итог и разбивка по функциям (нулевые пропускаются)
+void printGLCallReport(const char* title) {
+    size_t count;
+    GLCallCounterEntry* entries = glCallCounterEntries(count);
+    std::cout << title << ": " << glCallTotal() << " вызовов GL";
+    for (size_t i = 0; i < count; ++i)
+        if (*entries[i].calls) std::cout << ", " << entries[i].name << " " << *entries[i].calls;
+    std::cout << std::endl;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/* ------------------------------------------------------------------ */
+// Кластерное (froxel) назначение источников света на CPU. Пирамида
+// видимости делится на TILES_X x TILES_Y плиток экрана и SLICES срезов
+// глубины; срезы растут по экспоненте от near к far, так что у камеры
+// они тонкие, вдали — толстые. Кластер (tx, ty, s) лежит в grid под
+// номером (s * TILES_Y + ty) * TILES_X + tx — так его находит шейдер:
+// плитка по gl_FragCoord, срез — floor(log(глубина / near) * sliceScale()).
+//
+// Источник задаётся сферой влияния в координатах вида (камера в начале
+// координат, смотрит в -z). Для каждой сферы перебираются только кластеры
+// из её диапазона срезов и плиток, и каждый проверяется коробкой кластера.
+// Результат — компактный список: grid хранит пары (смещение, число) в
+// indices, номера источников в кластере идут по возрастанию.
+class LightClusters {
+public:
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 9;
+    static constexpr int SLICES = 24;
+    static constexpr int COUNT = TILES_X * TILES_Y * SLICES;
+
+    // Перспектива как у glm::perspective (fovY в радианах). Коробки
+    // кластеров пересчитываются только здесь
+    void setProjection(float fovY, float aspect, float nearPlane, float farPlane) {
+        zNear = nearPlane;
+        zFar = farPlane;
+        tanY = std::tan(fovY * 0.5f);
+        tanX = tanY * aspect;
+        scale = SLICES / std::log(farPlane / nearPlane);
+
+        boxes.resize(COUNT);
+        for (int s = 0; s < SLICES; ++s) {
+            const float zn = sliceDepth(s), zf = sliceDepth(s + 1);
+            for (int ty = 0; ty < TILES_Y; ++ty) {
+                const float y0 = tileTangent(ty, TILES_Y, tanY), y1 = tileTangent(ty + 1, TILES_Y, tanY);
+                for (int tx = 0; tx < TILES_X; ++tx) {
+                    const float x0 = tileTangent(tx, TILES_X, tanX), x1 = tileTangent(tx + 1, TILES_X, tanX);
+                    Box& b = boxes[(s * TILES_Y + ty) * TILES_X + tx];
+                    b.min = glm::vec3(std::min(x0 * zn, x0 * zf), std::min(y0 * zn, y0 * zf), -zf);
+                    b.max = glm::vec3(std::max(x1 * zn, x1 * zf), std::max(y1 * zn, y1 * zf), -zn);
+                }
+            }
+        }
+    }
+
+    // Сферы влияния (xyz — центр в координатах вида, w — радиус)
+    void assign(const std::vector<glm::vec4>& spheres) {
+        counts.assign(COUNT, 0);
+        pairs.clear();
+        for (std::uint32_t light = 0; light < spheres.size(); ++light) {
+            const glm::vec4& sphere = spheres[light];
+            const glm::vec3 center(sphere);
+            const float radius = sphere.w;
+            const float depth = -center.z;
+            if (depth + radius < zNear || depth - radius > zFar) continue;
+            const int s0 = slice(std::max(depth - radius, zNear));
+            const int s1 = slice(std::min(depth + radius, zFar));
+            for (int s = s0; s <= s1; ++s) {
+                // диапазон плиток в срезе: наименьший и наибольший тангенс
+                // точек сферы на глубинах среза
+                const float zn = sliceDepth(s), zf = sliceDepth(s + 1);
+                const int tx0 = tile(minTangent(center.x - radius, zn, zf), TILES_X, tanX);
+                const int tx1 = tile(maxTangent(center.x + radius, zn, zf), TILES_X, tanX);
+                const int ty0 = tile(minTangent(center.y - radius, zn, zf), TILES_Y, tanY);
+                const int ty1 = tile(maxTangent(center.y + radius, zn, zf), TILES_Y, tanY);
+                for (int ty = ty0; ty <= ty1; ++ty)
+                    for (int tx = tx0; tx <= tx1; ++tx) {
+                        const std::uint32_t cluster = (s * TILES_Y + ty) * TILES_X + tx;
+                        const Box& b = boxes[cluster];
+                        const glm::vec3 d = glm::max(glm::max(b.min - center, center - b.max), glm::vec3(0.0f));
+                        if (glm::dot(d, d) > radius * radius) continue;
+                        pairs.push_back({ cluster, light });
+                        ++counts[cluster];
+                    }
+            }
+        }
+
+        // пары по кластерам: смещения — префиксные суммы числа источников
+        grid.resize(2 * COUNT);
+        std::uint32_t offset = 0;
+        for (int c = 0; c < COUNT; ++c) {
+            grid[2 * c] = offset;
+            grid[2 * c + 1] = counts[c];
+            counts[c] = offset;
+            offset += grid[2 * c + 1];
+        }
+        list.resize(offset);
+        for (const Pair& p : pairs) list[counts[p.cluster]++] = p.light;
+    }
+
+    const std::vector<std::uint32_t>& clusterGrid() const { return grid; }   // (смещение, число) на кластер
+    const std::vector<std::uint32_t>& indices() const { return list; }
+    float nearPlane() const { return zNear; }
+    float sliceScale() const { return scale; }   // срезов на единицу log(глубина / near)
+
+    // Кластер точки в координатах вида или -1 вне пирамиды (как в шейдере)
+    int clusterOf(const glm::vec3& p) const {
+        const float depth = -p.z;
+        if (depth < zNear || depth > zFar) return -1;
+        const float x = (p.x / (depth * tanX) * 0.5f + 0.5f) * TILES_X;
+        const float y = (p.y / (depth * tanY) * 0.5f + 0.5f) * TILES_Y;
+        if (x < 0.0f || y < 0.0f || x >= TILES_X || y >= TILES_Y) return -1;
+        return (slice(depth) * TILES_Y + static_cast<int>(y)) * TILES_X + static_cast<int>(x);
+    }
+
+private:
+    struct Box {
+        glm::vec3 min, max;
+    };
+    struct Pair {
+        std::uint32_t cluster, light;
+    };
+
+    float sliceDepth(int s) const { return zNear * std::pow(zFar / zNear, static_cast<float>(s) / SLICES); }
+    int slice(float depth) const {
+        return std::min(SLICES - 1, std::max(0, static_cast<int>(std::log(depth / zNear) * scale)));
+    }
+    // Граница плитки i из n по тангенсу угла (x / глубина)
+    static float tileTangent(int i, int n, float tanHalf) { return tanHalf * (2.0f * i / n - 1.0f); }
+    static int tile(float tangent, int n, float tanHalf) {
+        const float t = (tangent / tanHalf * 0.5f + 0.5f) * n;
+        return std::min(n - 1, std::max(0, static_cast<int>(std::floor(t))));
+    }
+    // Тангенс координаты v на глубинах [zn, zf]: отрицательный больше по
+    // модулю ближе, положительный — наоборот
+    static float minTangent(float v, float zn, float zf) { return v / (v < 0.0f ? zn : zf); }
+    static float maxTangent(float v, float zn, float zf) { return v / (v > 0.0f ? zn : zf); }
+
+    float zNear = 0.1f, zFar = 100.0f, tanX = 1.0f, tanY = 1.0f, scale = 1.0f;
+    std::vector<Box> boxes;
+    std::vector<std::uint32_t> counts;
+    std::vector<Pair> pairs;
+    std::vector<std::uint32_t> grid, list;
+};
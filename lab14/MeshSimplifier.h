@@ -0,0 +1,450 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/glm.hpp>
+#include "Utils.h"
+
+// Упрощение меша стягиванием рёбер по квадрикам ошибки (Garland, Heckbert,
+// "Surface Simplification Using Quadric Error Metrics") и цепочка LOD.
+//
+// Вершины с одной позицией, но разными нормалями/UV (швы) стягиваются
+// только вдоль шва и обе сразу, поэтому развёртка не рвётся. Края открытых
+// поверхностей двигаются только вдоль края. Всё остальное, где топология
+// сложнее, не трогается. Разница нормалей и UV добавляется к цене
+// стягивания, так что раньше стягиваются рёбра внутри гладких областей.
+
+// Квадрика: взвешенная сумма квадратов расстояний до плоскостей
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0;
+    double weight = 0;
+
+    // Плоскость n·p + d = 0, |n| = 1
+    void addPlane(const glm::vec3& n, float d, double w) {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+        b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+        weight += q.weight;
+    }
+
+    // Средний квадрат расстояния от точки до плоскостей
+    double error(const glm::vec3& p) const {
+        if (weight <= 0) return 0;
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z
+                 + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                 + 2 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(e, 0.0) / weight;
+    }
+};
+
+enum SimplifyVertexKind {
+    SIMPLIFY_MANIFOLD,  // внутренняя вершина, стягивается куда угодно
+    SIMPLIFY_BORDER,    // на крае открытой поверхности, только вдоль края
+    SIMPLIFY_SEAM,      // на шве нормалей/UV, только вдоль шва
+    SIMPLIFY_LOCKED     // сложная топология, не двигается
+};
+
+// Вес плоскостей, удерживающих края и швы на месте
+const double SIMPLIFY_EDGE_WEIGHT = 10.0;
+// Вклад разницы атрибутов в цену стягивания (в долях радиуса меша)
+const float SIMPLIFY_NORMAL_WEIGHT = 0.01f;
+const float SIMPLIFY_UV_WEIGHT = 0.05f;
+
+inline unsigned long long simplifyEdgeKey(unsigned a, unsigned b) {
+    return (static_cast<unsigned long long>(a) << 32) | b;
+}
+
+// Упростить треугольники indices (индексы в vertices) до targetIndexCount
+// индексов или пока ошибка не превысит maxError (в единицах модели).
+// Возвращает новые индексы по тем же вершинам; outError — достигнутая
+// ошибка (наибольшее отклонение от исходной поверхности по квадрикам).
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices,
+                                       const std::vector<unsigned int>& indices,
+                                       size_t targetIndexCount, float maxError, float* outError = nullptr) {
+    std::vector<unsigned int> result(indices);
+    if (outError) *outError = 0.0f;
+    const size_t vertexCount = vertices.size();
+    if (vertexCount == 0 || indices.size() < 3 || indices.size() <= targetIndexCount) return result;
+
+    // Вершины с одной позицией — одна точка поверхности; ключ — биты float
+    std::vector<unsigned> positionOf(vertexCount);
+    std::vector<unsigned> wedgeNext(vertexCount);
+    {
+        std::unordered_map<std::tuple<int, int, int>, unsigned int, IndexTripleHash> firstAt;
+        firstAt.reserve(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            // +0.0f убирает -0: у точек на шве ноль часто с разными знаками
+            const glm::vec3 p = vertices[v].position + glm::vec3(0.0f);
+            int bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            auto it = firstAt.emplace(std::make_tuple(bits[0], bits[1], bits[2]), static_cast<unsigned>(v)).first;
+            unsigned first = it->second;
+            positionOf[v] = first;
+            // кольцевой список вершин одной позиции
+            wedgeNext[v] = static_cast<unsigned>(v);
+            if (first != v) {
+                wedgeNext[v] = wedgeNext[first];
+                wedgeNext[first] = static_cast<unsigned>(v);
+            }
+        }
+    }
+
+    // треугольники с совпадающими позициями (например, у полюсов
+    // UV-сферы) ничего не рисуют и только путают топологию
+    {
+        size_t write = 0;
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            unsigned a = result[i], b = result[i + 1], c = result[i + 2];
+            if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    float radius = 0.0f;
+    {
+        glm::vec3 lo = vertices[0].position, hi = lo;
+        for (const Vertex& v : vertices) {
+            lo = glm::min(lo, v.position);
+            hi = glm::max(hi, v.position);
+        }
+        radius = std::max(glm::length(hi - lo) * 0.5f, 1e-6f);
+    }
+
+    // Квадрики по позициям: плоскости треугольников (вес — площадь)
+    // и перпендикулярные плоскости вдоль краёв и швов
+    std::vector<Quadric> quadrics(vertexCount);
+    {
+        std::unordered_set<unsigned long long> positionEdges, vertexEdges;
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+            for (int k = 0; k < 3; ++k) {
+                unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+                positionEdges.insert(simplifyEdgeKey(positionOf[a], positionOf[b]));
+                vertexEdges.insert(simplifyEdgeKey(a, b));
+            }
+
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            const glm::vec3& p0 = vertices[result[i]].position;
+            const glm::vec3& p1 = vertices[result[i + 1]].position;
+            const glm::vec3& p2 = vertices[result[i + 2]].position;
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float doubleArea = glm::length(n);
+            if (doubleArea <= 0.0f) continue;
+            n /= doubleArea;
+
+            Quadric q;
+            q.addPlane(n, -glm::dot(n, p0), doubleArea * 0.5);
+            for (int k = 0; k < 3; ++k) quadrics[positionOf[result[i + k]]].add(q);
+
+            for (int k = 0; k < 3; ++k) {
+                unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+                bool border = !positionEdges.count(simplifyEdgeKey(positionOf[b], positionOf[a]));
+                bool seam = !border && !vertexEdges.count(simplifyEdgeKey(b, a));
+                if (!border && !seam) continue;
+
+                const glm::vec3& pa = vertices[a].position;
+                glm::vec3 edge = vertices[b].position - pa;
+                float length = glm::length(edge);
+                if (length <= 0.0f) continue;
+                glm::vec3 side = glm::cross(edge, n);
+                float sideLength = glm::length(side);
+                if (sideLength <= 0.0f) continue;
+                side /= sideLength;
+
+                Quadric e;
+                e.addPlane(side, -glm::dot(side, pa), SIMPLIFY_EDGE_WEIGHT * length * length);
+                quadrics[positionOf[a]].add(e);
+                quadrics[positionOf[b]].add(e);
+            }
+        }
+    }
+
+    struct Collapse {
+        unsigned from, to;
+        float cost;      // для порядка: геометрия + атрибуты
+        float error;     // только геометрия
+    };
+
+    std::vector<unsigned char> kind(vertexCount);
+    std::vector<unsigned> remap(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    std::vector<unsigned> mark(vertexCount, 0);   // для условия связности
+    unsigned pass = 0;
+    std::vector<Collapse> collapses;
+    float resultError = 0.0f;
+
+    size_t triangleCount = result.size() / 3;
+    const size_t targetTriangles = targetIndexCount / 3;
+
+    for (; triangleCount > targetTriangles; ++pass) {
+        // --- топология текущего меша ---
+        std::unordered_set<unsigned long long> positionEdges, vertexEdges;
+        std::vector<unsigned> referenced(vertexCount, 0);
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; ++k) {
+                unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+                positionEdges.insert(simplifyEdgeKey(positionOf[a], positionOf[b]));
+                vertexEdges.insert(simplifyEdgeKey(a, b));
+                referenced[a] = 1;
+            }
+
+        // открытые рёбра по позициям и швы по вершинам: сколько входит и выходит
+        std::vector<unsigned char> borderOut(vertexCount, 0), borderIn(vertexCount, 0);
+        std::vector<unsigned char> seamOut(vertexCount, 0), seamIn(vertexCount, 0);
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; ++k) {
+                unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+                if (!positionEdges.count(simplifyEdgeKey(positionOf[b], positionOf[a]))) {
+                    if (borderOut[positionOf[a]] < 255) ++borderOut[positionOf[a]];
+                    if (borderIn[positionOf[b]] < 255) ++borderIn[positionOf[b]];
+                }
+                else if (!vertexEdges.count(simplifyEdgeKey(b, a))) {
+                    if (seamOut[a] < 255) ++seamOut[a];
+                    if (seamIn[b] < 255) ++seamIn[b];
+                }
+            }
+
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (!referenced[v]) { kind[v] = SIMPLIFY_LOCKED; continue; }
+            unsigned p = positionOf[v];
+            unsigned wedgeCount = 0;
+            bool simpleSeam = true;
+            unsigned w = static_cast<unsigned>(v);
+            do {
+                if (referenced[w]) {
+                    ++wedgeCount;
+                    simpleSeam = simpleSeam && seamOut[w] == 1 && seamIn[w] == 1;
+                }
+                w = wedgeNext[w];
+            } while (w != v);
+
+            bool border = borderOut[p] || borderIn[p];
+            if (!border && wedgeCount == 1) kind[v] = SIMPLIFY_MANIFOLD;
+            else if (!border && wedgeCount == 2 && simpleSeam) kind[v] = SIMPLIFY_SEAM;
+            else if (border && wedgeCount == 1 && borderOut[p] == 1 && borderIn[p] == 1) kind[v] = SIMPLIFY_BORDER;
+            else kind[v] = SIMPLIFY_LOCKED;
+        }
+
+        // треугольники вокруг каждой позиции (для проверки переворотов)
+        std::vector<unsigned> adjacencyOffset(vertexCount + 1, 0);
+        for (unsigned idx : result) ++adjacencyOffset[positionOf[idx] + 1];
+        for (size_t v = 0; v < vertexCount; ++v) adjacencyOffset[v + 1] += adjacencyOffset[v];
+        std::vector<unsigned> adjacency(result.size());
+        {
+            std::vector<unsigned> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i)
+                adjacency[fill[positionOf[result[i]]]++] = static_cast<unsigned>(i / 3);
+        }
+
+        // --- кандидаты ---
+        auto isBorderEdge = [&](unsigned a, unsigned b) {
+            return !positionEdges.count(simplifyEdgeKey(positionOf[b], positionOf[a])) ||
+                   !positionEdges.count(simplifyEdgeKey(positionOf[a], positionOf[b]));
+        };
+        auto isSeamEdge = [&](unsigned a, unsigned b) {
+            return (vertexEdges.count(simplifyEdgeKey(a, b)) && !vertexEdges.count(simplifyEdgeKey(b, a))) ||
+                   (vertexEdges.count(simplifyEdgeKey(b, a)) && !vertexEdges.count(simplifyEdgeKey(a, b)));
+        };
+        auto canCollapse = [&](unsigned from, unsigned to) {
+            switch (kind[from]) {
+            case SIMPLIFY_MANIFOLD: return true;
+            case SIMPLIFY_BORDER: return isBorderEdge(from, to);
+            case SIMPLIFY_SEAM: return isSeamEdge(from, to);
+            default: return false;
+            }
+        };
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; ++k) {
+                unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir) {
+                    unsigned from = dir ? b : a, to = dir ? a : b;
+                    if (!canCollapse(from, to)) continue;
+
+                    float geometric = static_cast<float>(quadrics[positionOf[from]].error(vertices[to].position));
+                    glm::vec3 dn = vertices[from].normal - vertices[to].normal;
+                    glm::vec2 duv = vertices[from].texCoord - vertices[to].texCoord;
+                    float attributes = (SIMPLIFY_NORMAL_WEIGHT * glm::dot(dn, dn) +
+                                        SIMPLIFY_UV_WEIGHT * glm::dot(duv, duv)) * radius * radius;
+                    float error = std::sqrt(geometric);
+                    if (error > maxError) continue;
+                    collapses.push_back({ from, to, geometric + attributes, error });
+                }
+            }
+        if (collapses.empty()) break;
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+        // --- стягивание: за проход каждая окрестность меняется не больше раза ---
+        for (size_t v = 0; v < vertexCount; ++v) remap[v] = static_cast<unsigned>(v);
+        std::fill(locked.begin(), locked.end(), false);
+
+        // каждое стягивание убирает примерно два треугольника
+        const size_t trianglesToRemove = triangleCount - targetTriangles;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse& c : collapses) {
+            if (removed >= trianglesToRemove) break;
+            unsigned pFrom = positionOf[c.from], pTo = positionOf[c.to];
+            if (pFrom == pTo || locked[pFrom] || locked[pTo]) continue;
+
+            // для шва — парная вершина по другую сторону и её цель
+            unsigned partnerFrom = c.from, partnerTo = c.to;
+            if (kind[c.from] == SIMPLIFY_SEAM) {
+                partnerFrom = wedgeNext[c.from];
+                while (!referenced[partnerFrom] || partnerFrom == c.from) partnerFrom = wedgeNext[partnerFrom];
+                partnerTo = c.to;
+                bool found = false;
+                unsigned w = c.to;
+                do {
+                    if (referenced[w] && isSeamEdge(partnerFrom, w)) { partnerTo = w; found = true; break; }
+                    w = wedgeNext[w];
+                } while (w != c.to);
+                if (!found) continue;
+            }
+
+            // условие связности: общие соседи from и to — только вершины
+            // треугольников на самом ребре, иначе стягивание склеит
+            // поверхность в неманифолд (две грани на одном ребре)
+            {
+                unsigned shared = 0, onEdge = 0;
+                for (unsigned a = adjacencyOffset[pFrom]; a < adjacencyOffset[pFrom + 1]; ++a) {
+                    size_t t = adjacency[a] * 3;
+                    for (int k = 0; k < 3; ++k) {
+                        unsigned p = positionOf[result[t + k]];
+                        if (p == pFrom || p == pTo || mark[p] == pass + 1) continue;
+                        mark[p] = pass + 1;
+                    }
+                }
+                for (unsigned a = adjacencyOffset[pTo]; a < adjacencyOffset[pTo + 1]; ++a) {
+                    size_t t = adjacency[a] * 3;
+                    bool hasFrom = false;
+                    for (int k = 0; k < 3; ++k) hasFrom = hasFrom || positionOf[result[t + k]] == pFrom;
+                    if (hasFrom) ++onEdge;
+                    for (int k = 0; k < 3; ++k) {
+                        unsigned p = positionOf[result[t + k]];
+                        if (mark[p] == pass + 1) { mark[p] = 0; ++shared; }
+                    }
+                }
+                // пометки остальных соседей from снимаем
+                for (unsigned a = adjacencyOffset[pFrom]; a < adjacencyOffset[pFrom + 1]; ++a) {
+                    size_t t = adjacency[a] * 3;
+                    for (int k = 0; k < 3; ++k) mark[positionOf[result[t + k]]] = 0;
+                }
+                if (shared != onEdge) continue;
+            }
+
+            // треугольники вокруг from не должны перевернуться
+            const glm::vec3& target = vertices[c.to].position;
+            bool flips = false;
+            for (unsigned a = adjacencyOffset[pFrom]; a < adjacencyOffset[pFrom + 1] && !flips; ++a) {
+                size_t t = adjacency[a] * 3;
+                unsigned p0 = positionOf[result[t]], p1 = positionOf[result[t + 1]], p2 = positionOf[result[t + 2]];
+                if (p0 == pTo || p1 == pTo || p2 == pTo) continue;   // исчезнет
+                glm::vec3 q0 = vertices[result[t]].position, q1 = vertices[result[t + 1]].position,
+                          q2 = vertices[result[t + 2]].position;
+                glm::vec3 before = glm::cross(q1 - q0, q2 - q0);
+                if (p0 == pFrom) q0 = target;
+                if (p1 == pFrom) q1 = target;
+                if (p2 == pFrom) q2 = target;
+                glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+                flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+            }
+            if (flips) continue;
+
+            remap[c.from] = c.to;
+            remap[partnerFrom] = partnerTo;
+            quadrics[pTo].add(quadrics[pFrom]);
+            resultError = std::max(resultError, c.error);
+
+            // окрестность from до конца прохода не трогаем
+            for (unsigned a = adjacencyOffset[pFrom]; a < adjacencyOffset[pFrom + 1]; ++a) {
+                size_t t = adjacency[a] * 3;
+                for (int k = 0; k < 3; ++k) locked[positionOf[result[t + k]]] = true;
+            }
+            removed += kind[c.from] == SIMPLIFY_BORDER ? 1 : 2;
+            ++applied;
+        }
+        if (applied == 0) break;
+
+        // переписать индексы и выбросить вырожденные треугольники
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+        triangleCount = write / 3;
+    }
+
+    if (outError) *outError = resultError;
+    return result;
+}
+
+// Построить цепочку LOD: каждый следующий уровень — около ratio от
+// предыдущего по треугольникам. Уровни дописываются в mesh.indices
+// после исходных, вершины общие. Вызывать до uploadToGPU.
+void generateLODs(Mesh& mesh, int maxLevels = 4, float ratio = 0.5f, float maxRelativeError = 0.05f) {
+    mesh.lods.clear();
+    if (mesh.indices.empty()) return;
+    mesh.lods.push_back({ 0, mesh.indices.size(), 0.0f });
+
+    const float maxError = maxRelativeError * std::max(mesh.boundsRadius, 1e-6f);
+    std::vector<unsigned int> previous(mesh.indices);
+    float previousError = 0.0f;
+
+    for (int level = 1; level < maxLevels; ++level) {
+        size_t target = static_cast<size_t>(previous.size() / 3 * ratio) * 3;
+        if (target < 3) break;
+
+        // ошибки уровней складываются, поэтому каждому — остаток бюджета
+        float error = 0.0f;
+        std::vector<unsigned int> lod = simplifyMesh(mesh.vertices, previous, target,
+                                                     maxError - previousError, &error);
+        // уровень, почти не отличающийся от предыдущего, не нужен
+        if (lod.empty() || lod.size() > previous.size() * 9 / 10) break;
+
+        previousError += error;
+        mesh.lods.push_back({ mesh.indices.size(), lod.size(), previousError });
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        previous.swap(lod);
+    }
+
+    std::cout << "LOD:";
+    for (const MeshLOD& level : mesh.lods)
+        std::cout << ' ' << level.indexCount / 3 << " (" << level.error << ')';
+    std::cout << " треугольников (ошибка)" << std::endl;
+}
+
+// Выбрать LOD по экранной ошибке: самый грубый уровень, отклонение
+// которого от исходной поверхности меньше maxPixelError пикселей.
+// pixelsPerUnit — сколько пикселей экрана занимает единица модели
+// на расстоянии объекта (с учётом масштаба объекта).
+size_t selectLOD(const Mesh& mesh, float pixelsPerUnit, float maxPixelError = 1.0f) {
+    size_t lod = 0;
+    for (size_t i = 1; i < mesh.lods.size(); ++i)
+        if (mesh.lods[i].error * pixelsPerUnit <= maxPixelError) lod = i;
+    return lod;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <cstdint>
+
+/* ------------------------------------------------------------------ */
+// Положение объекта с кэшем матриц: матрица модели и матрица нормалей
+// пересчитываются только после изменения позиции, поворота, масштаба или
+// родителя, а не каждый кадр. Матрица нормалей (обратная транспонированная
+// к верхней 3x3) уходит в шейдер готовой — вместо transpose(inverse(model))
+// на каждую вершину.
+//
+// Углы поворота — в градусах; порядок осей задаётся при создании:
+//   модель = T * R(первая ось) * R(вторая) * R(третья) * S
+//
+// Владелец пространственного индекса может подписаться на изменения
+// (trackChanges): сеттеры сами кладут номер объекта в его список, и кадр
+// обходит только сдвинутые объекты, а не сверяет version() у всех.
+
+enum class RotationOrder { XYZ, YXZ };
+
+class Transform {
+public:
+    Transform() = default;
+    Transform(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale,
+              RotationOrder order = RotationOrder::XYZ)
+        : positionValue(position), rotationValue(rotation), scaleValue(scale), order(order) {}
+
+    const glm::vec3& position() const { return positionValue; }
+    const glm::vec3& rotation() const { return rotationValue; }
+    const glm::vec3& scale() const { return scaleValue; }
+
+    void setPosition(const glm::vec3& p) { positionValue = p; markChanged(); }
+    void setRotation(const glm::vec3& r) { rotationValue = r; markChanged(); }
+    void setScale(const glm::vec3& s) { scaleValue = s; markChanged(); }
+    void setRotationOrder(RotationOrder o) { order = o; markChanged(); }
+
+    // Первый сеттер после подписки или acknowledgeChange добавляет id в
+    // changes (один раз, сколько бы сеттеров ни было). Смена матрицы
+    // родителя не сообщается — у потомков своя отметка.
+    void trackChanges(std::vector<std::uint32_t>* changes, std::uint32_t id) {
+        changeList = changes;
+        changeId = id;
+        changeQueued = false;
+    }
+    // Владелец списка обработал изменение — следующий сеттер отметит снова
+    void acknowledgeChange() { changeQueued = false; }
+
+    // Родитель должен жить дольше потомка; nullptr — корень
+    void setParent(Transform* p) { parent = p; worldDirty = true; }
+
+    // Матрица относительно родителя
+    const glm::mat4& local() { update(); return localMatrix; }
+    // Матрица модели в мире
+    const glm::mat4& world() { update(); return worldMatrix; }
+    // Матрица нормалей для world()
+    const glm::mat3& normalMatrix() { update(); return normal; }
+
+    // Меняется при каждом пересчёте world() — по нему потомки и кэши
+    // снаружи узнают, что матрица устарела
+    unsigned long version() { update(); return worldVersion; }
+
+private:
+    void markChanged() {
+        localDirty = true;
+        if (changeList && !changeQueued) {
+            changeList->push_back(changeId);
+            changeQueued = true;
+        }
+    }
+
+    void update() {
+        if (localDirty) {
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), positionValue);
+            const glm::vec3 x(1.0f, 0.0f, 0.0f), y(0.0f, 1.0f, 0.0f), z(0.0f, 0.0f, 1.0f);
+            if (order == RotationOrder::XYZ) {
+                if (rotationValue.x != 0.0f) m = glm::rotate(m, glm::radians(rotationValue.x), x);
+                if (rotationValue.y != 0.0f) m = glm::rotate(m, glm::radians(rotationValue.y), y);
+            }
+            else {
+                if (rotationValue.y != 0.0f) m = glm::rotate(m, glm::radians(rotationValue.y), y);
+                if (rotationValue.x != 0.0f) m = glm::rotate(m, glm::radians(rotationValue.x), x);
+            }
+            if (rotationValue.z != 0.0f) m = glm::rotate(m, glm::radians(rotationValue.z), z);
+            localMatrix = glm::scale(m, scaleValue);
+            localDirty = false;
+            worldDirty = true;
+        }
+        if (parent && parent->version() != parentVersion) worldDirty = true;
+        if (!worldDirty) return;
+
+        worldMatrix = parent ? parent->worldMatrix * localMatrix : localMatrix;
+        normal = glm::transpose(glm::inverse(glm::mat3(worldMatrix)));
+        parentVersion = parent ? parent->worldVersion : 0;
+        ++worldVersion;
+        worldDirty = false;
+    }
+
+    glm::vec3 positionValue{ 0.0f };
+    glm::vec3 rotationValue{ 0.0f };
+    glm::vec3 scaleValue{ 1.0f };
+    RotationOrder order = RotationOrder::XYZ;
+    Transform* parent = nullptr;
+
+    glm::mat4 localMatrix{ 1.0f };
+    glm::mat4 worldMatrix{ 1.0f };
+    glm::mat3 normal{ 1.0f };
+    bool localDirty = true;
+    bool worldDirty = true;
+    unsigned long worldVersion = 0;
+    unsigned long parentVersion = 0;
+
+    std::vector<std::uint32_t>* changeList = nullptr;
+    std::uint32_t changeId = 0;
+    bool changeQueued = false;
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+/* ------------------------------------------------------------------ */
+// Имя uniform'а как 32-битный хеш FNV-1a. Конструктор constexpr, поэтому
+// ключи, объявленные constexpr, считаются при компиляции:
+//   constexpr UniformKey UNIFORM_MODEL("model");
+// Строковый литерал тоже подходит (uniforms["model"]), но тогда хеш
+// считается при вызове — это для кода вне кадра.
+constexpr std::uint32_t uniformHash(const char* name, std::uint32_t h = 2166136261u) {
+    return *name ? uniformHash(name + 1, (h ^ static_cast<unsigned char>(*name)) * 16777619u) : h;
+}
+
+struct UniformKey {
+    std::uint32_t hash;
+    constexpr UniformKey(const char* name) : hash(uniformHash(name)) {}
+};
+
+/* ------------------------------------------------------------------ */
+// Таблица расположений uniform'ов программы: после линковки reflect один
+// раз обходит GL_ACTIVE_UNIFORMS, дальше поиск — хеш и пара сравнений в
+// открытой адресации, без glGetUniformLocation и без строк.
+// Массивы регистрируются целиком ("a") и поэлементно ("a[0]", "a[1]"...).
+// Uniform'ы из блоков (UBO) расположения не имеют и в таблицу не попадают.
+class UniformTable {
+public:
+    UniformTable() = default;
+    explicit UniformTable(GLuint program) { reflect(program); }
+
+    void reflect(GLuint program) {
+        this->program = program;
+        slots.clear();
+        count = 0;
+        if (program == 0) return;
+
+        GLint active = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        // имена с индексами массивов, с запасом на "[N]"
+        std::vector<std::string> names;
+        std::vector<GLint> locations;
+        std::vector<char> buffer(static_cast<std::size_t>(maxLength) + 1);
+        for (GLint i = 0; i < active; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()),
+                               &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), static_cast<std::size_t>(length));
+            GLint location = glGetUniformLocation(program, name.c_str());
+            if (location < 0) continue;
+
+            names.push_back(name);
+            locations.push_back(location);
+
+            // "a[0]" -> "a" и остальные элементы массива
+            const std::size_t bracket = name.size() >= 3 ? name.rfind("[0]") : std::string::npos;
+            if (bracket == std::string::npos || bracket + 3 != name.size()) continue;
+            const std::string base = name.substr(0, bracket);
+            names.push_back(base);
+            locations.push_back(location);
+            for (GLint element = 1; element < size; ++element) {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                names.push_back(elementName);
+                locations.push_back(glGetUniformLocation(program, elementName.c_str()));
+            }
+        }
+
+        std::size_t capacity = 16;
+        while (capacity < names.size() * 2) capacity *= 2;
+        slots.assign(capacity, Slot());
+        for (std::size_t i = 0; i < names.size(); ++i) insert(names[i], locations[i]);
+    }
+
+    // Расположение или -1, если такого uniform'а нет (glUniform* с -1
+    // ничего не делает — как и с результатом glGetUniformLocation)
+    GLint operator[](UniformKey key) const {
+        if (slots.empty()) return -1;
+        const std::size_t mask = slots.size() - 1;
+        for (std::size_t i = key.hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (!slot.used) return -1;
+            if (slot.hash == key.hash) return slot.location;
+        }
+    }
+
+    GLuint id() const { return program; }
+    std::size_t size() const { return count; }
+
+private:
+    struct Slot {
+        std::uint32_t hash = 0;
+        GLint location = -1;
+        bool used = false;
+    };
+
+    void insert(const std::string& name, GLint location) {
+        const std::uint32_t hash = uniformHash(name.c_str());
+        const std::size_t mask = slots.size() - 1;
+        for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (!slot.used) {
+                slot.hash = hash;
+                slot.location = location;
+                slot.used = true;
+                ++count;
+                return;
+            }
+            if (slot.hash == hash) {
+                // строки не хранятся, поэтому совпадение хешей разных имён
+                // надо увидеть сразу, а не искать потом неверный uniform
+                if (slot.location != location)
+                    std::cerr << "Uniform hash collision: " << name << '\n';
+                return;
+            }
+        }
+    }
+
+    GLuint program = 0;
+    std::vector<Slot> slots;
+    std::size_t count = 0;
+};
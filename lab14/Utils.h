@@ -5,8 +5,13 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <tuple>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <GL/glew.h>
+#include "VertexQuantization.h"
+#include "UniformTable.h"
 
 struct Vertex {
     glm::vec3 position;
@@ -14,50 +19,138 @@ struct Vertex {
     glm::vec2 texCoord;
 };
 
+// Уровень детализации: диапазон в общем буфере индексов меша
+struct MeshLOD {
+    size_t indexOffset;
+    size_t indexCount;
+    float error;        // отклонение от исходной поверхности, в единицах модели
+};
+
+// Uniform'ы распаковки вершин (см. Mesh::setDequantizeUniforms)
+constexpr UniformKey UNIFORM_QUANT_OFFSET("quantOffset");
+constexpr UniformKey UNIFORM_QUANT_SCALE("quantScale");
+constexpr UniformKey UNIFORM_OCT_NORMALS("octNormals");
+
 struct Mesh {
     std::vector<Vertex> vertices;
-    GLuint VAO = 0, VBO = 0;
+    std::vector<unsigned int> indices;  // все LOD подряд, LOD 0 — первым
+    std::vector<MeshLOD> lods;          // пусто — рисуются все indices
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    
+    // Упаковать вершины при uploadToGPU (VertexQuantization.h): 16 байт
+    // вместо 32. Шейдер распаковывает их по setDequantizeUniforms.
+    bool quantize = false;
+    VertexQuantization quantization;
     
     void uploadToGPU() {
-        if (vertices.empty()) return;
+        if (vertices.empty() || indices.empty()) return;
         
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
         
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        if (quantize) {
+            std::vector<PackedVertex> packed;
+            quantization = quantizeVertices(vertices.data(), vertices.size(), packed);
+            glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+        } else {
+            quantization = VertexQuantization();
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        }
         
-        // Позиция
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
         
-        // Нормаль
+        glEnableVertexAttribArray(0);
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        
-        // Текстурные координаты
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        if (quantize) {
+            // Позиция: uint16 -> [0, 1], в шейдере quantOffset + p * quantScale
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+            // Нормаль: октаэдрическая, 2 x snorm16
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+            // Текстурные координаты: half float
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+        } else {
+            // Позиция
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // Нормаль
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+            // Текстурные координаты
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        }
         
         glBindVertexArray(0);
     }
     
-    void draw() {
+    // Параметры распаковки для активной программы; у неупакованного
+    // меша они тождественные
+    void setDequantizeUniforms(const UniformTable& uniforms) const {
+        glUniform3fv(uniforms[UNIFORM_QUANT_OFFSET], 1, &quantization.offset[0]);
+        glUniform3fv(uniforms[UNIFORM_QUANT_SCALE], 1, &quantization.scale[0]);
+        glUniform1i(uniforms[UNIFORM_OCT_NORMALS], quantization.packed ? 1 : 0);
+    }
+    
+    void draw(size_t lod = 0) {
         if (VAO == 0) return;
+        size_t offset = 0, count = indices.size();
+        if (!lods.empty()) {
+            const MeshLOD& level = lods[std::min(lod, lods.size() - 1)];
+            offset = level.indexOffset;
+            count = level.indexCount;
+        }
         glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count), GL_UNSIGNED_INT,
+                       (void*)(offset * sizeof(unsigned int)));
         glBindVertexArray(0);
     }
     
     void cleanup() {
+        if (EBO) glDeleteBuffers(1, &EBO);
         if (VBO) glDeleteBuffers(1, &VBO);
         if (VAO) glDeleteVertexArrays(1, &VAO);
+        EBO = 0;
         VBO = 0;
         VAO = 0;
     }
 };
 
+// Отчёт об упаковке вершин: объём и наибольшая ошибка
+void printQuantizationReport(const std::string& name, const VertexQuantization& q) {
+    if (!q.packed) return;
+    const float extent = std::max(q.scale.x, std::max(q.scale.y, q.scale.z));
+    std::cout << name << ": вершин " << q.vertexCount << ", "
+              << q.vertexCount * sizeof(Vertex) / 1024 << " КБ -> "
+              << q.vertexCount * sizeof(PackedVertex) / 1024 << " КБ"
+              << "; ошибка: позиция " << q.maxPositionError
+              << " (" << (extent > 0.0f ? 100.0f * q.maxPositionError / extent : 0.0f) << "% габарита)"
+              << ", нормаль " << q.maxNormalError << "°"
+              << ", UV " << q.maxTexCoordError << std::endl;
+}
+
+// Хеш для тройки индексов (позиция, текстура, нормаль)
+struct IndexTripleHash {
+    std::size_t operator()(const std::tuple<int, int, int>& t) const noexcept {
+        std::size_t h = static_cast<std::size_t>(static_cast<unsigned int>(std::get<0>(t)));
+        h = h * 0x9E3779B97F4A7C15ull + static_cast<unsigned int>(std::get<1>(t));
+        h = h * 0x9E3779B97F4A7C15ull + static_cast<unsigned int>(std::get<2>(t));
+        return h ^ (h >> 29);
+    }
+};
+
+// Индекс из OBJ в 0-базу: отрицательные считаются от конца, пустой -> -1
+int parseOBJIndex(const std::string& token, size_t count) {
+    if (token.empty()) return -1;
+    int idx = std::stoi(token);
+    if (idx > 0) return idx - 1;
+    if (idx < 0) return idx + static_cast<int>(count);
+    return -1;
+}
+
 bool loadOBJ(const std::string& path, Mesh& mesh) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -69,9 +162,14 @@ bool loadOBJ(const std::string& path, Mesh& mesh) {
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> texcoords;
     
+    // Одинаковые тройки (позиция, текстура, нормаль) дают одну вершину
+    std::unordered_map<std::tuple<int, int, int>, unsigned int, IndexTripleHash> vertexCache;
+    
     mesh.vertices.clear();
+    mesh.indices.clear();
     
     std::string line;
+    std::vector<std::tuple<int, int, int>> face;
     while (std::getline(file, line)) {
         std::istringstream iss(line);
         std::string type;
@@ -94,50 +192,43 @@ bool loadOBJ(const std::string& path, Mesh& mesh) {
             texcoords.push_back(texcoord);
         }
         else if (type == "f") {
-            std::string faceData[4];
-            int vertexCount = 0;
+            face.clear();
             
-            while (iss >> faceData[vertexCount] && vertexCount < 4) {
-                vertexCount++;
+            std::string vertexStr;
+            while (iss >> vertexStr) {
+                std::istringstream viss(vertexStr);
+                std::string index;
+                int vi = -1, ti = -1, ni = -1;
+                
+                // Позиция / текстурные координаты / нормаль
+                if (std::getline(viss, index, '/')) vi = parseOBJIndex(index, positions.size());
+                if (std::getline(viss, index, '/')) ti = parseOBJIndex(index, texcoords.size());
+                if (std::getline(viss, index, '/')) ni = parseOBJIndex(index, normals.size());
+                
+                face.emplace_back(vi, ti, ni);
             }
             
-            // Обработка треугольников и четырехугольников
-            for (int i = 1; i < vertexCount - 1; i++) {
-                for (int j = 0; j < 3; j++) {
-                    std::string vertexStr;
-                    if (j == 0) vertexStr = faceData[0];
-                    else if (j == 1) vertexStr = faceData[i];
-                    else vertexStr = faceData[i + 1];
-                    
-                    Vertex vertex;
-                    std::istringstream viss(vertexStr);
-                    std::string index;
-                    
-                    // Позиция
-                    if (std::getline(viss, index, '/') && !index.empty()) {
-                        int idx = std::stoi(index) - 1;
-                        if (idx >= 0 && idx < positions.size()) {
-                            vertex.position = positions[idx];
-                        }
-                    }
-                    
-                    // Текстурные координаты
-                    if (std::getline(viss, index, '/') && !index.empty()) {
-                        int idx = std::stoi(index) - 1;
-                        if (idx >= 0 && idx < texcoords.size()) {
-                            vertex.texCoord = texcoords[idx];
-                        }
+            // Треугольники веером (0, i, i+1) — подходит для любых выпуклых граней
+            for (size_t i = 1; i + 1 < face.size(); i++) {
+                const std::tuple<int, int, int> corners[3] = { face[0], face[i], face[i + 1] };
+                
+                for (const auto& key : corners) {
+                    auto it = vertexCache.find(key);
+                    if (it != vertexCache.end()) {
+                        mesh.indices.push_back(it->second);
+                        continue;
                     }
                     
-                    // Нормаль
-                    if (std::getline(viss, index, '/') && !index.empty()) {
-                        int idx = std::stoi(index) - 1;
-                        if (idx >= 0 && idx < normals.size()) {
-                            vertex.normal = normals[idx];
-                        }
-                    }
+                    Vertex vertex{};
+                    int vi = std::get<0>(key), ti = std::get<1>(key), ni = std::get<2>(key);
+                    if (vi >= 0 && vi < static_cast<int>(positions.size())) vertex.position = positions[vi];
+                    if (ti >= 0 && ti < static_cast<int>(texcoords.size())) vertex.texCoord = texcoords[ti];
+                    if (ni >= 0 && ni < static_cast<int>(normals.size())) vertex.normal = normals[ni];
                     
+                    unsigned int newIndex = static_cast<unsigned int>(mesh.vertices.size());
                     mesh.vertices.push_back(vertex);
+                    mesh.indices.push_back(newIndex);
+                    vertexCache.emplace(key, newIndex);
                 }
             }
         }
@@ -150,6 +241,22 @@ bool loadOBJ(const std::string& path, Mesh& mesh) {
         return false;
     }
     
-    std::cout << "Загружено вершин: " << mesh.vertices.size() << " из " << path << std::endl;
+    // Ограничивающая сфера: центр коробки и самая дальняя вершина
+    glm::vec3 lo = mesh.vertices[0].position, hi = lo;
+    for (const Vertex& v : mesh.vertices) {
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+    }
+    mesh.boundsCenter = (lo + hi) * 0.5f;
+    mesh.boundsRadius = 0.0f;
+    for (const Vertex& v : mesh.vertices)
+        mesh.boundsRadius = std::max(mesh.boundsRadius, glm::length(v.position - mesh.boundsCenter));
+    
+    // Без индексации каждый угол треугольника был бы отдельной вершиной
+    size_t unindexedBytes = mesh.indices.size() * sizeof(Vertex);
+    size_t indexedBytes = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+    std::cout << "Загружено вершин: " << mesh.vertices.size() << " (было бы " << mesh.indices.size()
+              << " без индексов), память GPU: " << indexedBytes / 1024.0 << " КБ вместо "
+              << unindexedBytes / 1024.0 << " КБ, из " << path << std::endl;
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+/* ------------------------------------------------------------------ */
+// Упакованная вершина: 16 байт вместо 32 у Vertex.
+//   position — 3 x uint16, нормировано к AABB меша: p = offset + q * scale
+//   normal   — октаэдрическая развёртка, 2 x int16 snorm
+//   texCoord — 2 x half float
+// В шейдере позиция и нормаль восстанавливаются по uniform'ам quantOffset,
+// quantScale и octNormals (см. Mesh::setDequantizeUniforms).
+struct PackedVertex {
+    std::uint16_t position[4];   // w не используется — выравнивание до 8 байт
+    std::int16_t normal[2];
+    std::uint16_t texCoord[2];
+};
+
+// Параметры упаковки меша и её ошибка по всем вершинам
+struct VertexQuantization {
+    bool packed = false;               // буфер на GPU в формате PackedVertex
+    glm::vec3 offset{ 0.0f };          // минимум AABB
+    glm::vec3 scale{ 1.0f };           // размер AABB
+    std::size_t vertexCount = 0;
+
+    float maxPositionError = 0.0f;     // в единицах модели
+    float maxNormalError = 0.0f;       // в градусах
+    float maxTexCoordError = 0.0f;
+};
+
+/* ------------------------------------------------------------------ */
+// float <-> half (IEEE 754 binary16), округление к ближайшему чётному
+std::uint16_t floatToHalf(float value) {
+    std::uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const std::uint32_t sign = (x >> 16) & 0x8000u;
+    const std::uint32_t a = x & 0x7FFFFFFFu;
+
+    if (a >= 0x7F800000u) return static_cast<std::uint16_t>(sign | 0x7C00u | (a > 0x7F800000u ? 0x200u : 0u));
+    if (a >= 0x477FF000u) return static_cast<std::uint16_t>(sign | 0x7C00u);   // больше 65504 — бесконечность
+    if (a < 0x38800000u) {
+        // денормализованные half: m * 2^-24
+        if (a < 0x33000000u) return static_cast<std::uint16_t>(sign);
+        const std::uint32_t mantissa = (a & 0x7FFFFFu) | 0x800000u;
+        const int shift = 126 - static_cast<int>(a >> 23);
+        std::uint32_t m = mantissa >> shift;
+        const std::uint32_t rest = mantissa & ((1u << shift) - 1u), halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (m & 1u))) ++m;
+        return static_cast<std::uint16_t>(sign | m);
+    }
+    std::uint32_t h = (a - 0x38000000u) >> 13;   // смена смещения порядка 127 -> 15
+    const std::uint32_t rest = a & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (h & 1u))) ++h;   // перенос в порядок корректен
+    return static_cast<std::uint16_t>(sign | h);
+}
+
+float halfToFloat(std::uint16_t h) {
+    const std::uint32_t sign = (h & 0x8000u) << 16;
+    const std::uint32_t exponent = (h >> 10) & 0x1Fu, mantissa = h & 0x3FFu;
+    if (exponent == 0) {
+        float f = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -f : f;
+    }
+    std::uint32_t x = exponent == 31 ? sign | 0x7F800000u | (mantissa << 13)
+                                     : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+/* ------------------------------------------------------------------ */
+// Октаэдрическая развёртка единичного вектора в квадрат [-1, 1]^2:
+// нижняя полусфера отражается в углы квадрата
+glm::vec2 octEncode(const glm::vec3& n) {
+    const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 <= 0.0f) return glm::vec2(0.0f);
+    glm::vec2 p(n.x / l1, n.y / l1);
+    if (n.z < 0.0f) {
+        glm::vec2 folded((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+        p = folded;
+    }
+    return p;
+}
+
+// То же, что octDecode в шейдере
+glm::vec3 octDecode(const glm::vec2& e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+std::int16_t packSnorm16(float v) {
+    return static_cast<std::int16_t>(std::lround(std::min(std::max(v, -1.0f), 1.0f) * 32767.0f));
+}
+
+float unpackSnorm16(std::int16_t q) {
+    return std::max(q / 32767.0f, -1.0f);
+}
+
+/* ------------------------------------------------------------------ */
+// Упаковать вершины в out и посчитать ошибку: вершины распаковываются
+// так же, как это делает шейдер, и сравниваются с исходными.
+// V — любая вершина с полями position, normal, texCoord (Vertex).
+template <class V>
+VertexQuantization quantizeVertices(const V* vertices, std::size_t count, std::vector<PackedVertex>& out) {
+    VertexQuantization q;
+    q.packed = true;
+    q.vertexCount = count;
+    out.resize(count);
+    if (count == 0) return q;
+
+    glm::vec3 lo = vertices[0].position, hi = lo;
+    for (std::size_t i = 1; i < count; ++i) {
+        lo = glm::min(lo, vertices[i].position);
+        hi = glm::max(hi, vertices[i].position);
+    }
+    q.offset = lo;
+    q.scale = hi - lo;
+
+    const float maxValue = 65535.0f;
+    glm::vec3 inverse(0.0f);
+    for (int c = 0; c < 3; ++c)
+        if (q.scale[c] > 0.0f) inverse[c] = maxValue / q.scale[c];
+
+    // угол через atan2(|a x b|, a . b) в double: acos около 1 во float
+    // даёт погрешность ~0.02°, больше самой ошибки упаковки
+    double maxAngle = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const V& v = vertices[i];
+        PackedVertex& p = out[i];
+
+        for (int c = 0; c < 3; ++c) {
+            float u = std::min(std::max((v.position[c] - lo[c]) * inverse[c], 0.0f), maxValue);
+            p.position[c] = static_cast<std::uint16_t>(std::lround(u));
+            float restored = q.offset[c] + p.position[c] / maxValue * q.scale[c];
+            q.maxPositionError = std::max(q.maxPositionError, std::fabs(restored - v.position[c]));
+        }
+        p.position[3] = 0;
+
+        const glm::vec2 e = octEncode(v.normal);
+        p.normal[0] = packSnorm16(e.x);
+        p.normal[1] = packSnorm16(e.y);
+        const float length = glm::length(v.normal);
+        if (length > 0.0f) {
+            glm::vec3 restored = octDecode(glm::vec2(unpackSnorm16(p.normal[0]), unpackSnorm16(p.normal[1])));
+            const double ax = restored.x, ay = restored.y, az = restored.z;
+            const double bx = v.normal.x, by = v.normal.y, bz = v.normal.z;
+            const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+            maxAngle = std::max(maxAngle, std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz));
+        }
+
+        for (int c = 0; c < 2; ++c) {
+            p.texCoord[c] = floatToHalf(v.texCoord[c]);
+            q.maxTexCoordError = std::max(q.maxTexCoordError, std::fabs(halfToFloat(p.texCoord[c]) - v.texCoord[c]));
+        }
+    }
+    q.maxNormalError = static_cast<float>(maxAngle * 57.29577951308232);
+    return q;
+}
@@ -1,4 +1,10 @@
 ﻿#include "Utils.h"
+#include "MeshSimplifier.h"
+#include "GLCallCounter.h"
+#include "UniformTable.h"
+#include "FrameRingBuffer.h"
+#include "Transform.h"
+#include "LightClusters.h"
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -14,13 +20,11 @@
 struct SceneObject {
     Mesh mesh;
     GLuint textureID;
-    glm::vec3 position;
-    glm::vec3 scale;
-    glm::vec3 rotation;
+    Transform transform; // матрицы модели и нормалей пересчитываются только после изменений
     std::string name;
     int lightingModel; // 0=Phong, 1=Toon, 2=Oren-Nayar
     
-    SceneObject() : textureID(0), lightingModel(0) {}
+    SceneObject() : textureID(0), lightingModel(0) { transform.setRotationOrder(RotationOrder::YXZ); }
 };
 
 // Типы источников света
@@ -46,13 +50,14 @@ struct Light {
     float intensity;
     float cutOff;
     float outerCutOff;
+    float range;       // радиус влияния точечного и прожектора: у границы свет гаснет до нуля
     bool enabled;
     std::string name;
     
     Light() : type(LIGHT_POINT), position(0.0f, 5.0f, 0.0f), 
               direction(0.0f, -1.0f, 0.0f), color(1.0f), 
               intensity(1.0f), cutOff(12.5f), outerCutOff(15.0f), 
-              enabled(true), name("Light") {}
+              range(20.0f), enabled(true), name("Light") {}
 };
 
 // Шейдеры с поддержкой трех моделей освещения
@@ -67,13 +72,30 @@ out vec3 Normal;
 out vec2 TexCoord;
 
 uniform mat4 model;
+uniform mat3 normalMatrix; // обратная транспонированная к model, считается на CPU
 uniform mat4 view;
 uniform mat4 projection;
 
+// Распаковка PackedVertex (VertexQuantization.h); по умолчанию — float-вершины
+uniform vec3 quantOffset = vec3(0.0);
+uniform vec3 quantScale = vec3(1.0);
+uniform bool octNormals = false;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 position = quantOffset + aPos * quantScale;
+    vec3 normal = octNormals ? octDecode(aNormal.xy) : aNormal;
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = normalMatrix * normal;
     TexCoord = aTexCoord;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
@@ -88,54 +110,41 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
 
-// Структуры для источников света
-struct PointLight {
-    vec3 position;
-    vec3 color;
-    float intensity;
-    bool enabled;
-    
-    // Параметры затухания
-    float constant;
-    float linear;
-    float quadratic;
-};
-
+// Направленные источники — в uniform-блоке. Порядок полей — под std140:
+// float после vec3 занимает его четвёртую компоненту (см. *Std140 в C++)
 struct DirectionalLight {
     vec3 direction;
-    vec3 color;
     float intensity;
-    bool enabled;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
     vec3 color;
-    float intensity;
     bool enabled;
-    
-    // Параметры конуса
-    float cutOff;
-    float outerCutOff;
-    
-    // Параметры затухания
-    float constant;
-    float linear;
-    float quadratic;
 };
 
 uniform sampler2D texture1;
 uniform vec3 viewPos;
+uniform mat4 view;
 
-// Максимальное количество источников каждого типа
-#define MAX_POINT_LIGHTS 1
+// Максимальное количество направленных источников
 #define MAX_DIR_LIGHTS 1
-#define MAX_SPOT_LIGHTS 1
 
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform DirectionalLight dirLights[MAX_DIR_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+layout(std140) uniform Lights {
+    DirectionalLight dirLights[MAX_DIR_LIGHTS];
+};
+
+// Точечные и прожекторы — по кластерам (LightClusters.h в C++).
+// Источник — 3 текселя clusterLights: (позиция, радиус), (цвет * яркость,
+// outerCutOff), (направление, cutOff); у точечного cutOff = -2,
+// outerCutOff = -3, конус его не ограничивает. Кластер фрагмента даёт
+// (смещение, число) в clusterGrid, номера источников — в clusterIndices
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+uniform vec2 clusterTileSize;     // пикселей в плитке
+uniform float clusterNear;
+uniform float clusterSliceScale;  // срез = log(глубина / near) * scale
 
 // Параметры моделей освещения
 uniform int lightingModel; // 0=Phong, 1=Toon, 2=Oren-Nayar
@@ -211,28 +220,15 @@ vec3 orenNayarLighting(vec3 lightDir, vec3 normal, vec3 viewDir, vec3 lightColor
     return lightColor * L1 * diffuseColor * intensity;
 }
 
-// Общие функции расчета для каждого типа света
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor)
+// Освещение одним источником по модели объекта
+vec3 lightByModel(vec3 lightDir, vec3 normal, vec3 viewDir, vec3 lightColor, float intensity, vec3 diffuseColor)
 {
-    if (!light.enabled) return vec3(0.0);
-    
-    vec3 lightDir = normalize(light.position - fragPos);
-    vec3 result = vec3(0.0);
-    
-    if (lightingModel == 0) { // Phong
-        result = phongLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
-    } else if (lightingModel == 1) { // Toon
-        result = toonLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
+    if (lightingModel == 1) { // Toon
+        return toonLighting(lightDir, normal, viewDir, lightColor, intensity, diffuseColor);
     } else if (lightingModel == 2) { // Oren-Nayar
-        result = orenNayarLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
+        return orenNayarLighting(lightDir, normal, viewDir, lightColor, intensity, diffuseColor);
     }
-    
-    // Затухание
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + 
-                              light.quadratic * (distance * distance));
-    
-    return result * attenuation;
+    return phongLighting(lightDir, normal, viewDir, lightColor, intensity, diffuseColor); // Phong
 }
 
 vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor)
@@ -240,50 +236,33 @@ vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec
     if (!light.enabled) return vec3(0.0);
     
     vec3 lightDir = normalize(-light.direction);
-    vec3 result = vec3(0.0);
-    
-    if (lightingModel == 0) { // Phong
-        result = phongLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
-    } else if (lightingModel == 1) { // Toon
-        result = toonLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
-    } else if (lightingModel == 2) { // Oren-Nayar
-        result = orenNayarLighting(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
-    }
-    
-    return result;
+    return lightByModel(lightDir, normal, viewDir, light.color, light.intensity, diffuseColor);
 }
 
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor)
+// Точечный или прожектор из списка кластера
+vec3 calcClusterLight(int light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor)
 {
-    if (!light.enabled) return vec3(0.0);
+    vec4 positionRange = texelFetch(clusterLights, light * 3);
+    vec4 colorOuterCutOff = texelFetch(clusterLights, light * 3 + 1);
+    vec4 directionCutOff = texelFetch(clusterLights, light * 3 + 2);
     
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 toLight = positionRange.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance >= positionRange.w) return vec3(0.0);
+    vec3 lightDir = toLight / distance;
     
     // Проверка нахождения внутри конуса
-    float theta = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    float theta = dot(lightDir, -directionCutOff.xyz);
+    if (theta <= colorOuterCutOff.w) return vec3(0.0);
+    float cone = clamp((theta - colorOuterCutOff.w) / (directionCutOff.w - colorOuterCutOff.w), 0.0, 1.0);
     
-    if (theta > light.outerCutOff) {
-        vec3 result = vec3(0.0);
-        
-        if (lightingModel == 0) { // Phong
-            result = phongLighting(lightDir, normal, viewDir, light.color, light.intensity * intensity, diffuseColor);
-        } else if (lightingModel == 1) { // Toon
-            result = toonLighting(lightDir, normal, viewDir, light.color, light.intensity * intensity, diffuseColor);
-        } else if (lightingModel == 2) { // Oren-Nayar
-            result = orenNayarLighting(lightDir, normal, viewDir, light.color, light.intensity * intensity, diffuseColor);
-        }
-        
-        // Затухание
-        float distance = length(light.position - fragPos);
-        float attenuation = 1.0 / (light.constant + light.linear * distance + 
-                                  light.quadratic * (distance * distance));
-        
-        return result * attenuation;
-    }
+    vec3 result = lightByModel(lightDir, normal, viewDir, colorOuterCutOff.rgb, cone, diffuseColor);
+    
+    // Затухание; последняя четверть радиуса влияния плавно гасит свет до нуля
+    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * (distance * distance));
+    attenuation *= clamp((positionRange.w - distance) / (0.25 * positionRange.w), 0.0, 1.0);
     
-    return vec3(0.0);
+    return result * attenuation;
 }
 
 void main()
@@ -309,19 +288,19 @@ void main()
     // Результат освещения
     vec3 result = ambient;
     
-    // Обработка всех точечных источников
-    for (int i = 0; i < MAX_POINT_LIGHTS; i++) {
-        result += calcPointLight(pointLights[i], norm, FragPos, viewDir, diffuseColor);
-    }
-    
     // Обработка всех направленных источников
     for (int i = 0; i < MAX_DIR_LIGHTS; i++) {
         result += calcDirectionalLight(dirLights[i], norm, viewDir, diffuseColor);
     }
     
-    // Обработка всех прожекторных источников
-    for (int i = 0; i < MAX_SPOT_LIGHTS; i++) {
-        result += calcSpotLight(spotLights[i], norm, FragPos, viewDir, diffuseColor);
+    // Точечные и прожекторы — только из кластера фрагмента
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    int slice = clamp(int(log(depth / clusterNear) * clusterSliceScale), 0, CLUSTER_SLICES - 1);
+    uvec2 cluster = texelFetch(clusterGrid, (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x).xy;
+    for (uint i = 0u; i < cluster.y; i++) {
+        int light = int(texelFetch(clusterIndices, int(cluster.x + i)).x);
+        result += calcClusterLight(light, norm, FragPos, viewDir, diffuseColor);
     }
     
     // Для Toon shading добавляем черные обводки
@@ -338,113 +317,247 @@ void main()
 )";
 
 GLuint shaderProgram = 0;
+UniformTable uniforms;   // расположения uniform'ов shaderProgram
+
+// Uniform'ы, которые задаются в кадре: хеши имён считаются при компиляции
+constexpr UniformKey UNIFORM_VIEW("view");
+constexpr UniformKey UNIFORM_PROJECTION("projection");
+constexpr UniformKey UNIFORM_VIEW_POS("viewPos");
+constexpr UniformKey UNIFORM_MODEL("model");
+constexpr UniformKey UNIFORM_NORMAL_MATRIX("normalMatrix");
+constexpr UniformKey UNIFORM_LIGHTING_MODEL("lightingModel");
+constexpr UniformKey UNIFORM_TOON_BANDS("toonBands");
+constexpr UniformKey UNIFORM_ROUGHNESS("roughness");
+constexpr UniformKey UNIFORM_SPECULAR_POWER("specularPower");
+constexpr UniformKey UNIFORM_TEXTURE("texture1");
+constexpr UniformKey UNIFORM_CLUSTER_LIGHTS("clusterLights");
+constexpr UniformKey UNIFORM_CLUSTER_GRID("clusterGrid");
+constexpr UniformKey UNIFORM_CLUSTER_INDICES("clusterIndices");
+constexpr UniformKey UNIFORM_CLUSTER_TILE_SIZE("clusterTileSize");
+constexpr UniformKey UNIFORM_CLUSTER_NEAR("clusterNear");
+constexpr UniformKey UNIFORM_CLUSTER_SLICE_SCALE("clusterSliceScale");
 std::vector<Light> lights;
 int currentLightIndex = 0;
 
+// Перспектива камеры — одна для проекции, кластеров и выбора LOD;
+// соотношение сторон берётся из текущей области вывода
+const float CAMERA_FOV_Y = glm::radians(60.0f);
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 100.0f;
+
+// Рой движущихся источников (клавиша Q): точечные и прожекторы вперемешку,
+// в списке lights их нет — положение считается в кадре
+const int SWARM_LIGHTS = 256;
+std::vector<Light> swarmLights;
+bool swarmEnabled = false;
+
 // Параметры моделей освещения
 float roughness = 0.5f;
 int toonBands = 4;
 float specularPower = 32.0f;
 
-// Функция установки источников света в шейдер
-void setupLightsInShader() {
-    glUseProgram(shaderProgram);
+// Направленные источники в uniform-блоке Lights (std140). Структуры ниже
+// повторяют раскладку блока в шейдере байт в байт: vec3 + float занимают
+// 16 байт, размер структуры кратен 16. Точка привязки общая для всех
+// программ; блок кадра пишется прямо в кольцевой буфер (FrameRingBuffer.h)
+// и привязывается glBindBufferRange на своё смещение.
+const GLuint LIGHTS_UBO_BINDING = 0;
+
+// Должно совпадать с #define в шейдере
+const int MAX_DIR_LIGHTS = 1;
 
-    std::vector<Light> pointLights;
-    std::vector<Light> dirLights;
-    std::vector<Light> spotLights;
+struct DirectionalLightStd140 {
+    glm::vec3 direction;
+    float intensity;
+    glm::vec3 color;
+    GLint enabled;
+};
+
+struct LightsBlockStd140 {
+    DirectionalLightStd140 dirLights[MAX_DIR_LIGHTS];
+};
+
+static_assert(sizeof(DirectionalLightStd140) == 32, "DirectionalLight не совпадает с std140");
+
+FrameRingBuffer lightsRing;
+
+void createLightsBuffer() {
+    lightsRing.create(GL_UNIFORM_BUFFER, sizeof(LightsBlockStd140));
+    std::cout << "Буфер источников: " << (lightsRing.persistent()
+        ? "постоянное отображение, 3 секции" : "пересоздание хранилища (GL 3.3)") << std::endl;
+}
+
+// Привязать блок Lights программы к общей точке (один раз после линковки)
+void bindLightsBlock(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "Lights");
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, blockIndex, LIGHTS_UBO_BINDING);
+    }
+}
+
+// Записать включённые направленные источники в секцию кадра: первые по
+// порядку, незанятые слоты остаются выключенными.
+// Секцию освобождает lightsRing.endFrame() после отрисовки кадра.
+void updateLightsBuffer() {
+    lightsRing.beginFrame();
+    RingAllocation allocation = lightsRing.allocate(sizeof(LightsBlockStd140), lightsRing.uniformOffsetAlignment());
+    LightsBlockStd140& block = *static_cast<LightsBlockStd140*>(allocation.data);
+    block = LightsBlockStd140();
+    int dirCount = 0;
     
     for (const auto& light : lights) {
-        if (!light.enabled) continue;
-        
-        switch (light.type) {
-            case LIGHT_POINT:
-                if (pointLights.size() < 1) pointLights.push_back(light);
-                break;
-            case LIGHT_DIRECTIONAL:
-                if (dirLights.size() < 1) dirLights.push_back(light);
-                break;
-            case LIGHT_SPOT:
-                if (spotLights.size() < 1) spotLights.push_back(light);
-                break;
+        if (!light.enabled || light.type != LIGHT_DIRECTIONAL) continue;
+        if (dirCount < MAX_DIR_LIGHTS) {
+            DirectionalLightStd140& d = block.dirLights[dirCount++];
+            d.direction = light.direction;
+            d.color = light.color;
+            d.intensity = light.intensity;
+            d.enabled = 1;
         }
     }
     
-    // Установка точечных источников
-    for (size_t i = 0; i < 1; i++) {
-        std::string base = "pointLights[" + std::to_string(i) + "].";
-        
-        if (i < pointLights.size()) {
-            const auto& light = pointLights[i];
-            
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "position").c_str()),
-                       light.position.x, light.position.y, light.position.z);
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "color").c_str()),
-                       light.color.r, light.color.g, light.color.b);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "intensity").c_str()),
-                       light.intensity);
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 1);
-            
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "constant").c_str()), 1.0f);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "linear").c_str()), 0.09f);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "quadratic").c_str()), 0.032f);
-        } else {
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 0);
-        }
+    lightsRing.flush();
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHTS_UBO_BINDING, lightsRing.id(),
+                      static_cast<GLintptr>(allocation.offset), sizeof(LightsBlockStd140));
+}
+
+// Точечные и прожекторы по кластерам (LightClusters.h): каждый кадр
+// источники переводятся в сферы влияния в координатах вида, назначаются
+// кластерам, и три списка уходят в буферные текстуры (GL 3.3 без SSBO):
+// записи источников, (смещение, число) по кластерам и номера источников.
+// Буферы пересоздаются glBufferData (orphaning) — по 2 вызова на каждый.
+const GLint CLUSTER_LIGHTS_UNIT = 1;
+const GLint CLUSTER_GRID_UNIT = 2;
+const GLint CLUSTER_INDICES_UNIT = 3;
+
+// Источник для шейдера: 3 текселя RGBA32F (см. calcClusterLight)
+struct ClusterLightRecord {
+    glm::vec3 position;
+    float range;
+    glm::vec3 color;        // цвет * яркость
+    float outerCutOff;      // косинусы углов; у точечного -3 и -2
+    glm::vec3 direction;
+    float cutOff;
+};
+
+static_assert(sizeof(ClusterLightRecord) == 48, "ClusterLightRecord — 3 текселя RGBA32F");
+
+struct TextureBuffer {
+    GLuint buffer = 0;
+    GLuint texture = 0;
+};
+
+LightClusters lightClusters;
+TextureBuffer clusterLightsBuffer, clusterGridBuffer, clusterIndicesBuffer;
+std::vector<ClusterLightRecord> clusterLightRecords;
+std::vector<glm::vec4> clusterSpheres;
+
+// Буферная текстура формата format на текстурном блоке unit (привязка постоянная)
+void createTextureBuffer(TextureBuffer& tb, GLenum format, GLint unit) {
+    glGenBuffers(1, &tb.buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, tb.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &tb.texture);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, tb.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, tb.buffer);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void uploadTextureBuffer(TextureBuffer& tb, const void* data, std::size_t bytes) {
+    glBindBuffer(GL_TEXTURE_BUFFER, tb.buffer);
+    // пустой список — всё равно не нулевой буфер
+    glBufferData(GL_TEXTURE_BUFFER, bytes ? bytes : 16, bytes ? data : nullptr, GL_STREAM_DRAW);
+}
+
+void destroyTextureBuffer(TextureBuffer& tb) {
+    glDeleteTextures(1, &tb.texture);
+    glDeleteBuffers(1, &tb.buffer);
+    tb = TextureBuffer();
+}
+
+void createClusterBuffers() {
+    createTextureBuffer(clusterLightsBuffer, GL_RGBA32F, CLUSTER_LIGHTS_UNIT);
+    createTextureBuffer(clusterGridBuffer, GL_RG32UI, CLUSTER_GRID_UNIT);
+    createTextureBuffer(clusterIndicesBuffer, GL_R32UI, CLUSTER_INDICES_UNIT);
+}
+
+// Сетка кластеров и их uniform'ы под область вывода: при старте и после
+// изменения размера окна (программа активна)
+void setClusterViewport(float viewportWidth, float viewportHeight) {
+    lightClusters.setProjection(CAMERA_FOV_Y, viewportWidth / viewportHeight, CAMERA_NEAR, CAMERA_FAR);
+    glUniform1i(uniforms[UNIFORM_CLUSTER_LIGHTS], CLUSTER_LIGHTS_UNIT);
+    glUniform1i(uniforms[UNIFORM_CLUSTER_GRID], CLUSTER_GRID_UNIT);
+    glUniform1i(uniforms[UNIFORM_CLUSTER_INDICES], CLUSTER_INDICES_UNIT);
+    glUniform2f(uniforms[UNIFORM_CLUSTER_TILE_SIZE], viewportWidth / LightClusters::TILES_X,
+                viewportHeight / LightClusters::TILES_Y);
+    glUniform1f(uniforms[UNIFORM_CLUSTER_NEAR], lightClusters.nearPlane());
+    glUniform1f(uniforms[UNIFORM_CLUSTER_SLICE_SCALE], lightClusters.sliceScale());
+}
+
+void addClusterLight(const Light& light, const glm::mat4& view) {
+    ClusterLightRecord r;
+    r.position = light.position;
+    r.range = light.range;
+    r.color = light.color * light.intensity;
+    if (light.type == LIGHT_SPOT) {
+        r.direction = glm::normalize(light.direction);
+        r.cutOff = cos(glm::radians(light.cutOff));
+        r.outerCutOff = cos(glm::radians(light.outerCutOff));
     }
-    
-    // Установка направленных источников
-    for (size_t i = 0; i < 1; i++) {
-        std::string base = "dirLights[" + std::to_string(i) + "].";
-        
-        if (i < dirLights.size()) {
-            const auto& light = dirLights[i];
-            
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "direction").c_str()),
-                       light.direction.x, light.direction.y, light.direction.z);
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "color").c_str()),
-                       light.color.r, light.color.g, light.color.b);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "intensity").c_str()),
-                       light.intensity);
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 1);
-        } else {
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 0);
-        }
+    else {
+        r.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+        r.cutOff = -2.0f;
+        r.outerCutOff = -3.0f;
     }
-    
-    // Установка прожекторных источников
-    for (size_t i = 0; i < 1; i++) {
-        std::string base = "spotLights[" + std::to_string(i) + "].";
-        
-        if (i < spotLights.size()) {
-            const auto& light = spotLights[i];
-            
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "position").c_str()),
-                       light.position.x, light.position.y, light.position.z);
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "direction").c_str()),
-                       light.direction.x, light.direction.y, light.direction.z);
-            glUniform3f(glGetUniformLocation(shaderProgram, (base + "color").c_str()),
-                       light.color.r, light.color.g, light.color.b);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "intensity").c_str()),
-                       light.intensity);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "cutOff").c_str()),
-                       cos(glm::radians(light.cutOff)));
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "outerCutOff").c_str()),
-                       cos(glm::radians(light.outerCutOff)));
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 1);
-            
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "constant").c_str()), 1.0f);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "linear").c_str()), 0.09f);
-            glUniform1f(glGetUniformLocation(shaderProgram, (base + "quadratic").c_str()), 0.032f);
-        } else {
-            glUniform1i(glGetUniformLocation(shaderProgram, (base + "enabled").c_str()), 0);
-        }
+    clusterLightRecords.push_back(r);
+    // сфера влияния прожектора берётся целиком, без учёта конуса
+    clusterSpheres.push_back(glm::vec4(glm::vec3(view * glm::vec4(light.position, 1.0f)), light.range));
+}
+
+void updateLightClusters(const glm::mat4& view) {
+    clusterLightRecords.clear();
+    clusterSpheres.clear();
+    for (const auto& light : lights) {
+        if (light.enabled && light.type != LIGHT_DIRECTIONAL) addClusterLight(light, view);
+    }
+    if (swarmEnabled) {
+        for (const auto& light : swarmLights) addClusterLight(light, view);
     }
     
-    // Установка параметров моделей освещения
-    glUniform1i(glGetUniformLocation(shaderProgram, "toonBands"), toonBands);
-    glUniform1f(glGetUniformLocation(shaderProgram, "roughness"), roughness);
-    glUniform1f(glGetUniformLocation(shaderProgram, "specularPower"), specularPower);
+    lightClusters.assign(clusterSpheres);
+    const std::vector<std::uint32_t>& grid = lightClusters.clusterGrid();
+    const std::vector<std::uint32_t>& indices = lightClusters.indices();
+    uploadTextureBuffer(clusterLightsBuffer, clusterLightRecords.data(), clusterLightRecords.size() * sizeof(ClusterLightRecord));
+    uploadTextureBuffer(clusterGridBuffer, grid.data(), grid.size() * sizeof(std::uint32_t));
+    uploadTextureBuffer(clusterIndicesBuffer, indices.data(), indices.size() * sizeof(std::uint32_t));
+}
+
+void initSwarmLights() {
+    for (int i = 0; i < SWARM_LIGHTS; ++i) {
+        Light light;
+        light.type = i % 4 == 3 ? LIGHT_SPOT : LIGHT_POINT;
+        light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+        // цвета по кругу оттенков
+        const float hue = i * 0.618034f * 6.2831853f;
+        light.color = glm::vec3(0.55f) + 0.45f * glm::vec3(std::cos(hue), std::cos(hue - 2.0943951f), std::cos(hue + 2.0943951f));
+        light.intensity = 0.6f;
+        light.cutOff = 20.0f;
+        light.outerCutOff = 30.0f;
+        light.range = 1.5f + (i % 3) * 0.75f;
+        light.name = "Рой";
+        swarmLights.push_back(light);
+    }
+}
+
+// Рой кружит вокруг сцены: радиус, высота и скорость — по номеру источника
+void animateSwarmLights(float time) {
+    for (int i = 0; i < SWARM_LIGHTS; ++i) {
+        const float angle = i * 2.3999632f + time * (0.2f + 0.1f * (i % 5));
+        const float radius = 1.0f + 6.0f * (i % 16) / 15.0f;
+        const float height = 0.3f + 3.0f * ((i * 7) % 11) / 10.0f;
+        swarmLights[i].position = glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+    }
 }
 
 // Функция инициализации источников света
@@ -507,6 +620,7 @@ void displayLightInfo(sf::Window& window, Light& light) {
         if (lights[i].type != LIGHT_DIRECTIONAL) {
             std::cout << "    Позиция: (" << lights[i].position.x << ", " 
                       << lights[i].position.y << ", " << lights[i].position.z << ")\n";
+            std::cout << "    Радиус влияния: " << lights[i].range << "\n";
         }
         
         if (lights[i].type != LIGHT_POINT) {
@@ -537,6 +651,7 @@ void displayLightInfo(sf::Window& window, Light& light) {
     std::cout << "A/D - Изменить цвет (R канал +/- 0.1)\n";
     std::cout << "Z/X - Изменить цвет (G канал +/- 0.1)\n";
     std::cout << "C/V - Изменить цвет (B канал +/- 0.1)\n";
+    std::cout << "Q - Рой из " << SWARM_LIGHTS << " движущихся источников (вкл/выкл)\n";
     
     if (lights[currentLightIndex].type != LIGHT_DIRECTIONAL) {
         std::cout << "Стрелки влево/вправо - Изменить позицию X (+/- 0.5)\n";
@@ -603,6 +718,9 @@ bool compileShaders() {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
     
+    bindLightsBlock(shaderProgram);
+    uniforms.reflect(shaderProgram);
+    
     return true;
 }
 
@@ -661,6 +779,17 @@ int main() {
     }
     
     initLights();
+    initSwarmLights();
+    createLightsBuffer();
+    
+    // Плитки кластеров — в пикселях буфера кадра (на Retina он больше окна);
+    // область вывода перечитывается после каждого изменения размера
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    createClusterBuffers();
+    glUseProgram(shaderProgram);
+    setClusterViewport(static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    installGLCallCounter();
     
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
@@ -701,11 +830,13 @@ int main() {
     {
         SceneObject obj;
         if (loadOBJ("Objects/SphereSmooth.obj", obj.mesh)) {
+            generateLODs(obj.mesh);
+            obj.mesh.quantize = true;
             obj.mesh.uploadToGPU();
             obj.textureID = textures.size() > 2 ? textures[2] : textures[0];
-            obj.position = glm::vec3(-1.0f, 3.0f, 3.0f);
-            obj.scale = glm::vec3(0.5f);
-            obj.rotation = glm::vec3(0.0f);
+            obj.transform.setPosition(glm::vec3(-1.0f, 3.0f, 3.0f));
+            obj.transform.setScale(glm::vec3(0.5f));
+            obj.transform.setRotation(glm::vec3(0.0f));
             obj.name = "Шар";
             obj.lightingModel = PHONG_MODEL;
             sceneObjects.push_back(obj);
@@ -716,11 +847,13 @@ int main() {
     {
         SceneObject obj;
         if (loadOBJ("Objects/Mickey Mouse.obj", obj.mesh)) {
+            generateLODs(obj.mesh);
+            obj.mesh.quantize = true;
             obj.mesh.uploadToGPU();
             obj.textureID = textures.size() > 3 ? textures[3] : textures[0];
-            obj.position = glm::vec3(0.0f, 0.0f, 0.0f);
-            obj.scale = glm::vec3(0.010f);
-            obj.rotation = glm::vec3(0.0f, 0.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+            obj.transform.setScale(glm::vec3(0.010f));
+            obj.transform.setRotation(glm::vec3(0.0f, 0.0f, 0.0f));
             obj.name = "Микки Маус";
             obj.lightingModel = TOON_MODEL;
             sceneObjects.push_back(obj);
@@ -739,11 +872,13 @@ int main() {
         }
         
         if (loaded) {
+            generateLODs(obj.mesh);
+            obj.mesh.quantize = true;
             obj.mesh.uploadToGPU();
             obj.textureID = textures[0];
-            obj.position = glm::vec3(3.0f, 0.5f, 2.5f);
-            obj.scale = glm::vec3(0.99f);
-            obj.rotation = glm::vec3(0.0f, 100.0f, -10.0f);
+            obj.transform.setPosition(glm::vec3(3.0f, 0.5f, 2.5f));
+            obj.transform.setScale(glm::vec3(0.99f));
+            obj.transform.setRotation(glm::vec3(0.0f, 100.0f, -10.0f));
             obj.name = "Стол";
             obj.lightingModel = OREN_NAYAR_MODEL;
             sceneObjects.push_back(obj);
@@ -754,17 +889,24 @@ int main() {
     {
         SceneObject obj;
         if (loadOBJ("Objects/utah_teapot_lowpoly.obj", obj.mesh)) {
+            generateLODs(obj.mesh);
+            obj.mesh.quantize = true;
             obj.mesh.uploadToGPU();
             obj.textureID = textures.size() > 4 ? textures[4] : textures[0];
-            obj.position = glm::vec3(4.0f, 0.5f, 0.0f);
-            obj.scale = glm::vec3(0.9f);
-            obj.rotation = glm::vec3(0.0f, 45.0f, 0.0f);
+            obj.transform.setPosition(glm::vec3(4.0f, 0.5f, 0.0f));
+            obj.transform.setScale(glm::vec3(0.9f));
+            obj.transform.setRotation(glm::vec3(0.0f, 45.0f, 0.0f));
             obj.name = "Чайник";
             obj.lightingModel = PHONG_MODEL;
             sceneObjects.push_back(obj);
         }
     }
     
+    // Вершины упакованы вдвое (VertexQuantization.h) — ошибка по моделям
+    for (const auto& obj : sceneObjects) {
+        printQuantizationReport(obj.name, obj.mesh.quantization);
+    }
+    
     sf::Clock clock;
     bool running = true;
     
@@ -776,14 +918,35 @@ int main() {
     
     bool showInfo = true;
     
+    // Вызовы GL за кадр печатаются при изменении числа. Прежний
+    // setupLightsInShader стоил 25 вызовов (49 при всех включённых
+    // источниках), updateLightsBuffer с endFrame — 4 с постоянным
+    // отображением (из них 3 на fence) и 5 с пересозданием хранилища;
+    // updateLightClusters — ещё 6 при любом числе источников;
+    // glGetUniformLocation в кадре нет
+    unsigned long lastFrameGLCalls = 0;
+    resetGLCallCounter();
+    float swarmTime = 0.0f;
+    
     while (running) {
         float deltaTime = clock.restart().asSeconds();
+        swarmTime += deltaTime;
         
         for (auto event = window.pollEvent(); event.has_value(); event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
                 running = false;
             }
             
+            // Новый размер окна: область вывода, проекция и сетка кластеров
+            if (const auto* resized = event->getIf<sf::Event::Resized>()) {
+                if (resized->size.x > 0 && resized->size.y > 0) {
+                    glViewport(0, 0, static_cast<GLsizei>(resized->size.x), static_cast<GLsizei>(resized->size.y));
+                    glGetIntegerv(GL_VIEWPORT, viewport);
+                    glUseProgram(shaderProgram);
+                    setClusterViewport(static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+                }
+            }
+            
             if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
                 Light& currentLight = lights[currentLightIndex];
                 
@@ -846,6 +1009,12 @@ int main() {
                     showInfo = true;
                 }
                 
+                // Рой источников
+                if (keyPressed->code == sf::Keyboard::Key::Q) {
+                    swarmEnabled = !swarmEnabled;
+                    std::cout << "Рой источников " << (swarmEnabled ? "включен" : "выключен") << "\n";
+                }
+                
                 // Выбор источника света
                 if (keyPressed->code == sf::Keyboard::Key::Num1) {
                     currentLightIndex = 0;
@@ -1026,13 +1195,13 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glUseProgram(shaderProgram);
         
-        setupLightsInShader();
+        updateLightsBuffer();
         
         glm::mat4 projection = glm::perspective(
-            glm::radians(60.0f),
-            1280.0f / 720.0f,
-            0.1f,
-            100.0f
+            CAMERA_FOV_Y,
+            static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]),
+            CAMERA_NEAR,
+            CAMERA_FAR
         );
         
         glm::mat4 view = glm::lookAt(
@@ -1041,64 +1210,62 @@ int main() {
             cameraUp
         );
         
-        GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-        GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        if (swarmEnabled) animateSwarmLights(swarmTime);
+        updateLightClusters(view);
         
-        GLuint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-        glUniform3f(viewPosLoc, cameraPos.x, cameraPos.y, cameraPos.z);
+        glUniformMatrix4fv(uniforms[UNIFORM_VIEW], 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(uniforms[UNIFORM_PROJECTION], 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform3f(uniforms[UNIFORM_VIEW_POS], cameraPos.x, cameraPos.y, cameraPos.z);
         
         // Рендеринг объектов с разными моделями освещения
         for (size_t i = 0; i < sceneObjects.size(); i++) {
             SceneObject& obj = sceneObjects[i];
             
             // Устанавливаем модель освещения для текущего объекта
-            GLuint lightingModelLoc = glGetUniformLocation(shaderProgram, "lightingModel");
-            glUniform1i(lightingModelLoc, obj.lightingModel);
+            glUniform1i(uniforms[UNIFORM_LIGHTING_MODEL], obj.lightingModel);
             
             // Устанавливаем параметры моделей освещения
-            GLuint toonBandsLoc = glGetUniformLocation(shaderProgram, "toonBands");
-            glUniform1i(toonBandsLoc, toonBands);
-            
-            GLuint roughnessLoc = glGetUniformLocation(shaderProgram, "roughness");
-            glUniform1f(roughnessLoc, roughness);
-            
-            GLuint specularPowerLoc = glGetUniformLocation(shaderProgram, "specularPower");
-            glUniform1f(specularPowerLoc, specularPower);
+            glUniform1i(uniforms[UNIFORM_TOON_BANDS], toonBands);
+            glUniform1f(uniforms[UNIFORM_ROUGHNESS], roughness);
+            glUniform1f(uniforms[UNIFORM_SPECULAR_POWER], specularPower);
             
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.position);
+            // Матрицы из кэша Transform: пересчитываются только после изменений
+            const glm::mat4& model = obj.transform.world();
             
-            if (obj.rotation.y != 0.0f) {
-                model = glm::rotate(model, glm::radians(obj.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            }
-            if (obj.rotation.x != 0.0f) {
-                model = glm::rotate(model, glm::radians(obj.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            }
-            if (obj.rotation.z != 0.0f) {
-                model = glm::rotate(model, glm::radians(obj.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-            }
-            
-            model = glm::scale(model, obj.scale);
-            
-            GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(uniforms[UNIFORM_MODEL], 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix3fv(uniforms[UNIFORM_NORMAL_MATRIX], 1, GL_FALSE, glm::value_ptr(obj.transform.normalMatrix()));
+            obj.mesh.setDequantizeUniforms(uniforms);
             
             if (obj.textureID != 0) {
                 glActiveTexture(GL_TEXTURE0);
                 glBindTexture(GL_TEXTURE_2D, obj.textureID);
-                glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
+                glUniform1i(uniforms[UNIFORM_TEXTURE], 0);
             }
             
-            if (obj.mesh.VAO != 0) {
-                glBindVertexArray(obj.mesh.VAO);
-                glDrawArrays(GL_TRIANGLES, 0, obj.mesh.vertices.size());
-                glBindVertexArray(0);
+            // LOD по экранной ошибке: сколько пикселей занимает единица
+            // модели на расстоянии ближайшей точки ограничивающей сферы.
+            // projection[1][1] = 1 / tan(fov / 2) — масштаб той же проекции
+            glm::vec3 worldCenter = glm::vec3(model * glm::vec4(obj.mesh.boundsCenter, 1.0f));
+            const glm::vec3& scale = obj.transform.scale();
+            float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
+            float distance = glm::length(worldCenter - cameraPos) - obj.mesh.boundsRadius * maxScale;
+            size_t lod = 0;
+            if (distance > 0.1f) {
+                float pixelsPerUnit = projection[1][1] * static_cast<float>(viewport[3]) / (2.0f * distance) * maxScale;
+                lod = selectLOD(obj.mesh, pixelsPerUnit);
             }
+            
+            obj.mesh.draw(lod);
         }
+        lightsRing.endFrame();
         
         window.display();
+        
+        if (glCallTotal() != lastFrameGLCalls) {
+            lastFrameGLCalls = glCallTotal();
+            printGLCallReport("Кадр");
+        }
+        resetGLCallCounter();
     }
     
     for (auto tex : textures) {
@@ -1108,6 +1275,10 @@ int main() {
     for (auto& obj : sceneObjects) {
         obj.mesh.cleanup();
     }
+    lightsRing.destroy();
+    destroyTextureBuffer(clusterLightsBuffer);
+    destroyTextureBuffer(clusterGridBuffer);
+    destroyTextureBuffer(clusterIndicesBuffer);
     
     if (shaderProgram != 0) {
         glDeleteProgram(shaderProgram);
@@ -1,5 +1,9 @@
 ﻿// main.cpp
 #include "Utils.h"
+#include "MeshCache.h"
+#include "AllocationCounter.h"
+#include "RenderQueue.h"
+#include "FrameRingBuffer.h"
 #include <GL/gl.h>
 #include <SFML/Window.hpp>
 #include <SFML/OpenGL.hpp>
@@ -165,10 +169,44 @@ struct Material {
     }
 };
 
+// Uniform, который задаётся в кадре без заранее сохранённого расположения
+constexpr UniformKey UNIFORM_HAS_TEXTURE("hasTexture");
+
+// ---------- Расположения uniform'ов освещения ----------
+// Разрешаются один раз после линковки программы; в кадре setupLightUniforms
+// только сравнивает с -1 — без строк и без выделений памяти.
+struct LightBindings {
+    GLint pointLightPos = -1;
+    GLint pointLightColor = -1;
+    GLint pointLightIntensity = -1;
+    GLint dirLightDir = -1;
+    GLint dirLightColor = -1;
+    GLint spotLightPos = -1;
+    GLint spotLightDir = -1;
+    GLint spotLightColor = -1;
+    GLint spotLightCutOff = -1;
+    GLint spotLightOuterCutOff = -1;
+
+    // Uniform'ы, которых нет в программе, остаются -1
+    void resolve(const UniformTable& uniforms) {
+        pointLightPos = uniforms["pointLightPos"];
+        pointLightColor = uniforms["pointLightColor"];
+        pointLightIntensity = uniforms["pointLightIntensity"];
+        dirLightDir = uniforms["dirLightDir"];
+        dirLightColor = uniforms["dirLightColor"];
+        spotLightPos = uniforms["spotLightPos"];
+        spotLightDir = uniforms["spotLightDir"];
+        spotLightColor = uniforms["spotLightColor"];
+        spotLightCutOff = uniforms["spotLightCutOff"];
+        spotLightOuterCutOff = uniforms["spotLightOuterCutOff"];
+    }
+};
+
 // ---------- Структура объекта сцены ----------
 struct SceneObject {
     Mesh mesh;
     GLuint shaderProgram;
+    UniformTable uniforms;   // расположения uniform'ов shaderProgram
     Material material;
     glm::vec3 position;
     glm::vec3 scale;
@@ -177,10 +215,7 @@ struct SceneObject {
     std::string lightingModel; // "phong", "toon", "minnaert", "oren-nayar", "cook-torrance"
     std::string name; // Имя объекта для GUI
 
-    // Uniform locations
-    GLint locModel;
-    GLint locView;
-    GLint locProj;
+    // Uniform locations (матрицы — в uniform-блоках, см. Camera и Object)
     GLint locViewPos;
     GLint locTexture;
     
@@ -191,16 +226,7 @@ struct SceneObject {
     GLint locMaterialShininess;
     
     // Light uniforms
-    GLint locPointLightPos;
-    GLint locPointLightColor;
-    GLint locPointLightIntensity;
-    GLint locDirLightDir;
-    GLint locDirLightColor;
-    GLint locSpotLightPos;
-    GLint locSpotLightDir;
-    GLint locSpotLightColor;
-    GLint locSpotLightCutOff;
-    GLint locSpotLightOuterCutOff;
+    LightBindings lightBindings;
 
     SceneObject() : shaderProgram(0) {}
     
@@ -305,7 +331,7 @@ bool loadOBJWithCheck(const std::string& filename, Mesh& mesh) {
     }
     
     std::cout << "Loading OBJ: " << filename << std::endl;
-    return loadOBJ(filename.c_str(), mesh);
+    return loadOBJCached(filename, mesh, 1, true);   // с оптимизацией под кэш вершин
 }
 
 // ---------- Вершинный шейдер (без изменений) ----------
@@ -315,9 +341,13 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 proj;
+};
+layout(std140) uniform Object {
+    mat4 model;
+};
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -347,6 +377,8 @@ std::vector<SceneObject> createSceneObjects() {
         if (loadOBJWithCheck("Objects/sphere.obj", obj.mesh)) {
             obj.mesh.uploadToGPU();
             obj.shaderProgram = createShaderProgram(vertexShaderSrc, fragmentShaderPhong);
+            obj.uniforms.reflect(obj.shaderProgram);
+            obj.lightBindings.resolve(obj.uniforms);
             obj.lightingModel = "phong";
             
             obj.material.ambient = glm::vec3(0.1f, 0.1f, 0.15f);
@@ -365,27 +397,13 @@ std::vector<SceneObject> createSceneObjects() {
             obj.scale = glm::vec3(0.5f);
             
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
-            
-            obj.locMaterialAmbient = glGetUniformLocation(obj.shaderProgram, "materialAmbient");
-            obj.locMaterialDiffuse = glGetUniformLocation(obj.shaderProgram, "materialDiffuse");
-            obj.locMaterialSpecular = glGetUniformLocation(obj.shaderProgram, "materialSpecular");
-            obj.locMaterialShininess = glGetUniformLocation(obj.shaderProgram, "materialShininess");
-            
-            obj.locPointLightPos = glGetUniformLocation(obj.shaderProgram, "pointLightPos");
-            obj.locPointLightColor = glGetUniformLocation(obj.shaderProgram, "pointLightColor");
-            obj.locPointLightIntensity = glGetUniformLocation(obj.shaderProgram, "pointLightIntensity");
-            obj.locDirLightDir = glGetUniformLocation(obj.shaderProgram, "dirLightDir");
-            obj.locDirLightColor = glGetUniformLocation(obj.shaderProgram, "dirLightColor");
-            obj.locSpotLightPos = glGetUniformLocation(obj.shaderProgram, "spotLightPos");
-            obj.locSpotLightDir = glGetUniformLocation(obj.shaderProgram, "spotLightDir");
-            obj.locSpotLightColor = glGetUniformLocation(obj.shaderProgram, "spotLightColor");
-            obj.locSpotLightCutOff = glGetUniformLocation(obj.shaderProgram, "spotLightCutOff");
-            obj.locSpotLightOuterCutOff = glGetUniformLocation(obj.shaderProgram, "spotLightOuterCutOff");
+            obj.locViewPos = obj.uniforms["viewPos"];
+            obj.locTexture = obj.uniforms["texSampler"];
+            
+            obj.locMaterialAmbient = obj.uniforms["materialAmbient"];
+            obj.locMaterialDiffuse = obj.uniforms["materialDiffuse"];
+            obj.locMaterialSpecular = obj.uniforms["materialSpecular"];
+            obj.locMaterialShininess = obj.uniforms["materialShininess"];
             
             objects.push_back(obj);
         } else {
@@ -400,6 +418,8 @@ std::vector<SceneObject> createSceneObjects() {
         if (loadOBJWithCheck("Objects/cube.obj", obj.mesh)) {
             obj.mesh.uploadToGPU();
             obj.shaderProgram = createShaderProgram(vertexShaderSrc, fragmentShaderToon);
+            obj.uniforms.reflect(obj.shaderProgram);
+            obj.lightBindings.resolve(obj.uniforms);
             obj.lightingModel = "toon";
             
             obj.material.diffuse = glm::vec3(0.8f, 0.2f, 0.2f);
@@ -410,21 +430,10 @@ std::vector<SceneObject> createSceneObjects() {
             obj.scale = glm::vec3(0.5f);
             
             // Получаем uniform locations (только необходимые для toon)
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
-            
-            obj.locMaterialDiffuse = glGetUniformLocation(obj.shaderProgram, "materialDiffuse");
-            
-            obj.locPointLightPos = glGetUniformLocation(obj.shaderProgram, "pointLightPos");
-            obj.locPointLightColor = glGetUniformLocation(obj.shaderProgram, "pointLightColor");
-            obj.locDirLightDir = glGetUniformLocation(obj.shaderProgram, "dirLightDir");
-            obj.locSpotLightPos = glGetUniformLocation(obj.shaderProgram, "spotLightPos");
-            obj.locSpotLightDir = glGetUniformLocation(obj.shaderProgram, "spotLightDir");
-            obj.locSpotLightCutOff = glGetUniformLocation(obj.shaderProgram, "spotLightCutOff");
-            obj.locSpotLightOuterCutOff = glGetUniformLocation(obj.shaderProgram, "spotLightOuterCutOff");
+            obj.locViewPos = obj.uniforms["viewPos"];
+            obj.locTexture = obj.uniforms["texSampler"];
+            
+            obj.locMaterialDiffuse = obj.uniforms["materialDiffuse"];
             
             objects.push_back(obj);
         } else {
@@ -439,6 +448,8 @@ std::vector<SceneObject> createSceneObjects() {
         if (loadOBJWithCheck("Objects/torus.obj", obj.mesh)) {
             obj.mesh.uploadToGPU();
             obj.shaderProgram = createShaderProgram(vertexShaderSrc, fragmentShaderMinnaert);
+            obj.uniforms.reflect(obj.shaderProgram);
+            obj.lightBindings.resolve(obj.uniforms);
             obj.lightingModel = "minnaert";
             
             obj.material.diffuse = glm::vec3(0.2f, 0.8f, 0.3f);
@@ -449,19 +460,10 @@ std::vector<SceneObject> createSceneObjects() {
             obj.scale = glm::vec3(0.4f);
             
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
-            
-            obj.locMaterialDiffuse = glGetUniformLocation(obj.shaderProgram, "materialDiffuse");
-            obj.locPointLightPos = glGetUniformLocation(obj.shaderProgram, "pointLightPos");
-            obj.locPointLightColor = glGetUniformLocation(obj.shaderProgram, "pointLightColor");
-            obj.locDirLightDir = glGetUniformLocation(obj.shaderProgram, "dirLightDir");
-            obj.locDirLightColor = glGetUniformLocation(obj.shaderProgram, "dirLightColor");
-            obj.locSpotLightPos = glGetUniformLocation(obj.shaderProgram, "spotLightPos");
-            obj.locSpotLightDir = glGetUniformLocation(obj.shaderProgram, "spotLightDir");
+            obj.locViewPos = obj.uniforms["viewPos"];
+            obj.locTexture = obj.uniforms["texSampler"];
+            
+            obj.locMaterialDiffuse = obj.uniforms["materialDiffuse"];
             
             objects.push_back(obj);
         } else {
@@ -476,6 +478,8 @@ std::vector<SceneObject> createSceneObjects() {
         if (loadOBJWithCheck("Objects/cylinder.obj", obj.mesh)) {
             obj.mesh.uploadToGPU();
             obj.shaderProgram = createShaderProgram(vertexShaderSrc, fragmentShaderOrenNayar);
+            obj.uniforms.reflect(obj.shaderProgram);
+            obj.lightBindings.resolve(obj.uniforms);
             obj.lightingModel = "oren-nayar";
             
             obj.material.diffuse = glm::vec3(0.8f, 0.8f, 0.2f);
@@ -486,15 +490,10 @@ std::vector<SceneObject> createSceneObjects() {
             obj.scale = glm::vec3(0.3f, 0.6f, 0.3f);
             
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
+            obj.locViewPos = obj.uniforms["viewPos"];
+            obj.locTexture = obj.uniforms["texSampler"];
             
-            obj.locMaterialDiffuse = glGetUniformLocation(obj.shaderProgram, "materialDiffuse");
-            obj.locDirLightDir = glGetUniformLocation(obj.shaderProgram, "dirLightDir");
-            obj.locDirLightColor = glGetUniformLocation(obj.shaderProgram, "dirLightColor");
+            obj.locMaterialDiffuse = obj.uniforms["materialDiffuse"];
             
             objects.push_back(obj);
         } else {
@@ -509,6 +508,8 @@ std::vector<SceneObject> createSceneObjects() {
         if (loadOBJWithCheck("Objects/cone.obj", obj.mesh)) {
             obj.mesh.uploadToGPU();
             obj.shaderProgram = createShaderProgram(vertexShaderSrc, fragmentShaderCookTorrance);
+            obj.uniforms.reflect(obj.shaderProgram);
+            obj.lightBindings.resolve(obj.uniforms);
             obj.lightingModel = "cook-torrance";
             
             obj.material.diffuse = glm::vec3(0.9f, 0.6f, 0.1f);
@@ -521,17 +522,12 @@ std::vector<SceneObject> createSceneObjects() {
             obj.scale = glm::vec3(0.4f, 0.6f, 0.4f);
             
             // Получаем uniform locations
-            obj.locModel = glGetUniformLocation(obj.shaderProgram, "model");
-            obj.locView = glGetUniformLocation(obj.shaderProgram, "view");
-            obj.locProj = glGetUniformLocation(obj.shaderProgram, "proj");
-            obj.locViewPos = glGetUniformLocation(obj.shaderProgram, "viewPos");
-            obj.locTexture = glGetUniformLocation(obj.shaderProgram, "texSampler");
-            
-            obj.locMaterialDiffuse = glGetUniformLocation(obj.shaderProgram, "materialDiffuse");
-            obj.locMaterialSpecular = glGetUniformLocation(obj.shaderProgram, "materialSpecular");
-            obj.locMaterialShininess = glGetUniformLocation(obj.shaderProgram, "materialShininess");
-            obj.locDirLightDir = glGetUniformLocation(obj.shaderProgram, "dirLightDir");
-            obj.locDirLightColor = glGetUniformLocation(obj.shaderProgram, "dirLightColor");
+            obj.locViewPos = obj.uniforms["viewPos"];
+            obj.locTexture = obj.uniforms["texSampler"];
+            
+            obj.locMaterialDiffuse = obj.uniforms["materialDiffuse"];
+            obj.locMaterialSpecular = obj.uniforms["materialSpecular"];
+            obj.locMaterialShininess = obj.uniforms["materialShininess"];
             
             objects.push_back(obj);
         } else {
@@ -638,37 +634,60 @@ public:
 };
 
 // ---------- Установка uniform переменных для освещения ----------
-void setupLightUniforms(GLuint program, 
+void setupLightUniforms(const LightBindings& locations,
                        const PointLight& pointLight,
                        const DirectionalLight& dirLight,
-                       const SpotLight& spotLight,
-                       const std::unordered_map<std::string, GLint>& locations) {
+                       const SpotLight& spotLight) {
     
     // Точечный источник
-    if (locations.count("pointLightPos"))
-        glUniform3fv(locations.at("pointLightPos"), 1, &pointLight.position[0]);
-    if (locations.count("pointLightColor"))
-        glUniform3fv(locations.at("pointLightColor"), 1, &pointLight.color[0]);
-    if (locations.count("pointLightIntensity"))
-        glUniform1f(locations.at("pointLightIntensity"), pointLight.intensity);
+    if (locations.pointLightPos != -1)
+        glUniform3fv(locations.pointLightPos, 1, &pointLight.position[0]);
+    if (locations.pointLightColor != -1)
+        glUniform3fv(locations.pointLightColor, 1, &pointLight.color[0]);
+    if (locations.pointLightIntensity != -1)
+        glUniform1f(locations.pointLightIntensity, pointLight.intensity);
     
     // Направленный источник
-    if (locations.count("dirLightDir"))
-        glUniform3fv(locations.at("dirLightDir"), 1, &dirLight.direction[0]);
-    if (locations.count("dirLightColor"))
-        glUniform3fv(locations.at("dirLightColor"), 1, &dirLight.color[0]);
+    if (locations.dirLightDir != -1)
+        glUniform3fv(locations.dirLightDir, 1, &dirLight.direction[0]);
+    if (locations.dirLightColor != -1)
+        glUniform3fv(locations.dirLightColor, 1, &dirLight.color[0]);
     
     // Прожектор
-    if (locations.count("spotLightPos"))
-        glUniform3fv(locations.at("spotLightPos"), 1, &spotLight.position[0]);
-    if (locations.count("spotLightDir"))
-        glUniform3fv(locations.at("spotLightDir"), 1, &spotLight.direction[0]);
-    if (locations.count("spotLightColor"))
-        glUniform3fv(locations.at("spotLightColor"), 1, &spotLight.color[0]);
-    if (locations.count("spotLightCutOff"))
-        glUniform1f(locations.at("spotLightCutOff"), spotLight.cutOff);
-    if (locations.count("spotLightOuterCutOff"))
-        glUniform1f(locations.at("spotLightOuterCutOff"), spotLight.outerCutOff);
+    if (locations.spotLightPos != -1)
+        glUniform3fv(locations.spotLightPos, 1, &spotLight.position[0]);
+    if (locations.spotLightDir != -1)
+        glUniform3fv(locations.spotLightDir, 1, &spotLight.direction[0]);
+    if (locations.spotLightColor != -1)
+        glUniform3fv(locations.spotLightColor, 1, &spotLight.color[0]);
+    if (locations.spotLightCutOff != -1)
+        glUniform1f(locations.spotLightCutOff, spotLight.cutOff);
+    if (locations.spotLightOuterCutOff != -1)
+        glUniform1f(locations.spotLightOuterCutOff, spotLight.outerCutOff);
+}
+
+// ---------- Матрицы в uniform-блоках ----------
+// Camera (вид и проекция) — один раз на кадр, Object (модель) — на объект.
+// Блоки кадра пишутся в кольцевой буфер (FrameRingBuffer.h) и привязываются
+// glBindBufferRange по смещению; структуры повторяют раскладку std140.
+const GLuint CAMERA_UBO_BINDING = 0;
+const GLuint OBJECT_UBO_BINDING = 1;
+
+struct CameraBlockStd140 {
+    glm::mat4 view;
+    glm::mat4 proj;
+};
+
+struct ObjectBlockStd140 {
+    glm::mat4 model;
+};
+
+// Привязать блоки программы к общим точкам (один раз после линковки)
+void bindTransformBlocks(GLuint program) {
+    GLuint camera = glGetUniformBlockIndex(program, "Camera");
+    if (camera != GL_INVALID_INDEX) glUniformBlockBinding(program, camera, CAMERA_UBO_BINDING);
+    GLuint object = glGetUniformBlockIndex(program, "Object");
+    if (object != GL_INVALID_INDEX) glUniformBlockBinding(program, object, OBJECT_UBO_BINDING);
 }
 
 // ---------- main ----------
@@ -750,6 +769,25 @@ int main() {
     float time = 0.0f;
     int frameCount = 0;
     float fps = 0.0f;
+    // Выделения кучи в отрисовке объектов прошлого кадра (только отладочная
+    // сборка, см. AllocationCounter.h); -1 — ещё не было ни одного кадра
+    long long lastFrameAllocations = -1;
+    
+    // Очередь отрисовки: объекты сортируются по программе, текстуре, VAO и
+    // глубине. Место под все объекты — заранее, чтобы кадр не выделял память.
+    const float nearPlane = 0.1f, farPlane = 100.0f;
+    RenderQueue renderQueue;
+    renderQueue.reserve(sceneObjects.size());
+    RenderStateCache renderState;
+    RenderStateStats lastRequested, lastChanged;
+    
+    // Кольцевой буфер матриц: блок камеры и по блоку на объект, каждый на
+    // своём смещении (256 байт — наибольшее выравнивание смещений UBO)
+    for (const SceneObject& obj : sceneObjects)
+        if (obj.shaderProgram) bindTransformBlocks(obj.shaderProgram);
+    FrameRingBuffer transformRing;
+    transformRing.create(GL_UNIFORM_BUFFER, (sceneObjects.size() + 1) * 256);
+    std::vector<std::size_t> objectBlockOffsets(sceneObjects.size());
     
     // Основной цикл
     while (window.isOpen()) {
@@ -795,27 +833,55 @@ int main() {
         glm::mat4 viewMat = cam.getViewMatrix();
         glm::mat4 projMat = glm::perspective(glm::radians(45.0f),
                                             (float)window.getSize().x / (float)window.getSize().y,
-                                            0.1f, 100.0f);
+                                            nearPlane, farPlane);
         
         // Рендеринг объектов
-        for (auto& obj : sceneObjects) {
+        const std::size_t allocationsBefore = allocationCount();
+        renderQueue.clear();
+        for (std::size_t i = 0; i < sceneObjects.size(); ++i) {
+            const SceneObject& obj = sceneObjects[i];
             if (obj.shaderProgram == 0) continue;
-            
-            glUseProgram(obj.shaderProgram);
-            
-            // Матрица модели
+            const bool textured = obj.locTexture != -1 && obj.material.hasTexture;
+            const float depth = -(viewMat * glm::vec4(obj.position, 1.0f)).z;
+            renderQueue.push(makeSortKey(obj.shaderProgram, textured ? obj.material.textureID : 0, obj.mesh.vao,
+                                         depth, nearPlane, farPlane), static_cast<std::uint32_t>(i));
+        }
+        renderQueue.sort();
+        
+        // Матрицы кадра — в кольцевой буфер до первого вызова отрисовки
+        transformRing.beginFrame();
+        const std::size_t uboAlignment = transformRing.uniformOffsetAlignment();
+        RingAllocation cameraBlock = transformRing.allocate(sizeof(CameraBlockStd140), uboAlignment);
+        *static_cast<CameraBlockStd140*>(cameraBlock.data) = { viewMat, projMat };
+        for (const RenderItem& item : renderQueue) {
+            const SceneObject& obj = sceneObjects[item.index];
             glm::mat4 modelMat = glm::mat4(1.0f);
             modelMat = glm::translate(modelMat, obj.position);
             modelMat = glm::rotate(modelMat, time * glm::radians(20.0f), glm::vec3(0, 1, 0));
             modelMat = glm::scale(modelMat, obj.scale);
             
-            // Базовые uniforms
-            glUniformMatrix4fv(obj.locModel, 1, GL_FALSE, &modelMat[0][0]);
-            glUniformMatrix4fv(obj.locView, 1, GL_FALSE, &viewMat[0][0]);
-            glUniformMatrix4fv(obj.locProj, 1, GL_FALSE, &projMat[0][0]);
+            RingAllocation objectBlock = transformRing.allocate(sizeof(ObjectBlockStd140), uboAlignment);
+            static_cast<ObjectBlockStd140*>(objectBlock.data)->model = modelMat;
+            objectBlockOffsets[item.index] = objectBlock.offset;
+        }
+        transformRing.flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_UBO_BINDING, transformRing.id(),
+                          static_cast<GLintptr>(cameraBlock.offset), sizeof(CameraBlockStd140));
+        
+        renderState.begin();
+        for (const RenderItem& item : renderQueue) {
+            SceneObject& obj = sceneObjects[item.index];
+            
+            // Позиция камеры и свет одни на кадр — задаём только при смене программы
+            if (renderState.useProgram(obj.shaderProgram)) {
+                if (obj.locViewPos != -1)
+                    glUniform3fv(obj.locViewPos, 1, &cam.position[0]);
+                setupLightUniforms(obj.lightBindings, pointLight, dirLight, spotLight);
+            }
             
-            if (obj.locViewPos != -1)
-                glUniform3fv(obj.locViewPos, 1, &cam.position[0]);
+            // Матрица модели — блок объекта на его смещении
+            glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UBO_BINDING, transformRing.id(),
+                              static_cast<GLintptr>(objectBlockOffsets[item.index]), sizeof(ObjectBlockStd140));
             
             // Материал
             if (obj.locMaterialAmbient != -1)
@@ -829,30 +895,35 @@ int main() {
             
             // Текстура
             if (obj.locTexture != -1 && obj.material.hasTexture) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, obj.material.textureID);
+                renderState.bindTexture(obj.material.textureID);
                 glUniform1i(obj.locTexture, 0);
-                glUniform1i(glGetUniformLocation(obj.shaderProgram, "hasTexture"), 1);
+                glUniform1i(obj.uniforms[UNIFORM_HAS_TEXTURE], 1);
             } else {
-                glUniform1i(glGetUniformLocation(obj.shaderProgram, "hasTexture"), 0);
+                glUniform1i(obj.uniforms[UNIFORM_HAS_TEXTURE], 0);
             }
             
-            // Источники света
-            std::unordered_map<std::string, GLint> lightLocs;
-            if (obj.locPointLightPos != -1) lightLocs["pointLightPos"] = obj.locPointLightPos;
-            if (obj.locPointLightColor != -1) lightLocs["pointLightColor"] = obj.locPointLightColor;
-            if (obj.locPointLightIntensity != -1) lightLocs["pointLightIntensity"] = obj.locPointLightIntensity;
-            if (obj.locDirLightDir != -1) lightLocs["dirLightDir"] = obj.locDirLightDir;
-            if (obj.locDirLightColor != -1) lightLocs["dirLightColor"] = obj.locDirLightColor;
-            if (obj.locSpotLightPos != -1) lightLocs["spotLightPos"] = obj.locSpotLightPos;
-            if (obj.locSpotLightDir != -1) lightLocs["spotLightDir"] = obj.locSpotLightDir;
-            if (obj.locSpotLightColor != -1) lightLocs["spotLightColor"] = obj.locSpotLightColor;
-            if (obj.locSpotLightCutOff != -1) lightLocs["spotLightCutOff"] = obj.locSpotLightCutOff;
-            if (obj.locSpotLightOuterCutOff != -1) lightLocs["spotLightOuterCutOff"] = obj.locSpotLightOuterCutOff;
-            
-            setupLightUniforms(obj.shaderProgram, pointLight, dirLight, spotLight, lightLocs);
-            
-            obj.mesh.draw();
+            renderState.draw(obj.mesh);
+        }
+        renderState.end();
+        transformRing.endFrame();
+        
+        // Цикл по объектам не должен трогать кучу: сообщаем о первом кадре
+        // и о каждом изменении числа выделений
+        const long long frameAllocations = static_cast<long long>(allocationCount() - allocationsBefore);
+        if (frameAllocations != lastFrameAllocations) {
+#ifndef NDEBUG
+            if (frameAllocations != 0)
+                std::cerr << "Warning: " << frameAllocations << " heap allocations while drawing objects" << std::endl;
+            else
+                std::cout << "Object draw loop: 0 heap allocations per frame" << std::endl;
+#endif
+            lastFrameAllocations = frameAllocations;
+        }
+        
+        if (renderState.requested != lastRequested || renderState.changed != lastChanged) {
+            printRenderStateReport(renderState.requested, renderState.changed);
+            lastRequested = renderState.requested;
+            lastChanged = renderState.changed;
         }
         
         // Рендеринг GUI
@@ -864,6 +935,7 @@ int main() {
     
     // Очистка
     ImGui::SFML::Shutdown();
+    transformRing.destroy();
     
     for (auto& obj : sceneObjects) {
         if (obj.material.hasTexture)